@@ -1,11 +1,150 @@
 #include "Mesh.h"
 
 #include <tiny_obj_loader.h>
+#include <glm/glm.hpp>
 
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <limits>
 #include <unordered_map>
 
+#include "MeshOptimizer.h"
+
+#include "../Vulkan/Telemetry.h"
+
 namespace Assets
 {
+	namespace
+	{
+		constexpr int BINS = 16;
+
+		struct Bounds
+		{
+			glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+			glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+			void Grow(const glm::vec3& point)
+			{
+				min = glm::min(min, point);
+				max = glm::max(max, point);
+			}
+
+			void Grow(const Bounds& bounds)
+			{
+				min = glm::min(min, bounds.min);
+				max = glm::max(max, bounds.max);
+			}
+
+			[[nodiscard]] float Area() const
+			{
+				const glm::vec3 extent = max - min;
+				return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+			}
+		};
+
+		struct Triangle
+		{
+			Bounds bounds;
+			glm::vec3 centroid;
+			uint32_t index;
+		};
+
+		using Iterator = std::vector<Triangle>::iterator;
+
+		Iterator MedianSplit(Iterator begin, Iterator end, int axis)
+		{
+			const auto middle = begin + (end - begin) / 2;
+
+			std::nth_element(begin, middle, end, [axis](const Triangle& a, const Triangle& b)
+			{
+				return a.centroid[axis] < b.centroid[axis];
+			});
+
+			return middle;
+		}
+
+		/*
+		 * Binned SAH split on triangle centroids along the widest centroid axis.
+		 * Falls back to the median split when all centroids fall into a single bin.
+		 */
+		Iterator SAHSplit(Iterator begin, Iterator end)
+		{
+			Bounds centroids;
+
+			for (auto it = begin; it != end; ++it)
+				centroids.Grow(it->centroid);
+
+			const glm::vec3 extent = centroids.max - centroids.min;
+			const int axis = extent.x > extent.y && extent.x > extent.z ? 0 : extent.y > extent.z ? 1 : 2;
+
+			if (extent[axis] <= 0.f)
+				return MedianSplit(begin, end, axis);
+
+			const float scale = BINS / extent[axis];
+			const float origin = centroids.min[axis];
+
+			auto binOf = [=](const Triangle& triangle)
+			{
+				return std::min(BINS - 1, static_cast<int>((triangle.centroid[axis] - origin) * scale));
+			};
+
+			std::array<Bounds, BINS> bins{};
+			std::array<uint32_t, BINS> counts{};
+
+			for (auto it = begin; it != end; ++it)
+			{
+				const int bin = binOf(*it);
+				bins[bin].Grow(it->bounds);
+				++counts[bin];
+			}
+
+			std::array<float, BINS> leftCosts{};
+			std::array<uint32_t, BINS> leftCounts{};
+
+			Bounds left;
+			uint32_t leftCount = 0;
+
+			for (int i = 0; i < BINS - 1; ++i)
+			{
+				left.Grow(bins[i]);
+				leftCount += counts[i];
+				leftCounts[i] = leftCount;
+				leftCosts[i] = leftCount > 0 ? left.Area() * leftCount : 0.f;
+			}
+
+			Bounds right;
+			uint32_t rightCount = 0;
+			float bestCost = std::numeric_limits<float>::max();
+			int bestBin = -1;
+
+			for (int i = BINS - 1; i > 0; --i)
+			{
+				right.Grow(bins[i]);
+				rightCount += counts[i];
+
+				if (rightCount == 0 || leftCounts[i - 1] == 0)
+					continue;
+
+				const float cost = leftCosts[i - 1] + right.Area() * rightCount;
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestBin = i;
+				}
+			}
+
+			if (bestBin < 0)
+				return MedianSplit(begin, end, axis);
+
+			return std::partition(begin, end, [&](const Triangle& triangle)
+			{
+				return binOf(triangle) < bestBin;
+			});
+		}
+	}
+
 	Mesh::Mesh(const std::string& path)
 	{
 		loader = std::async(std::launch::async, [this, path]()
@@ -14,12 +153,146 @@ namespace Assets
 		});
 	}
 
+	Mesh::~Mesh()
+	{
+		// The loader might still be writing the mesh
+		if (loader.valid())
+			loader.wait();
+
+		if (hostBytes > 0)
+			Vulkan::Telemetry::Get().Remove(Vulkan::MemoryCategory::HostMeshes, hostBytes);
+	}
+
 	void Mesh::Wait()
 	{
 		if (loader.valid())
 			loader.get();
 	}
 
+	/*
+	 * Partitions the triangles of a huge mesh into spatially coherent clusters of at most
+	 * maxTriangles triangles. The index buffer is reordered so every cluster is contiguous,
+	 * thus each cluster can be built as a separate BLAS with tighter bounds.
+	 */
+	void Mesh::Split(uint32_t maxTriangles)
+	{
+		const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+		if (maxTriangles == 0 || triangleCount <= maxTriangles)
+			return;
+
+		std::vector<Triangle> triangles(triangleCount);
+
+		for (uint32_t i = 0; i < triangleCount; ++i)
+		{
+			auto& triangle = triangles[i];
+			triangle.index = i;
+
+			for (uint32_t k = 0; k < 3; ++k)
+				triangle.bounds.Grow(vertices[indices[i * 3 + k]].position);
+
+			triangle.centroid = (triangle.bounds.min + triangle.bounds.max) * 0.5f;
+		}
+
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+		std::vector<std::pair<uint32_t, uint32_t>> stack = { { 0, triangleCount } };
+
+		while (!stack.empty())
+		{
+			const auto [first, last] = stack.back();
+			stack.pop_back();
+
+			if (last - first <= maxTriangles)
+			{
+				ranges.emplace_back(first, last);
+				continue;
+			}
+
+			const auto begin = triangles.begin();
+			auto middle = static_cast<uint32_t>(SAHSplit(begin + first, begin + last) - begin);
+
+			if (middle == first || middle == last)
+				middle = static_cast<uint32_t>(MedianSplit(begin + first, begin + last, 0) - begin);
+
+			// Right first so that clusters are emitted in index order
+			stack.emplace_back(middle, last);
+			stack.emplace_back(first, middle);
+		}
+
+		std::vector<uint32_t> reordered;
+		reordered.reserve(indices.size());
+		clusters.clear();
+
+		for (const auto& [first, last] : ranges)
+		{
+			clusters.push_back({ static_cast<uint32_t>(reordered.size()), (last - first) * 3 });
+
+			for (auto i = first; i < last; ++i)
+			{
+				const auto index = triangles[i].index;
+				reordered.insert(reordered.end(), indices.begin() + index * 3, indices.begin() + index * 3 + 3);
+			}
+		}
+
+		indices = std::move(reordered);
+
+		std::cout << "[MESH] " << triangleCount << " triangles have been split into " << clusters.size() <<
+			" clusters." << std::endl;
+	}
+
+	/*
+	 * Improves the vertex fetch locality, the cluster ranges are preserved.
+	 * Triangles of every cluster are reordered for the post-transform cache and optionally sorted
+	 * in spatially coherent meshlets, then vertices are renumbered by their first use.
+	 */
+	void Mesh::Optimize(uint32_t meshletSize)
+	{
+		constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+		const float before = MeshOptimizer::AverageCacheMissRatio(indices, vertices.size());
+
+		std::vector<uint32_t> remap(vertices.size(), INVALID);
+		std::vector<uint32_t> local;
+		std::vector<uint32_t> global;
+
+		for (const auto& cluster : clusters)
+		{
+			// Tipsify works on a compact vertex range, thus the cluster is renumbered locally
+			local.resize(cluster.indexCount);
+			global.clear();
+
+			for (uint32_t i = 0; i < cluster.indexCount; ++i)
+			{
+				const uint32_t index = indices[cluster.firstIndex + i];
+
+				if (remap[index] == INVALID)
+				{
+					remap[index] = static_cast<uint32_t>(global.size());
+					global.push_back(index);
+				}
+
+				local[i] = remap[index];
+			}
+
+			MeshOptimizer::OptimizeVertexCache(local, global.size());
+
+			for (uint32_t i = 0; i < cluster.indexCount; ++i)
+				indices[cluster.firstIndex + i] = global[local[i]];
+
+			for (const auto index : global)
+				remap[index] = INVALID;
+
+			MeshOptimizer::SortMeshlets(indices.data() + cluster.firstIndex, cluster.indexCount, vertices,
+			                            meshletSize);
+		}
+
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		const float after = MeshOptimizer::AverageCacheMissRatio(indices, vertices.size());
+
+		std::cout << "[MESH] Average cache miss ratio " << before << " -> " << after << std::endl;
+	}
+
 	void Mesh::Load(const std::string& path)
 	{
 		tinyobj::attrib_t attrib;
@@ -72,5 +345,14 @@ namespace Assets
 				indices.push_back(uniqueVertices[vertex]);
 			}
 		}
+
+		clusters = { { 0, static_cast<uint32_t>(indices.size()) } };
+
+		// 0xFFFF is kept free as it is the primitive restart value of 16-bit indices
+		if (vertices.size() < std::numeric_limits<uint16_t>::max())
+			indexStride = sizeof(uint16_t);
+
+		hostBytes = vertices.size() * sizeof(vertices[0]) + indices.size() * sizeof(indices[0]);
+		Vulkan::Telemetry::Get().Add(Vulkan::MemoryCategory::HostMeshes, hostBytes);
 	}
 }
@@ -8,14 +8,26 @@
 
 namespace Assets
 {
+	/*
+	 * Contiguous range of the mesh index buffer built as a separate BLAS.
+	 */
+	struct Cluster
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
 	class Mesh
 	{
 	public:
 		Mesh(const std::string& path);
+		~Mesh();
 
 		void Wait();
+		void Split(uint32_t maxTriangles);
+		void Optimize(uint32_t meshletSize);
 		
-		[[nodiscard]] std::vector<Geometry::Vertex>& GetVertices()
+		[[nodiscard]] const std::vector<Geometry::Vertex>& GetVertices() const
 		{
 			return vertices;
 		}
@@ -35,10 +47,32 @@ namespace Assets
 			return indices.size();
 		}
 
+		[[nodiscard]] const std::vector<Cluster>& GetClusters() const
+		{
+			return clusters;
+		}
+
+		/*
+		 * Size in bytes of an index on the GPU, meshes with less than 65535 vertices use 16-bit indices
+		 */
+		[[nodiscard]] uint32_t GetIndexStride() const
+		{
+			return indexStride;
+		}
+
+		[[nodiscard]] VkIndexType GetIndexType() const
+		{
+			return indexStride == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		}
+
 	private:
 		std::vector<Geometry::Vertex> vertices;
 		std::vector<uint32_t> indices;
+		std::vector<Cluster> clusters;
+		uint32_t indexStride = sizeof(uint32_t);
 		std::future<void> loader{};
+		// Bytes reported to the telemetry as host copies
+		uint64_t hostBytes{};
 		
 		void Load(const std::string& path);
 	};
@@ -54,5 +88,7 @@ namespace Assets
 		glm::mat4 modelTransform = glm::mat4(1.f);
 		int materialId;
 		int meshId;
+		// Edited interactively, its BLAS prefers a fast build
+		bool dynamic = false;
 	};
 }
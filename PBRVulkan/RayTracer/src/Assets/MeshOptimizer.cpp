@@ -0,0 +1,245 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace Assets
+{
+	namespace MeshOptimizer
+	{
+		namespace
+		{
+			constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+			/*
+			 * Spreads the lower 10 bits of the value to every third bit
+			 */
+			uint32_t Part1By2(uint32_t value)
+			{
+				value &= 0x000003ff;
+				value = (value ^ (value << 16)) & 0xff0000ff;
+				value = (value ^ (value << 8)) & 0x0300f00f;
+				value = (value ^ (value << 4)) & 0x030c30c3;
+				value = (value ^ (value << 2)) & 0x09249249;
+				return value;
+			}
+
+			uint32_t Morton(uint32_t x, uint32_t y, uint32_t z)
+			{
+				return Part1By2(x) | Part1By2(y) << 1 | Part1By2(z) << 2;
+			}
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			const size_t triangleCount = indices.size() / 3;
+
+			if (triangleCount == 0)
+				return;
+
+			// Vertex to triangles adjacency stored as one array with per vertex offsets
+			std::vector<uint32_t> liveTriangles(vertexCount, 0);
+
+			for (const auto index : indices)
+				++liveTriangles[index];
+
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+			std::partial_sum(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+
+			std::vector<uint32_t> adjacency(indices.size());
+			std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (size_t i = 0; i < indices.size(); ++i)
+				adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			std::vector<bool> emitted(triangleCount, false);
+			std::vector<uint32_t> deadEnds;
+			std::vector<uint32_t> candidates;
+			std::vector<uint32_t> output;
+			output.reserve(indices.size());
+
+			uint32_t time = cacheSize + 1;
+			size_t nextVertex = 0;
+			uint32_t fanning = indices[0];
+
+			while (fanning != INVALID)
+			{
+				candidates.clear();
+
+				// Emit all remaining triangles around the fanning vertex
+				for (auto a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a)
+				{
+					const uint32_t triangle = adjacency[a];
+
+					if (emitted[triangle])
+						continue;
+
+					emitted[triangle] = true;
+
+					for (uint32_t k = 0; k < 3; ++k)
+					{
+						const uint32_t vertex = indices[triangle * 3 + k];
+
+						output.push_back(vertex);
+						deadEnds.push_back(vertex);
+						candidates.push_back(vertex);
+						--liveTriangles[vertex];
+
+						if (time - timestamps[vertex] > cacheSize)
+							timestamps[vertex] = time++;
+					}
+				}
+
+				// The next fanning vertex is the oldest candidate which stays in the cache while it is fanned
+				fanning = INVALID;
+				int64_t bestPriority = -1;
+
+				for (const auto vertex : candidates)
+				{
+					if (liveTriangles[vertex] == 0)
+						continue;
+
+					int64_t priority = 0;
+
+					if (time - timestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+						priority = time - timestamps[vertex];
+
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						fanning = vertex;
+					}
+				}
+
+				// Dead end, continue with the recently used vertices and then in the input order
+				while (fanning == INVALID && !deadEnds.empty())
+				{
+					const uint32_t vertex = deadEnds.back();
+					deadEnds.pop_back();
+
+					if (liveTriangles[vertex] > 0)
+						fanning = vertex;
+				}
+
+				for (; fanning == INVALID && nextVertex < vertexCount; ++nextVertex)
+				{
+					if (liveTriangles[nextVertex] > 0)
+						fanning = static_cast<uint32_t>(nextVertex);
+				}
+			}
+
+			indices = std::move(output);
+		}
+
+		void SortMeshlets(uint32_t* indices, size_t indexCount, const std::vector<Geometry::Vertex>& vertices,
+		                  uint32_t meshletSize)
+		{
+			const size_t triangleCount = indexCount / 3;
+
+			if (meshletSize == 0 || triangleCount <= meshletSize)
+				return;
+
+			const size_t meshletCount = (triangleCount + meshletSize - 1) / meshletSize;
+			std::vector<glm::vec3> centroids(meshletCount, glm::vec3(0.f));
+
+			glm::vec3 min(std::numeric_limits<float>::max());
+			glm::vec3 max(-std::numeric_limits<float>::max());
+
+			for (size_t meshlet = 0; meshlet < meshletCount; ++meshlet)
+			{
+				const size_t first = meshlet * meshletSize * 3;
+				const size_t last = std::min(indexCount, first + meshletSize * 3);
+
+				for (size_t i = first; i < last; ++i)
+					centroids[meshlet] = centroids[meshlet] + vertices[indices[i]].position;
+
+				centroids[meshlet] = centroids[meshlet] * (1.f / static_cast<float>(last - first));
+				min = glm::min(min, centroids[meshlet]);
+				max = glm::max(max, centroids[meshlet]);
+			}
+
+			std::vector<uint32_t> codes(meshletCount);
+
+			for (size_t meshlet = 0; meshlet < meshletCount; ++meshlet)
+			{
+				uint32_t cell[3];
+
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float extent = max[axis] - min[axis];
+					const float t = extent > 0.f ? (centroids[meshlet][axis] - min[axis]) / extent : 0.f;
+					cell[axis] = std::min(1023u, static_cast<uint32_t>(t * 1024.f));
+				}
+
+				codes[meshlet] = Morton(cell[0], cell[1], cell[2]);
+			}
+
+			std::vector<uint32_t> order(meshletCount);
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&codes](uint32_t a, uint32_t b)
+			{
+				return codes[a] < codes[b];
+			});
+
+			std::vector<uint32_t> sorted;
+			sorted.reserve(indexCount);
+
+			for (const auto meshlet : order)
+			{
+				const size_t first = meshlet * meshletSize * 3;
+				const size_t last = std::min(indexCount, first + meshletSize * 3);
+				sorted.insert(sorted.end(), indices + first, indices + last);
+			}
+
+			std::copy(sorted.begin(), sorted.end(), indices);
+		}
+
+		void OptimizeVertexFetch(std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			std::vector<uint32_t> remap(vertices.size(), INVALID);
+			std::vector<Geometry::Vertex> reordered;
+			reordered.reserve(vertices.size());
+
+			for (auto& index : indices)
+			{
+				auto& id = remap[index];
+
+				if (id == INVALID)
+				{
+					id = static_cast<uint32_t>(reordered.size());
+					reordered.push_back(vertices[index]);
+				}
+
+				index = id;
+			}
+
+			vertices = std::move(reordered);
+		}
+
+		float AverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			const size_t triangleCount = indices.size() / 3;
+
+			if (triangleCount == 0)
+				return 0.f;
+
+			// A vertex is cached while less than cacheSize other vertices have been transformed after it
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			uint32_t time = cacheSize + 1;
+			size_t misses = 0;
+
+			for (const auto index : indices)
+			{
+				if (time - timestamps[index] > cacheSize)
+				{
+					timestamps[index] = time++;
+					++misses;
+				}
+			}
+
+			return static_cast<float>(misses) / static_cast<float>(triangleCount);
+		}
+	}
+}
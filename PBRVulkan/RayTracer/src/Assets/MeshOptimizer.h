@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Geometry/Vertex.h"
+
+namespace Assets
+{
+	/*
+	 * Reordering passes which improve the locality of the vertex fetches
+	 * in the rasterizer and in the hit shader. They run on the asset loader threads.
+	 */
+	namespace MeshOptimizer
+	{
+		// Size of the modelled post-transform FIFO cache
+		constexpr uint32_t CACHE_SIZE = 16;
+
+		/*
+		 * Reorders triangles for the post-transform cache (Tipsify, Sander et al. 2007).
+		 * Indices have to be in the [0, vertexCount) range.
+		 */
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+		                         uint32_t cacheSize = CACHE_SIZE);
+
+		/*
+		 * Sorts groups of meshletSize consecutive triangles along a Morton curve of their centroids
+		 */
+		void SortMeshlets(uint32_t* indices, size_t indexCount, const std::vector<Geometry::Vertex>& vertices,
+		                  uint32_t meshletSize);
+
+		/*
+		 * Renumbers vertices by their first use in the index buffer, unused vertices are dropped
+		 */
+		void OptimizeVertexFetch(std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		/*
+		 * Average number of transformed vertices per triangle with a FIFO cache
+		 */
+		[[nodiscard]] float AverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount,
+		                                          uint32_t cacheSize = CACHE_SIZE);
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Assets
+{
+	enum PrimitiveType
+	{
+		SpherePrimitive,
+		DiskPrimitive,
+		QuadPrimitive
+	};
+
+	/*
+	 * Analytic primitive intersected by Procedural.rint
+	 * For reference check Structs.glsl
+	 */
+	struct Primitive final
+	{
+		alignas(16) glm::vec3 position{};
+		alignas(16) glm::vec3 normal{};
+		alignas(16) glm::vec3 u{};
+		alignas(16) glm::vec3 v{};
+		glm::float32_t radius{};
+		glm::int32_t type{};
+		glm::int32_t materialId{};
+	};
+}
@@ -24,7 +24,7 @@ vec3 directLight(in Material material)
 		isShadowed = true;
 
 		// Shadow ray (payload 1 is Shadow.miss)
-		traceRayEXT(TLAS, flags, 0xFF, 0, 0, 1, surfacePos, tMin, lightDir, tMax, 1);
+		traceRayEXT(TLAS, flags, GEOMETRY_MASK, 0, 0, 1, surfacePos, tMin, lightDir, tMax, 1);
 
 		if (!isShadowed)
 		{
@@ -63,7 +63,7 @@ vec3 directLight(in Material material)
 			return L;
 
 		// Shadow ray (payload 1 is Shadow.miss)
-		traceRayEXT(TLAS, flags, 0xFF, 0, 0, 1, surfacePos, tMin, lightDir, lightDist, 1);
+		traceRayEXT(TLAS, flags, GEOMETRY_MASK, 0, 0, 1, surfacePos, tMin, lightDir, lightDist, 1);
 		
 		if (!isShadowed)
 		{
@@ -18,6 +18,19 @@ vec2 mix(vec2 a, vec2 b, vec2 c, vec3 barycentrics)
 	return a * barycentrics.x + b * barycentrics.y + c * barycentrics.z;
 }
 
+/*
+ * Decodes an octahedral encoded unit vector, see PackedVertex::OctahedralEncode
+ */
+vec3 octahedralDecode(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+
+	return normalize(n);
+}
+
  /*
   * Encode color from HDR space to LDR. Tone mapping.
   */
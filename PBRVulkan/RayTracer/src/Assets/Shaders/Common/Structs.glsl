@@ -11,6 +11,13 @@
 #define INFINITY  1000000.0
 #define MINIMUM   0.00001
 
+// Luma weights, see toneMap in Math.glsl
+#define LUMINANCE vec3(0.299, 0.587, 0.114)
+
+// Instance masks of the TLAS, see TLAS.h
+#define GEOMETRY_MASK 0x01
+#define LIGHTS_MASK   0x02
+
 // See Random.glsl for more details
 uint seed = 0;
 
@@ -18,6 +25,11 @@ uint seed = 0;
 int AREA_LIGHT = 0;
 int SPHERE_LIGHT = 1;
 
+// Analytic primitives types
+int SPHERE_PRIMITIVE = 0;
+int DISK_PRIMITIVE = 1;
+int QUAD_PRIMITIVE = 2;
+
 // Integrators types
 int PATH_TRACER_DEFAULT = 0;
 int PATH_TRACER_MSM = 1;
@@ -66,6 +78,17 @@ struct Light
 	float radius;
 };
 
+struct Primitive
+{
+	vec3 position;
+	vec3 normal;
+	vec3 u;
+	vec3 v;
+	float radius;
+	int type;
+	int materialId;
+};
+
 struct Uniform
 {
 	mat4 view;
@@ -81,7 +104,18 @@ struct Uniform
 	float hdrMultiplier;
 	float hdrResolution;
 	float AORayLength;
+	float denoiserStrength;
 	int integratorType;
+	uint sampleOffset;
+};
+
+// Layout of VkTraceRaysIndirectCommandKHR, see AdaptiveSampler.h
+struct PixelListHeader
+{
+	uint width;
+	uint height;
+	uint depth;
+	uint padding;
 };
 
 struct ComputeUniform
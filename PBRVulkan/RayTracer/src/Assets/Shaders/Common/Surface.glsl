@@ -0,0 +1,34 @@
+/*
+ * Surface properties evaluated at the hit point
+ */
+
+/*
+ * Updates the material properties and the shading normal using textures
+ */
+void applyTextures(inout Material material, in vec2 texCoord, inout vec3 normal, inout vec3 ffnormal)
+{
+	// Albedo
+	if (material.albedoTexID >= 0)
+	{
+		material.albedo.xyz *= texture(TextureSamplers[material.albedoTexID], texCoord).xyz;
+	}
+
+	// Metallic and Roughness
+	if (material.metallicRoughnessTexID >= 0)
+	{
+		vec2 metallicRoughness = texture(TextureSamplers[material.metallicRoughnessTexID], texCoord).zy;
+		material.metallic = metallicRoughness.x;
+		material.roughness = metallicRoughness.y;
+	}
+
+	// Normal map
+	if (material.normalmapTexID >= 0)
+	{
+		// Orthonormal Basis
+		mat3 frame = localFrame(ffnormal);
+		vec3 nrm = texture(TextureSamplers[material.normalmapTexID], texCoord).xyz;
+		nrm = frame * normalize(nrm * 2.0 - 1.0);
+		normal = normalize(nrm);
+		ffnormal = dot(normal, gl_WorldRayDirectionEXT) <= 0.0 ? normal : normal * -1.0;
+	}
+}
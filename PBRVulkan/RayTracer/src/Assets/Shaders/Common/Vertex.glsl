@@ -1,6 +1,6 @@
 /*
  * General vertex structure
- * For reference check Geometry/Vertex.h files
+ * For reference check Geometry/Vertex.h files (PackedVertex)
  */
 
 struct Vertex
@@ -8,20 +8,30 @@ struct Vertex
 	vec3 position;
 	vec3 normal;
 	vec2 texCoord;
-	int materialIndex;
 };
 
 Vertex unpack(uint index)
 {
-	const uint vertexSize = 9;
+	const uint vertexSize = 5;
 	const uint offset = index * vertexSize;
 	
 	Vertex vertex;
 	
-	vertex.position = vec3(Vertices[offset + 0], Vertices[offset + 1], Vertices[offset + 2]);
-	vertex.normal = vec3(Vertices[offset + 3], Vertices[offset + 4], Vertices[offset + 5]);
-	vertex.texCoord = vec2(Vertices[offset + 6], Vertices[offset + 7]);
-	vertex.materialIndex = floatBitsToInt(Vertices[offset + 8]);
+	vertex.position = uintBitsToFloat(uvec3(Vertices[offset + 0], Vertices[offset + 1], Vertices[offset + 2]));
+	vertex.normal = octahedralDecode(unpackSnorm2x16(Vertices[offset + 3]));
+	vertex.texCoord = unpackHalf2x16(Vertices[offset + 4]);
 
 	return vertex;
 }
+
+/*
+ * Fetches an index of the given width (2 or 4 bytes) from the shared index buffer,
+ * position is counted in indices of that width. For reference check Tracer/Scene.cpp
+ */
+uint fetchIndex(uint position, uint stride)
+{
+	if (stride == 2)
+		return (Indices[position >> 1] >> ((position & 1) * 16)) & 0xFFFF;
+
+	return Indices[position];
+}
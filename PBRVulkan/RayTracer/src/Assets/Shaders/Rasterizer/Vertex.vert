@@ -6,11 +6,14 @@
 #include "../Common/Structs.glsl"
 
 layout(binding = 0) readonly uniform UniformBufferObject { Uniform ubo; };
+layout(binding = 4) readonly buffer OffsetArray { uvec4[] Offsets; };
+
+#include "../Common/Random.glsl"
+#include "../Common/Math.glsl"
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
+layout(location = 1) in vec2 inNormal; // octahedral
 layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in int inMaterialId;
 
 layout(location = 0) out vec2 outTexCoord;
 layout(location = 1) out vec3 outNormal;
@@ -22,7 +25,8 @@ void main()
 	gl_Position = ubo.proj * ubo.view * vec4(inPosition, 1.f);
 
 	outPosition = inPosition;
-	outNormal = inNormal;
+	outNormal = octahedralDecode(inNormal);
 	outTexCoord = inTexCoord;
-	outMaterialId = inMaterialId;
+	// firstInstance of the draw points to the offsets of the mesh instance
+	outMaterialId = int(Offsets[gl_InstanceIndex].z);
 }
\ No newline at end of file
@@ -27,7 +27,7 @@
 		isShadowed = true;
 
 		// Shadow ray (payload 1 is Shadow.miss)
-		traceRayEXT(TLAS, flags, 0xFF, 0, 0, 1, worldPos, tMin, dir, tMax, 1);
+		traceRayEXT(TLAS, flags, GEOMETRY_MASK, 0, 0, 1, worldPos, tMin, dir, tMax, 1);
 
 		if (isShadowed)
 		{
@@ -13,21 +13,10 @@
  */
 {
 	BsdfSample bsdfSample;
-	LightSample lightSample;	
 
+	// Analytic lights are hit through the TLAS, see Light.rchit
 	payload.radiance += material.emission.xyz * payload.beta;
 
-	if (interesetsEmitter(lightSample, gl_HitTEXT))
-	{
-		vec3 Le = sampleEmitter(lightSample, payload.bsdf);
-
-		if (ubo.doubleSidedLight || dot(payload.ffnormal, lightSample.normal) > 0.f)
-			payload.radiance += Le * payload.beta;
-
-		payload.stop = true;
-		return;
-	}
-
 	payload.beta *= exp(-payload.absorption * gl_HitTEXT);
 	payload.radiance += directLight(material) * payload.beta;
 
@@ -4,6 +4,7 @@
 #include <stb_image.h>
 
 #include "../3rdParty/HDRLoader.h"
+#include "../Vulkan/Telemetry.h"
 
 namespace Assets
 {
@@ -13,6 +14,8 @@ namespace Assets
 	Texture::Texture(): texWidth(32), texHeight(32), texChannels(4), imageSize(texHeight * texWidth * texChannels)
 	{
 		pixels = new unsigned char[texHeight * texWidth * texChannels];
+		hostBytes = imageSize;
+		Vulkan::Telemetry::Get().Add(Vulkan::MemoryCategory::HostTextures, hostBytes);
 	}
 
 	Texture::Texture(int width, int height, int channel, void* pixels)
@@ -31,6 +34,9 @@ namespace Assets
 			{
 				throw std::runtime_error("Failed to load texture image!");
 			}
+
+			hostBytes = imageSize;
+			Vulkan::Telemetry::Get().Add(Vulkan::MemoryCategory::HostTextures, hostBytes);
 		});
 	}
 
@@ -42,8 +48,10 @@ namespace Assets
 		texChannels = texture.texChannels;
 		imageSize = texture.imageSize;
 		pixels = texture.pixels;
+		hostBytes = texture.hostBytes;
 
 		texture.pixels = nullptr;
+		texture.hostBytes = 0;
 	}
 
 	Texture& Texture::operator=(Texture&& texture) noexcept
@@ -56,8 +64,10 @@ namespace Assets
 			texChannels = texture.texChannels;
 			imageSize = texture.imageSize;
 			pixels = texture.pixels;
+			hostBytes = texture.hostBytes;
 
 			texture.pixels = nullptr;
+			texture.hostBytes = 0;
 		}
 
 		return *this;
@@ -65,6 +75,9 @@ namespace Assets
 
 	Texture::~Texture()
 	{
+		if (hostBytes > 0)
+			Vulkan::Telemetry::Get().Remove(Vulkan::MemoryCategory::HostTextures, hostBytes);
+
 		if (pixels != nullptr && !isHDR)
 		{
 			stbi_image_free(pixels);
@@ -58,5 +58,7 @@ namespace Assets
 		int texHeight{};
 		int texChannels{};
 		int imageSize;
+		// Bytes reported to the telemetry as host copies, wrapped pixels are not owned
+		uint64_t hostBytes{};
 	};
 }
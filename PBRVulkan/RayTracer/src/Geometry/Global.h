@@ -24,5 +24,8 @@ namespace Uniforms
 		glm::float32_t AORayLength{};
 		glm::float32_t denoiserStrength{};
 		glm::int32_t integratorType{};
+
+		// Added to the sample index of the random seeds, distributed workers trace disjoint sample ranges
+		glm::uint32_t sampleOffset{};
 	};
 }
@@ -2,63 +2,105 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <array>
+#include <cmath>
 #include "../Vulkan/Vulkan_api.h"
 
 namespace Geometry
 {
+	/*
+	 * Vertex as it is loaded from a model file, used for deduplication and transformations on the host.
+	 */
 	struct Vertex final
 	{
 		glm::vec3 position;
 		glm::vec3 normal;
 		glm::vec2 texCoords;
-		int32_t materialId;
+
+		bool operator==(const Vertex& other) const
+		{
+			return position == other.position &&
+				normal == other.normal &&
+				texCoords == other.texCoords;
+		}
+	};
+
+	/*
+	 * Compact 20 bytes vertex uploaded to the GPU.
+	 * Positions keep full precision as they are the AS build input, normals are octahedral snorm16x2
+	 * and texture coordinates are half floats. The material id lives in the per-instance offsets.
+	 * For reference check Common/Vertex.glsl
+	 */
+	struct PackedVertex final
+	{
+		glm::vec3 position;
+		uint32_t normal;
+		uint32_t texCoords;
+
+		static PackedVertex Pack(const Vertex& vertex)
+		{
+			PackedVertex packed{};
+			packed.position = vertex.position;
+			packed.normal = glm::packSnorm2x16(OctahedralEncode(vertex.normal));
+			packed.texCoords = glm::packHalf2x16(vertex.texCoords);
+			return packed;
+		}
+
+		/*
+		 * Projects a unit vector onto the octahedron and unfolds it to [-1, 1]^2
+		 */
+		static glm::vec2 OctahedralEncode(const glm::vec3& normal)
+		{
+			const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+			if (sum == 0.f)
+				return glm::vec2(0.f);
+
+			const glm::vec3 n = normal / sum;
+
+			if (n.z >= 0.f)
+				return glm::vec2(n.x, n.y);
+
+			return glm::vec2(
+				(1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+				(1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f));
+		}
 
 		static VkVertexInputBindingDescription GetBindingDescription()
 		{
 			VkVertexInputBindingDescription bindingDescription = {};
 			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
+			bindingDescription.stride = sizeof(PackedVertex);
 			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 			return bindingDescription;
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+		static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions()
 		{
-			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
 
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
 			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(Vertex, position);
+			attributeDescriptions[0].offset = offsetof(PackedVertex, position);
 
 			attributeDescriptions[1].binding = 0;
 			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[1].offset = offsetof(Vertex, normal);
+			attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
 
 			attributeDescriptions[2].binding = 0;
 			attributeDescriptions[2].location = 2;
-			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-			attributeDescriptions[2].offset = offsetof(Vertex, texCoords);
-
-			attributeDescriptions[3].binding = 0;
-			attributeDescriptions[3].location = 3;
-			attributeDescriptions[3].format = VK_FORMAT_R32_SINT;
-			attributeDescriptions[3].offset = offsetof(Vertex, materialId);
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[2].offset = offsetof(PackedVertex, texCoords);
 
 			return attributeDescriptions;
 		}
-
-		bool operator==(const Vertex& other) const
-		{
-			return position == other.position &&
-				normal == other.normal &&
-				texCoords == other.texCoords &&
-				materialId == other.materialId;
-		}
 	};
+
+	static_assert(sizeof(PackedVertex) == 20, "PackedVertex must match Common/Vertex.glsl");
 }
 
 /**
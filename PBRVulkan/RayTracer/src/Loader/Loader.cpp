@@ -34,6 +34,7 @@ freely, subject to the following restrictions:
 #include "../Assets/Light.h"
 #include "../Assets/Material.h"
 #include "../Assets/Mesh.h"
+#include "../Assets/Primitive.h"
 
 namespace Loader
 {
@@ -144,6 +145,65 @@ namespace Loader
 				}
 			}
 
+			//--------------------------------------------
+			// Analytic primitives
+
+			char primitiveType[20] = "None";
+			sscanf(line, " %19s", primitiveType);
+
+			if (strcmp(primitiveType, "sphere") == 0 ||
+				strcmp(primitiveType, "disk") == 0 ||
+				strcmp(primitiveType, "quad") == 0)
+			{
+				Assets::Primitive primitive{};
+				glm::vec3 v1{};
+				glm::vec3 v2{};
+
+				while (fgets(line, kMaxLineLength, file))
+				{
+					// end group
+					if (strchr(line, '}'))
+						break;
+
+					char matName[100];
+
+					if (sscanf(line, " material %s", matName) == 1)
+					{
+						// look up material in dictionary
+						if (materialMap.find(matName) != materialMap.end())
+							primitive.materialId = materialMap[matName].id;
+						else
+							printf("Could not find material %s\n", matName);
+					}
+
+					sscanf(line, " position %f %f %f", &primitive.position.x, &primitive.position.y,
+					       &primitive.position.z);
+					sscanf(line, " normal %f %f %f", &primitive.normal.x, &primitive.normal.y, &primitive.normal.z);
+					sscanf(line, " radius %f", &primitive.radius);
+					sscanf(line, " v1 %f %f %f", &v1.x, &v1.y, &v1.z);
+					sscanf(line, " v2 %f %f %f", &v2.x, &v2.y, &v2.z);
+				}
+
+				if (strcmp(primitiveType, "sphere") == 0)
+				{
+					primitive.type = Assets::PrimitiveType::SpherePrimitive;
+				}
+				else if (strcmp(primitiveType, "disk") == 0)
+				{
+					primitive.type = Assets::PrimitiveType::DiskPrimitive;
+					primitive.normal = normalize(primitive.normal);
+				}
+				else
+				{
+					primitive.type = Assets::PrimitiveType::QuadPrimitive;
+					primitive.u = v1 - primitive.position;
+					primitive.v = v2 - primitive.position;
+					primitive.normal = normalize(cross(primitive.u, primitive.v));
+				}
+
+				scene.AddPrimitive(primitive);
+			}
+
 			//--------------------------------------------
 			// Light
 
@@ -202,6 +262,10 @@ namespace Loader
 					sscanf(line, " resolution %d %d", &renderOptions.resolution.x, &renderOptions.resolution.y);
 					sscanf(line, " hdrMultiplier %f", &renderOptions.hdrMultiplier);
 					sscanf(line, " maxDepth %i", &renderOptions.maxDepth);
+					sscanf(line, " splitThreshold %u", &renderOptions.splitThreshold);
+					sscanf(line, " buildBudget %f", &renderOptions.buildBudget);
+					sscanf(line, " lowMemoryThreshold %u", &renderOptions.lowMemoryThreshold);
+					sscanf(line, " meshletSize %u", &renderOptions.meshletSize);
 				}
 
 				if (strcmp(envMap, "None") != 0)
@@ -240,6 +304,31 @@ namespace Loader
 			}
 
 
+			//--------------------------------------------
+			// Keyframe of the camera path
+
+			if (strstr(line, "Keyframe"))
+			{
+				Tracer::Keyframe keyframe{};
+				keyframe.fov = 45.f;
+
+				while (fgets(line, kMaxLineLength, file))
+				{
+					// end group
+					if (strchr(line, '}'))
+						break;
+
+					sscanf(line, " time %f", &keyframe.time);
+					sscanf(line, " position %f %f %f", &keyframe.position.x, &keyframe.position.y,
+					       &keyframe.position.z);
+					sscanf(line, " lookAt %f %f %f", &keyframe.lookAt.x, &keyframe.lookAt.y, &keyframe.lookAt.z);
+					sscanf(line, " fov %f", &keyframe.fov);
+					sscanf(line, " aperture %f", &keyframe.aperture);
+				}
+
+				scene.AddKeyframe(keyframe);
+			}
+
 			//--------------------------------------------
 			// Mesh
 
@@ -250,6 +339,7 @@ namespace Loader
 				glm::vec3 scale{};
 				auto xform = glm::mat4(1.f);
 				int material_id = 0; // Default Material ID
+				int dynamic = 0;
 				while (fgets(line, kMaxLineLength, file))
 				{
 					// end group
@@ -279,6 +369,7 @@ namespace Loader
 
 					sscanf(line, " position %f %f %f", &xform[3][0], &xform[3][1], &xform[3][2]);
 					sscanf(line, " scale %f %f %f", &xform[0][0], &xform[1][1], &xform[2][2]);
+					sscanf(line, " dynamic %d", &dynamic);
 				}
 				if (!filename.empty())
 				{
@@ -286,6 +377,7 @@ namespace Loader
 					if (mesh_id != -1)
 					{
 						Assets::MeshInstance instance(mesh_id, xform, material_id);
+						instance.dynamic = dynamic != 0;
 						scene.AddMeshInstance(instance);
 					}
 				}
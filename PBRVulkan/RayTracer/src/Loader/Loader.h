@@ -8,6 +8,7 @@
 namespace Assets
 {
 	struct Light;
+	struct Primitive;
 	class Material;
 	class Mesh;
 	class MeshInstance;
@@ -16,6 +17,7 @@ namespace Assets
 namespace Tracer
 {
 	class Scene;
+	struct Keyframe;
 }
 
 namespace Loader
@@ -25,12 +27,14 @@ namespace Loader
 	public:
 		virtual ~SceneBase() {};
 		virtual void AddCamera(glm::vec3 pos, glm::vec3 lookAt, float fov, float aspect) = 0;
+		virtual void AddKeyframe(const Tracer::Keyframe& keyframe) = 0;
 		virtual void AddHDR(const std::string& path) = 0;
 		virtual int AddMesh(const std::string& path) = 0;
 		virtual int AddTexture(const std::string& path) = 0;
 		virtual int AddMaterial(Assets::Material material) = 0;
 		virtual int AddLight(Assets::Light light) = 0;
 		virtual int AddMeshInstance(class Assets::MeshInstance meshInstance) = 0;
+		virtual int AddPrimitive(Assets::Primitive primitive) = 0;
 	};
 
 	bool LoadSceneFromFile(
@@ -12,11 +12,23 @@ namespace Loader
 			useEnvMap = false;
 			resolution = glm::vec2(1920, 1080);
 			hdrMultiplier = 1.0f;
+			splitThreshold = 0;
+			buildBudget = 0.f;
+			lowMemoryThreshold = 0;
+			meshletSize = 0;
 		}
 
 		glm::ivec2 resolution{};
 		int maxDepth;
 		bool useEnvMap;
 		float hdrMultiplier;
+		// Meshes with more triangles are split into multiple BLASes (0 disables splitting)
+		uint32_t splitThreshold;
+		// Estimated BLAS build time in milliseconds spent on fast trace builds (0 means unlimited)
+		float buildBudget;
+		// BLASes with more triangles are built with the low memory flag (0 disables it)
+		uint32_t lowMemoryThreshold;
+		// Triangles of a meshlet sorted along a Morton curve by the mesh optimizer (0 disables sorting)
+		uint32_t meshletSize;
 	};
 }
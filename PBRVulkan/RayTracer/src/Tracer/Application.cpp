@@ -2,14 +2,20 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <thread>
 
 #include "Menu.h"
 #include "Scene.h"
 #include "Camera.h"
 #include "Compiler.h"
+#include "Coordinator.h"
+#include "ImageWriter.h"
 
 #include "../Geometry/Global.h"
 #include "../Vulkan/Window.h"
@@ -23,6 +29,9 @@
 #include "../Vulkan/ImageView.h"
 #include "../Vulkan/Command.cpp"
 #include "../Vulkan/Memory.h"
+#include "../Vulkan/ReadbackRing.h"
+#include "../Vulkan/UniformRing.h"
+#include "../Vulkan/Telemetry.h"
 
 #include "../path.h"
 
@@ -30,9 +39,9 @@
 #include "Widgets/RendererWidget.h"
 #include "Widgets/SceneWidget.h"
 #include "Widgets/SaveWidget.h"
+#include "Widgets/MemoryWidget.h"
 
 #include <iostream>
-#include <fstream>
 #include <chrono>
 
 class Timer {
@@ -58,37 +67,185 @@ std::chrono::time_point<std::chrono::system_clock> Timer::m_stop = std::chrono::
 
 namespace Tracer
 {
-	Application::Application()
+	Application::Application(const Options& options): Raytracer(options.Headless), options(options)
 	{
 		PrintGPUInfo();
-		CheckScenesFolder();
-		if (terminate) return;
+
+		// Half of the cores encode, the other half is left to the render loop and the driver
+		writer.reset(new ImageWriter(std::thread::hardware_concurrency() / 2));
+
+		// Headless renders load the scene files of their jobs
+		if (headless)
+		{
+			CreateJobs();
+
+			// The distributed render has finished before the worker claimed a task
+			terminate = jobs.empty();
+			if (terminate) return;
+		}
+		else
+		{
+			CheckScenesFolder();
+			if (terminate) return;
+		}
 
 		LoadScene();
+
+		if (headless)
+			ApplyJob();
+
 		compiler.reset(new Compiler());
 		CompileShaders();
 		CreateAS();
-		RegisterCallbacks();
+
+		if (!headless)
+			RegisterCallbacks();
+
 		Raytracer::CreateSwapChain();
 		CreateMenu();
 		CreateComputePipeline();
-		CreateTmpImage();
+		CreateReadbackRing();
+		DumpTelemetry();
 	}
 
 	Application::~Application()
 	{
 	}
 
-	void Application::CreateTmpImage()
+	void Application::CreateReadbackRing()
 	{
-		tmpImage.reset(new Vulkan::Image(*device, swapChain->Extent, swapChain->Format, VK_IMAGE_TILING_LINEAR,
-			VK_IMAGE_TYPE_2D, VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		screenshots.reset(
+			new Vulkan::ReadbackRing(*device, swapChain->Extent, Vulkan::FrameContext::MAX_FRAMES_IN_FLIGHT));
 	}
 
 	void Application::LoadScene()
 	{
-		scene.reset(new Scene(Interface::SceneWidget::GetScenePath(settings.SceneId), *device, *commandPool));
+		captureFrame.reset();
+
+		if (!headless)
+		{
+			scene.reset(new Scene(Interface::SceneWidget::GetScenePath(settings.SceneId), *device));
+			cameraPath = scene->GetCameraPath();
+			return;
+		}
+
+		const auto& job = jobs[currentJob];
+		scene.reset(new Scene(job.ScenePath, *device));
+
+		// Jobs without a camera render the camera of the scene file
+		sceneCamera.reset(new Camera(scene->GetCamera()));
+
+		const auto resolution = scene->GetRendererOptions().resolution;
+
+		offscreenExtent = job.Width > 0
+			                  ? VkExtent2D{ job.Width, job.Height }
+			                  : VkExtent2D{ static_cast<uint32_t>(resolution.x), static_cast<uint32_t>(resolution.y) };
+	}
+
+	// The claim is renewed until the accumulation has been published, the loading of the job included
+	void Application::ClaimTask()
+	{
+		if (auto task = Coordinator::ClaimTask(options.WorkerPath))
+		{
+			lease.reset(new Lease(task->OutputPath));
+			jobs.push_back(*task);
+		}
+	}
+
+	void Application::CreateJobs()
+	{
+		if (!options.WorkerPath.empty())
+		{
+			ClaimTask();
+			return;
+		}
+
+		if (!options.BatchPath.empty())
+		{
+			jobs = Job::Load(options.BatchPath);
+			return;
+		}
+
+		Job job;
+		job.ScenePath = options.ScenePath;
+		job.OutputPath = options.OutputPath;
+		job.Width = options.Width;
+		job.Height = options.Height;
+		job.Samples = options.Samples;
+		job.TimeBudget = options.TimeBudget;
+		job.WriteAOVs = options.WriteAOVs;
+		job.Fps = options.Fps;
+		job.CameraPath = options.CameraPath;
+
+		jobs.push_back(job);
+	}
+
+	/*
+	 * Only the settings and the camera change between jobs of a scene, i.e. the uniforms.
+	 */
+	void Application::ApplyJob()
+	{
+		const auto& job = jobs[currentJob];
+		const auto renderer = scene->GetRendererOptions();
+
+		auto& camera = scene->GetCamera();
+		camera = job.Camera ? Camera(job.Camera->position, job.Camera->lookAt, job.Camera->fov, 1.f) : *sceneCamera;
+		camera.SetAspect(static_cast<float>(offscreenExtent.width) / offscreenExtent.height);
+
+		settings.MaxDepth = job.MaxDepth.value_or(renderer.maxDepth);
+		settings.UseEnvMap = renderer.useEnvMap;
+		settings.HdrMultiplier = renderer.hdrMultiplier;
+		settings.IntegratorType = job.IntegratorType;
+		settings.TargetSamples = job.Samples;
+		settings.TimeBudget = job.TimeBudget;
+		// Nothing is presented, several passes per submit only have to stay below the device timeout
+		settings.UseThroughputMode = true;
+
+		if (job.Fps <= 0)
+			return;
+
+		cameraPath = job.CameraPath.empty() ? scene->GetCameraPath() : CameraPath::Load(job.CameraPath);
+
+		if (!StartCapture(job.OutputPath, job.Fps, job.Samples, job.TimeBudget))
+			throw std::runtime_error("The camera path of " + job.ScenePath + " cannot be captured");
+	}
+
+	/*
+	 * The loaded scene, its acceleration structures and the render targets are kept while the next job
+	 * shares them, the shaders are compiled again only for another integrator.
+	 */
+	void Application::BeginJob(uint32_t index)
+	{
+		const bool sharesScene = jobs[index].SharesScene(jobs[currentJob]);
+		const int integratorType = settings.IntegratorType;
+
+		currentJob = index;
+		device->WaitIdle();
+
+		if (sharesScene)
+		{
+			ApplyJob();
+
+			if (settings.IntegratorType != integratorType)
+			{
+				CompileShaders();
+				Raytracer::CreateGraphicsPipeline();
+			}
+		}
+		else
+		{
+			Raytracer::DeleteSwapChain();
+			LoadScene();
+			ApplyJob();
+			CompileShaders();
+			CreateAS();
+			Raytracer::CreateSwapChain();
+			CreateComputePipeline();
+			CreateReadbackRing();
+		}
+
+		ResetAccumulation();
+		traceStopped = false;
 	}
 
 	void Application::UpdateSettings()
@@ -104,7 +261,12 @@ namespace Tracer
 		if (settings.RequiresAccumulationReset(menu->GetSettings()))
 			ResetAccumulation();
 
+		if (settings.RequiresCommandsRecording(menu->GetSettings()))
+			InvalidateCommands();
+
 		settings = menu->GetSettings();
+		UpdateCameraPath();
+
 		if (glfwGetKey(instance->GetWindow().Get(), GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS &&
 			glfwGetKey(instance->GetWindow().Get(), GLFW_KEY_S) == GLFW_PRESS)
 		{
@@ -112,6 +274,41 @@ namespace Tracer
 		}
 	}
 
+	void Application::UpdateCameraPath()
+	{
+		if (settings.ShouldAddKeyframe)
+		{
+			const auto& camera = scene->GetCamera();
+			const auto& keyframes = cameraPath.GetKeyframes();
+			const float interval = std::max(settings.KeyframeInterval, 0.f);
+			const float time = keyframes.empty() ? 0.f : keyframes.back().time + interval;
+
+			cameraPath.Add({
+				time, camera.GetPosition(), camera.GetPosition() + camera.GetDirection(), camera.GetFov(),
+				settings.Aperture
+			});
+		}
+
+		if (settings.ShouldClearKeyframes)
+			cameraPath.Clear();
+
+		try
+		{
+			if (settings.ShouldSavePath)
+				cameraPath.Save(settings.CameraPathName);
+
+			if (settings.ShouldLoadPath)
+				cameraPath = CameraPath::Load(settings.CameraPathName);
+		}
+		catch (const std::exception& exception)
+		{
+			std::cout << "[CAPTURE] " << exception.what() << std::endl;
+		}
+
+		if (settings.ShouldCapturePath && !captureFrame)
+			StartCapture(settings.CaptureName, settings.CaptureFps, settings.CaptureSamples, 0);
+	}
+
 	void Application::CompileShaders() const
 	{
 		std::vector<Parser::Define> defines;
@@ -140,6 +337,7 @@ namespace Tracer
 
 		settings = menu->GetSettings();
 		device->WaitIdle();
+		FlushReadback();
 		menu.reset();
 		Raytracer::DeleteSwapChain();
 		LoadScene();
@@ -150,7 +348,8 @@ namespace Tracer
 		CreateMenu();
 		ResetAccumulation();
 		CreateComputePipeline();
-		CreateTmpImage();
+		CreateReadbackRing();
+		DumpTelemetry();
 	}
 
 	void Application::RecompileShaders()
@@ -164,6 +363,10 @@ namespace Tracer
 
 	void Application::CreateMenu()
 	{
+		// Headless renders skip the user interface entirely, see ApplyJob()
+		if (headless)
+			return;
+
 		const auto renderer = scene->GetRendererOptions();
 		settings.MaxDepth = renderer.maxDepth;
 		settings.UseEnvMap = renderer.useEnvMap;
@@ -173,13 +376,60 @@ namespace Tracer
 
 		menu->AddWidget(std::make_shared<Interface::SceneWidget>());
 		menu->AddWidget(std::make_shared<Interface::RendererWidget>());
-		menu->AddWidget(std::make_shared<Interface::CinemaWidget>());
+		menu->AddWidget(std::make_shared<Interface::CinemaWidget>(cameraPath));
 		menu->AddWidget(std::make_shared<Interface::SaveWidget>());
+		menu->AddWidget(std::make_shared<Interface::MemoryWidget>(device->GetAllocator()));
+	}
+
+	void Application::DumpTelemetry() const
+	{
+		// Snapshot of the fully loaded scene for capacity planning
+		Vulkan::Telemetry::Get().Dump("memory.json");
 	}
 
 	void Application::ResetAccumulation()
 	{
 		frame = 0;
+		traceLevel = 0;
+		tileRow = 0;
+		lastCompaction = 0;
+		errorMeasured.fill(false);
+		estimatedError.reset();
+		renderStart = std::chrono::steady_clock::now();
+	}
+
+	/*
+	 * Throughput mode traces several accumulation passes per presented frame while the camera is still.
+	 * The number of passes is doubled or halved until the present interval approaches the target.
+	 */
+	void Application::UpdateTraceLevel()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const auto interval = std::chrono::duration<float, std::milli>(now - lastFrameTime).count();
+		lastFrameTime = now;
+
+		if (!settings.UseThroughputMode || settings.UseRasterizer || settings.UseTiledTrace)
+		{
+			traceLevel = 0;
+			return;
+		}
+
+		// The first frame after a reset stays interactive, the measured interval lags behind the frames in flight
+		if (frame == 0 || ++framesSinceTraceLevelChange <= Vulkan::FrameContext::MAX_FRAMES_IN_FLIGHT)
+			return;
+
+		const auto target = static_cast<float>(settings.TargetFrameTime);
+
+		if (interval < 0.75f * target && traceLevel + 1 < TRACE_LEVELS)
+		{
+			++traceLevel;
+			framesSinceTraceLevelChange = 0;
+		}
+		else if (interval > target && traceLevel > 0)
+		{
+			--traceLevel;
+			framesSinceTraceLevelChange = 0;
+		}
 	}
 
 	void Application::ResizeWindow() const
@@ -200,7 +450,107 @@ namespace Tracer
 		}
 	}
 
-	void Application::UpdateUniformBuffer(uint32_t imageIndex)
+	/*
+	 * Tiled trace splits the frame into bands of rows which are traced in consecutive submits,
+	 * so a heavy frame does not stall the user interface or trigger a device timeout.
+	 * The band height follows the GPU time per row measured by the previous tiles.
+	 */
+	void Application::UpdateTraceTile(uint32_t frameIndex)
+	{
+		// The frame in flight has been waited on, thus its previous tile has finished
+		const auto time = GetTileTime(frameIndex);
+
+		if (!settings.UseTiledTrace || settings.UseRasterizer)
+		{
+			traceTile.reset();
+			tileRow = 0;
+			return;
+		}
+
+		const auto extent = swapChain->Extent;
+
+		if (time && *time > 0.f && tracedRows[frameIndex] > 0)
+		{
+			// Aim below the budget as the cost of rows varies across the frame
+			const float rowTime = *time / static_cast<float>(tracedRows[frameIndex]);
+			const float rows = 0.8f * static_cast<float>(settings.TileBudget) / rowTime;
+
+			tileHeight = static_cast<uint32_t>(std::clamp(rows, static_cast<float>(MIN_TILE_HEIGHT),
+			                                              static_cast<float>(extent.height)));
+		}
+
+		const uint32_t height = std::min(tileHeight, extent.height - tileRow);
+
+		tracedRows[frameIndex] = height;
+		traceTile = VkRect2D{ { 0, static_cast<int32_t>(tileRow) }, { extent.width, height } };
+	}
+
+	/*
+	 * Adaptive sampling traces only the pixels of the last compacted list.
+	 * The list is rebuilt every few samples and always after a reset, when every pixel is traced.
+	 * The compaction also estimates the error of the frame for the error criterion.
+	 * Tiles trace whole rows, thus they ignore the list.
+	 */
+	void Application::UpdateCompaction(uint32_t frameIndex)
+	{
+		compactPixels = false;
+
+		const bool measureError = settings.TargetError > 0.f;
+
+		if (!(settings.UseAdaptiveSampling || measureError) || settings.UseRasterizer || traceTile || traceStopped)
+			return;
+
+		const auto interval = static_cast<uint32_t>(std::max(settings.AdaptiveInterval, 1));
+
+		if (frame == 0 || frame >= lastCompaction + interval)
+		{
+			compactPixels = true;
+			errorMeasured[frameIndex] = true;
+			lastCompaction = frame;
+		}
+	}
+
+	/*
+	 * Stops tracing once the target samples, the time budget or the target error has been reached,
+	 * the presented frames only redraw the user interface. Relaxing the criteria resumes the accumulation.
+	 */
+	void Application::UpdateTermination(uint32_t frameIndex)
+	{
+		// The frame in flight has been waited on, thus its compaction has finished
+		if (errorMeasured[frameIndex])
+		{
+			estimatedError = GetEstimatedError(frameIndex);
+			errorMeasured[frameIndex] = false;
+		}
+
+		const auto targetSamples = static_cast<uint32_t>(std::max(settings.TargetSamples, 0));
+
+		// Throughput mode must not overshoot the target samples
+		while (targetSamples > 0 && traceLevel > 0 && frame + (1u << traceLevel) > targetSamples)
+			--traceLevel;
+
+		const auto elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - renderStart).count();
+
+		const bool samplesReached = targetSamples > 0 && frame >= targetSamples;
+		const bool timeReached = settings.TimeBudget > 0 && elapsed >= static_cast<float>(settings.TimeBudget);
+		const bool errorReached =
+			settings.TargetError > 0.f && estimatedError && *estimatedError <= settings.TargetError;
+
+		const bool stopped = traceStopped;
+		traceStopped = !settings.UseRasterizer && (samplesReached || timeReached || errorReached);
+
+		if (traceStopped && !stopped)
+		{
+			std::cout << "[RENDER] Stopped after " << frame << " samples in " << elapsed << " s";
+
+			if (estimatedError)
+				std::cout << ", estimated error " << *estimatedError;
+
+			std::cout << std::endl;
+		}
+	}
+
+	void Application::UpdateUniformBuffer(uint32_t frameIndex)
 	{
 		Uniforms::Global uniform{};
 
@@ -210,41 +560,88 @@ namespace Tracer
 		uniform.lights = scene->GetLightsSize();
 		uniform.ssp = settings.SSP;
 		uniform.maxDepth = settings.MaxDepth;
-		uniform.aperture = settings.Aperture;
+		uniform.aperture = captureFrame ? captureAperture : settings.Aperture;
 		uniform.focalDistance = settings.FocalDistance;
 		uniform.hdrMultiplier = scene->UseHDR() ? settings.HdrMultiplier : 0.f;
 		uniform.hdrResolution = scene->UseHDR() ? scene->GetHDRResolution() : 0.f;
-		uniform.frame = frame;
+		// Index of the first sample, the pass index is added in the shaders
+		uniform.frame = sampleIndex;
 		uniform.AORayLength = settings.AORayLength;
 		uniform.integratorType = settings.IntegratorType;
 		uniform.doubleSided = settings.DoubleSidedLight;
+		uniform.sampleOffset = headless ? jobs[currentJob].FirstSample : 0;
 
-		uniformBuffers[imageIndex]->Fill(&uniform);
+		uniformRing->BeginFrame(frameIndex);
+		uniformRing->Push(uniform);
 	}
 
-	void Application::Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	void Application::RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes)
 	{
-		Camera::TimeDeltaUpdate();
+		if (!settings.UseRasterizer)
+			Raytracer::RecordTrace(commandBuffer, frameIndex, passes);
+	}
+
+	void Application::RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		if (settings.UseRasterizer)
+			return;
+
+		// The post-processed output is copied by the render commands of the frame in flight
+		if (!settings.UseComputeShaders)
+			Raytracer::RecordCopy(commandBuffer, imageIndex);
+	}
+
+	void Application::Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t frameIndex,
+	                         uint32_t imageIndex)
+	{
+		// The GLFW timer is not initialized without a window
+		if (!headless)
+			Camera::TimeDeltaUpdate();
 
 		this->imageIndex = imageIndex;
 
 		if (scene->GetCamera().OnBeforeRender())
 			ResetAccumulation();
 
+		UpdateCapture();
+		UpdateTraceLevel();
+		UpdateTraceTile(frameIndex);
+		UpdateTermination(frameIndex);
+		UpdateCompaction(frameIndex);
+
+		// Every band of a tiled sample traces the same sample, the count only advances after the last band
+		sampleIndex = frame + 1;
+
 		if (settings.UseRasterizer)
 		{
 			Clear(commandBuffer, imageIndex);
-			Rasterizer::Render(framebuffer, commandBuffer, imageIndex);
+			Rasterizer::Render(framebuffer, commandBuffer, frameIndex, imageIndex);
 		}
-		else
-			Raytracer::Render(framebuffer, commandBuffer, imageIndex);
 
-		ComputePipeline(commandBuffer, imageIndex);
+		ComputePipeline(commandBuffer, frameIndex, imageIndex);
+
+		SaveImage(commandBuffer, frameIndex, imageIndex);
+		ExportImage(commandBuffer, frameIndex);
+		RecordCapture(commandBuffer, frameIndex, imageIndex);
+
+		if (menu)
+			menu->Render(framebuffer, commandBuffer);
+
+		if (traceStopped)
+			return;
 
-		SaveImage(settings.SavedImageName, imageIndex);
-		menu->Render(framebuffer, commandBuffer);
+		if (traceTile)
+		{
+			tileRow += traceTile->extent.height;
+
+			// The sample is complete once every row has been traced
+			if (tileRow < swapChain->Extent.height)
+				return;
+
+			tileRow = 0;
+		}
 
-		++frame;
+		frame += 1u << traceLevel;
 	}
 
 	void Application::RegisterCallbacks()
@@ -272,7 +669,7 @@ namespace Tracer
 
 	void Application::OnKeyChanged(int key, int scanCode, int action, int mods)
 	{
-		if (menu->WantCaptureKeyboard() || !swapChain)
+		if (menu->WantCaptureKeyboard() || !swapChain || captureFrame)
 			return;
 
 		if (glfwGetKey(instance->GetWindow().Get(), GLFW_KEY_LEFT_CONTROL) != GLFW_PRESS)
@@ -281,7 +678,7 @@ namespace Tracer
 
 	void Application::OnCursorPositionChanged(double xpos, double ypos)
 	{
-		if (menu->WantCaptureKeyboard() || menu->WantCaptureMouse() || !swapChain)
+		if (menu->WantCaptureKeyboard() || menu->WantCaptureMouse() || !swapChain || captureFrame)
 			return;
 
 		if (scene->GetCamera().OnCursorPositionChanged(xpos, ypos))
@@ -326,290 +723,265 @@ namespace Tracer
 
 	void Application::CreateComputePipeline()
 	{
+		postProcess = nullptr;
+
 		computer.reset(new Vulkan::Computer(
 			*swapChain,
 			*device,
 			GetOutputImageView(),
 			GetNormalsImageView(),
-			GetPositionImageView()));
+			GetPositionImageView(),
+			Vulkan::FrameContext::MAX_FRAMES_IN_FLIGHT));
+
+		InvalidateCommands();
 	}
 
-	void Application::ComputePipeline(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+	/*
+	 * Post-processing runs on the compute queue after the trace of the frame, see Core::DrawFrame.
+	 * The GPU time is printed periodically to compare it with the present interval.
+	 */
+	void Application::ComputePipeline(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex)
 	{
-		// It uses the previous frame buffers
-		if (settings.UseComputeShaders)
+		// The frame in flight has been waited on, thus its previous post-processing has finished
+		if (const auto time = computer->GetTime(frameIndex))
 		{
-			// Compute pipeline
+			postProcessTime += *time;
+
+			if (++postProcessFrames == 256)
 			{
-				computer->BuildCommand(settings.ComputeShaderId);
+				std::cout << "[COMPUTER] Post-processing " << postProcessTime / postProcessFrames <<
+					" ms per frame on the compute queue." << std::endl;
 
-				VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
-				VkCommandBuffer commandBuffers[]{computer->GetCommandBuffers()[0]};
+				postProcessTime = 0.f;
+				postProcessFrames = 0;
+			}
+		}
 
-				VkSubmitInfo computeSubmitInfo{};
-				computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-				computeSubmitInfo.pWaitDstStageMask = waitStages;
-				computeSubmitInfo.commandBufferCount = 1;
-				computeSubmitInfo.pCommandBuffers = commandBuffers;
+		if (!settings.UseComputeShaders || settings.UseRasterizer)
+		{
+			postProcess = nullptr;
+			return;
+		}
 
-				Vulkan::VK_CHECK(vkQueueSubmit(device->ComputeQueue, 1, &computeSubmitInfo, nullptr),
-				                 "Compute shader submit failed!");
-			}
+		computer->BuildCommand(settings.ComputeShaderId);
+		postProcess = computer.get();
 
-			Copy(commandBuffer, computer->GetOutputImage().Get(), swapChain->GetImage()[imageIndex]);
+		Copy(commandBuffer, computer->GetOutputImage(frameIndex).Get(), swapChain->GetImage()[imageIndex]);
+	}
+
+	/*
+	 * Exports the linear radiance without stalling the render loop. The frame records the readback
+	 * into its render commands, once the frame in flight has been waited on again the pixels are
+	 * handed over to the writer thread.
+	 */
+	void Application::ExportImage(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (readbackFrame == frameIndex)
+			FlushReadback();
+
+		if (!settings.ShouldExportImage || readbackFrame || settings.UseRasterizer)
+			return;
+
+		if (!ImageWriter::IsFloatFormat(settings.ExportedImageName))
+		{
+			std::cout << "[EXPORT] " << settings.ExportedImageName << " requires the .exr or .pfm extension" <<
+				std::endl;
+			return;
 		}
+
+		RecordReadback(commandBuffer, settings.ExportAOVs);
+
+		readbackFrame = frameIndex;
+		readbackPath = settings.ExportedImageName;
+		readbackAOVs = settings.ExportAOVs;
+	}
+
+	// The normals and positions are written next to the radiance, e.g. image.normals.exr
+	void Application::PushReadback(const std::string& path, bool aovs)
+	{
+		const auto extent = swapChain->Extent;
+
+		writer->Push(path, extent.width, extent.height, GetReadback(ReadbackImage::Accumulation), true);
+
+		if (!aovs)
+			return;
+
+		const auto extension = std::filesystem::path(path).extension().string();
+		const auto aovPath = [&](const std::string& aov)
+		{
+			return std::filesystem::path(path).replace_extension("." + aov + extension).string();
+		};
+
+		writer->Push(aovPath("normals"), extent.width, extent.height, GetReadback(ReadbackImage::Normals), false);
+		writer->Push(aovPath("positions"), extent.width, extent.height, GetReadback(ReadbackImage::Positions), false);
 	}
 
-	void insertImageMemoryBarrier(
-		VkCommandBuffer cmdbuffer,
-		VkImage image,
-		VkAccessFlags srcAccessMask,
-		VkAccessFlags dstAccessMask,
-		VkImageLayout oldImageLayout,
-		VkImageLayout newImageLayout,
-		VkPipelineStageFlags srcStageMask,
-		VkPipelineStageFlags dstStageMask,
-		VkImageSubresourceRange subresourceRange)
+	// Pending exports and screenshots, the device has to be idle
+	void Application::FlushReadback()
 	{
-		VkImageMemoryBarrier imageMemoryBarrier = {};
-		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imageMemoryBarrier.srcAccessMask = srcAccessMask;
-		imageMemoryBarrier.dstAccessMask = dstAccessMask;
-		imageMemoryBarrier.oldLayout = oldImageLayout;
-		imageMemoryBarrier.newLayout = newImageLayout;
-		imageMemoryBarrier.image = image;
-		imageMemoryBarrier.subresourceRange = subresourceRange;
+		for (uint32_t frameIndex = 0; frameIndex < screenshotPaths.size(); ++frameIndex)
+			PushScreenshot(frameIndex);
+
+		if (!readbackFrame)
+			return;
 
-		vkCmdPipelineBarrier(
-			cmdbuffer,
-			srcStageMask,
-			dstStageMask,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &imageMemoryBarrier);
+		PushReadback(readbackPath, readbackAOVs);
+		readbackFrame.reset();
 	}
 
-	void Application::SaveImage(std::string const &name, uint32_t imageIndex)
+	/*
+	 * Screenshots are copied by the render commands of the frame into its region of the readback ring,
+	 * once the frame in flight has been waited on again the pixels are encoded by the writer threads.
+	 * Capturing every frame thus only costs the copy, e.g. image.png is captured as image_00042.png.
+	 */
+	void Application::SaveImage(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex)
 	{
-		if (!settings.ShouldSaveImage) {
+		PushScreenshot(frameIndex);
+
+		// A stopped render presents the same image, thus only the frames which have traced are captured
+		const bool capture = settings.CaptureFrames && !traceStopped;
+
+		if (!settings.ShouldSaveImage && !capture)
 			return;
-		}
 
-		std::cout << "Save image called with name = [" << name << "]\n";
-
-		bool supportsBlit = true;
-
-		// Check blit support for source and destination
-		VkFormatProperties formatProps;
-
-		// Check if the device supports blitting from optimal images (the swapchain images are in optimal format)
-		vkGetPhysicalDeviceFormatProperties(device->GetPhysical(), swapChain->Format, &formatProps);
-		if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT)) {
-			supportsBlit = false;
-		}
-
-		// Check if the device supports blitting to linear images
-		vkGetPhysicalDeviceFormatProperties(device->GetPhysical(), VK_FORMAT_R8G8B8A8_UNORM, &formatProps);
-		if (!(formatProps.linearTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
-			supportsBlit = false;
-		}
-
-		// Source for the copy is the last rendered swapchain image
-		VkImage srcImage = swapChain->GetImage()[imageIndex];
-
-		// Create the linear tiled destination image to copy to and to read the memory from
-		VkImageCreateInfo imageCreateCI = {};
-		imageCreateCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		imageCreateCI.imageType = VK_IMAGE_TYPE_2D;
-		// Note that vkCmdBlitImage (if supported) will also do format conversions if the swapchain color format would differ
-		imageCreateCI.format = VK_FORMAT_R8G8B8A8_UNORM;
-		imageCreateCI.extent.width = swapChain->Extent.width;
-		imageCreateCI.extent.height = swapChain->Extent.height;
-		imageCreateCI.extent.depth = 1;
-		imageCreateCI.arrayLayers = 1;
-		imageCreateCI.mipLevels = 1;
-		imageCreateCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		imageCreateCI.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageCreateCI.tiling = VK_IMAGE_TILING_LINEAR;
-		imageCreateCI.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-		// Create the image
-		VkImage dstImage;
-		Vulkan::VK_CHECK(vkCreateImage(device->Get(), &imageCreateCI, nullptr, &dstImage), "");
-		// Create memory to back up the image
-		VkMemoryRequirements memRequirements;
-		VkMemoryAllocateInfo memAllocInfo = {};
-		memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		VkDeviceMemory dstImageMemory;
-		vkGetImageMemoryRequirements(device->Get(), dstImage, &memRequirements);
-		memAllocInfo.allocationSize = memRequirements.size;
-		// Memory must be host visible to copy from
-		memAllocInfo.memoryTypeIndex = tmpImage->GetMemory().FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		Vulkan::VK_CHECK(vkAllocateMemory(device->Get(), &memAllocInfo, nullptr, &dstImageMemory), "");
-		Vulkan::VK_CHECK(vkBindImageMemory(device->Get(), dstImage, dstImageMemory, 0), "");
-
-
-		auto cmdBuffers = Vulkan::CommandBuffers(*commandPool, 1);
-		// Do the actual blit from the swapchain image to our host visible destination image
-		VkCommandBuffer copyCmd = cmdBuffers[0];
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		vkBeginCommandBuffer(copyCmd, &beginInfo);
-		// Transition destination image to transfer destination layout
-		insertImageMemoryBarrier(
-			copyCmd,
-			dstImage,
-			0,
-			VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-		// Transition swapchain image from present to transfer source layout
-		insertImageMemoryBarrier(
-			copyCmd,
-			srcImage,
-			VK_ACCESS_MEMORY_READ_BIT,
-			VK_ACCESS_TRANSFER_READ_BIT,
-			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-		// If source and destination support blit we'll blit as this also does automatic format conversion (e.g. from BGR to RGB)
-		if (supportsBlit)
-		{
-			// Define the region to blit (we will blit the whole swapchain image)
-			VkOffset3D blitSize;
-			blitSize.x = swapChain->Extent.width;
-			blitSize.y = swapChain->Extent.height;
-			blitSize.z = 1;
-			VkImageBlit imageBlitRegion{};
-			imageBlitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageBlitRegion.srcSubresource.layerCount = 1;
-			imageBlitRegion.srcOffsets[1] = blitSize;
-			imageBlitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageBlitRegion.dstSubresource.layerCount = 1;
-			imageBlitRegion.dstOffsets[1] = blitSize;
-
-			// Issue the blit command
-			vkCmdBlitImage(
-				copyCmd,
-				srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1,
-				&imageBlitRegion,
-				VK_FILTER_NEAREST);
+		const auto path = capture
+			                  ? ImageWriter::Numbered(settings.SavedImageName, capturedFrames++)
+			                  : settings.SavedImageName;
+
+		RecordScreenshot(commandBuffer, frameIndex, imageIndex, path);
+	}
+
+	void Application::RecordScreenshot(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex,
+	                                   const std::string& path)
+	{
+		// The copy of the traced output leaves the image in the general layout, the rasterizer presents it
+		const auto layout = settings.UseRasterizer ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_GENERAL;
+
+		screenshots->Record(commandBuffer, frameIndex, swapChain->GetImage()[imageIndex], layout);
+		screenshotPaths[frameIndex] = path;
+	}
+
+	// The frame which has recorded the screenshot has to be finished
+	void Application::PushScreenshot(uint32_t frameIndex)
+	{
+		auto& path = screenshotPaths[frameIndex];
+
+		if (!path)
+			return;
+
+		const auto format = swapChain->Format;
+		const bool bgr = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB ||
+			format == VK_FORMAT_B8G8R8A8_SNORM;
+		const auto extent = screenshots->GetExtent();
+
+		writer->Push(*path, extent.width, extent.height, screenshots->Read(frameIndex), bgr);
+		path.reset();
+	}
+
+	/*
+	 * Renders the camera path into numbered frames, e.g. frames/frame.png is captured as frames/frame_00000.png.
+	 * Every frame accumulates until the samples or the time budget have been reached.
+	 */
+	bool Application::StartCapture(const std::string& pattern, int fps, int samples, int timeBudget)
+	{
+		if (cameraPath.GetKeyframes().size() < 2 || fps <= 0 || (samples <= 0 && timeBudget <= 0))
+		{
+			std::cout << "[CAPTURE] Requires at least two keyframes, the frame rate and the samples per frame" <<
+				std::endl;
+			return false;
 		}
-		else
+
+		const auto directory = std::filesystem::path(pattern).parent_path();
+
+		if (!directory.empty())
+			std::filesystem::create_directories(directory);
+
+		capturePattern = pattern;
+		captureFps = fps;
+		captureSamples = samples;
+		captureTimeBudget = timeBudget;
+		captureFrames = static_cast<uint32_t>(std::floor(cameraPath.GetDuration() * static_cast<float>(fps))) + 1;
+
+		std::cout << "[CAPTURE] Rendering " << captureFrames << " frames of the camera path into " << pattern <<
+			std::endl;
+
+		ApplyCaptureFrame(0);
+		return true;
+	}
+
+	void Application::ApplyCaptureFrame(uint32_t index)
+	{
+		const auto keyframe = cameraPath.Evaluate(static_cast<float>(index) / static_cast<float>(captureFps));
+		const auto extent = headless ? offscreenExtent : swapChain->Extent;
+
+		scene->GetCamera() = Camera(keyframe.position, keyframe.lookAt, keyframe.fov,
+		                            static_cast<float>(extent.width) / static_cast<float>(extent.height));
+
+		captureFrame = index;
+		captureRecorded = false;
+		captureAperture = keyframe.aperture;
+
+		ResetAccumulation();
+	}
+
+	/*
+	 * The frame which has recorded the readback of the previous path frame has been submitted before,
+	 * thus the accumulation can be reset for the next one. The capture overrides the stop criteria.
+	 */
+	void Application::UpdateCapture()
+	{
+		if (!captureFrame)
+			return;
+
+		if (captureRecorded)
 		{
-			// Otherwise use image copy (requires us to manually flip components)
-			VkImageCopy imageCopyRegion{};
-			imageCopyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageCopyRegion.srcSubresource.layerCount = 1;
-			imageCopyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageCopyRegion.dstSubresource.layerCount = 1;
-			imageCopyRegion.extent.width = swapChain->Extent.width;
-			imageCopyRegion.extent.height = swapChain->Extent.height;
-			imageCopyRegion.extent.depth = 1;
-
-			// Issue the copy command
-			vkCmdCopyImage(
-				copyCmd,
-				srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1,
-				&imageCopyRegion);
-		}
-
-		// Transition destination image to general layout, which is the required layout for mapping the image memory later on
-		insertImageMemoryBarrier(
-			copyCmd,
-			dstImage,
-			VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_ACCESS_MEMORY_READ_BIT,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_GENERAL,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-		// Transition back the swap chain image after the blit is done
-		insertImageMemoryBarrier(
-			copyCmd,
-			srcImage,
-			VK_ACCESS_TRANSFER_READ_BIT,
-			VK_ACCESS_MEMORY_READ_BIT,
-			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-		vkEndCommandBuffer(copyCmd);
-
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pCommandBuffers = &copyCmd;
-		submitInfo.commandBufferCount = 1;
-
-		vkQueueSubmit(device->GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(device->GraphicsQueue);
-
-		// Get layout of the image (including row pitch)
-		VkImageSubresource subResource { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 };
-		VkSubresourceLayout subResourceLayout;
-		vkGetImageSubresourceLayout(device->Get(), dstImage, &subResource, &subResourceLayout);
-
-		// Map image memory so we can start copying from it
-		const char* data;
-		vkMapMemory(device->Get(), dstImageMemory, 0, VK_WHOLE_SIZE, 0, (void**)&data);
-		data += subResourceLayout.offset;
-
-		std::ofstream file(name, std::ios::out | std::ios::binary);
-
-		// ppm header
-		file << "P6\n" << swapChain->Extent.width << "\n" << swapChain->Extent.height << "\n255\n";
-
-		// If source is BGR (destination is always RGB) and we can't use blit (which does automatic conversion), we'll have to manually swizzle color components
-		bool colorSwizzle = false;
-		// Check if source is BGR
-		// Note: Not complete, only contains most common and basic BGR surface formats for demonstration purposes
-		if (!supportsBlit)
-		{
-			std::vector<VkFormat> formatsBGR = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_B8G8R8A8_SNORM };
-			colorSwizzle = (std::find(formatsBGR.begin(), formatsBGR.end(), swapChain->Format) != formatsBGR.end());
-		}
-
-		// ppm binary pixel data
-		for (uint32_t y = 0; y < swapChain->Extent.height; y++)
-		{
-			unsigned int *row = (unsigned int*)data;
-			for (uint32_t x = 0; x < swapChain->Extent.width; x++)
+			if (*captureFrame + 1 == captureFrames)
 			{
-				if (colorSwizzle)
-				{
-					file.write((char*)row+2, 1);
-					file.write((char*)row+1, 1);
-					file.write((char*)row, 1);
-				}
-				else
-				{
-					file.write((char*)row, 3);
-				}
-				row++;
+				std::cout << "[CAPTURE] " << captureFrames << " frames have been rendered" << std::endl;
+				captureFrame.reset();
+				return;
 			}
-			data += subResourceLayout.rowPitch;
+
+			ApplyCaptureFrame(*captureFrame + 1);
+		}
+
+		settings.TargetSamples = captureSamples;
+		settings.TimeBudget = captureTimeBudget;
+		settings.TargetError = 0.f;
+	}
+
+	/*
+	 * The finished path frame is read back by the render commands like a screenshot or an export,
+	 * the encoding overlaps the trace of the following frames. A frame still waiting for its
+	 * readback to be handed over to the writer delays the capture by a frame in flight.
+	 */
+	void Application::RecordCapture(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex)
+	{
+		if (!captureFrame || captureRecorded || !traceStopped)
+			return;
+
+		const auto path = ImageWriter::Numbered(capturePattern, *captureFrame);
+
+		if (ImageWriter::IsFloatFormat(capturePattern))
+		{
+			if (readbackFrame)
+				return;
+
+			RecordReadback(commandBuffer, false);
+
+			readbackFrame = frameIndex;
+			readbackPath = path;
+			readbackAOVs = false;
+		}
+		else
+		{
+			if (screenshotPaths[frameIndex])
+				return;
+
+			RecordScreenshot(commandBuffer, frameIndex, imageIndex, path);
 		}
-		file.close();
 
-		// Clean up resources
-		vkUnmapMemory(device->Get(), dstImageMemory);
-		vkFreeMemory(device->Get(), dstImageMemory, nullptr);
-		vkDestroyImage(device->Get(), dstImage, nullptr);
+		captureRecorded = true;
 	}
 
 	const char* scenes[18] = {
@@ -633,8 +1005,88 @@ namespace Tracer
 		"Furnace"
 	};
 
+	/*
+	 * Renders the jobs back to back on the same device. Every job traces until its target samples
+	 * or time budget has been reached, then the output of the last frame is written.
+	 * Workers publish the accumulation instead and claim the next task of the coordinator.
+	 */
+	void Application::RunJobs()
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < jobs.size(); ++i)
+		{
+			if (i > 0)
+				BeginJob(i);
+
+			const auto& job = jobs[i];
+
+			std::cout << "[HEADLESS] Job " << i + 1 << "/" << jobs.size() << ": rendering " << job.ScenePath <<
+				" at " << offscreenExtent.width << "x" << offscreenExtent.height << " into " << job.OutputPath <<
+				std::endl;
+
+			while (!traceStopped || captureFrame)
+				DrawFrame();
+
+			device->WaitIdle();
+
+			// The frames of the camera path have been read back by the render loop
+			if (job.Fps > 0)
+			{
+				FlushReadback();
+				continue;
+			}
+
+			// The radiance is encoded and written while the next job renders
+			if (ImageWriter::IsFloatFormat(job.OutputPath))
+			{
+				Vulkan::Command::Submit(*commandPool, [&](VkCommandBuffer commandBuffer)
+				{
+					RecordReadback(commandBuffer, job.WriteAOVs);
+				});
+
+				PushReadback(job.OutputPath, job.WriteAOVs);
+				continue;
+			}
+
+			if (options.WorkerPath.empty())
+			{
+				// The last frame has copied the output into its offscreen image
+				Vulkan::Command::Submit(*commandPool, [&](VkCommandBuffer commandBuffer)
+				{
+					screenshots->Record(commandBuffer, 0, swapChain->GetImage()[imageIndex], VK_IMAGE_LAYOUT_GENERAL);
+				});
+
+				screenshotPaths[0] = job.OutputPath;
+				PushScreenshot(0);
+				continue;
+			}
+
+			Coordinator::WriteAccumulation(job.OutputPath, offscreenExtent.width, offscreenExtent.height,
+			                               ReadAccumulation());
+			lease.reset();
+
+			ClaimTask();
+		}
+
+		writer->Wait();
+
+		const auto seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "[HEADLESS] " << jobs.size() << " jobs in " << seconds << " s, " <<
+			3600.f * static_cast<float>(jobs.size()) / seconds << " jobs per hour." << std::endl;
+	}
+
 	void Application::Run()
 	{
+		if (headless)
+		{
+			if (!terminate)
+				RunJobs();
+
+			return;
+		}
+
 		static int frameCounter = 0;
 		static int64_t allFrameTimes = 0;
 
@@ -658,5 +1110,6 @@ namespace Tracer
 		}
 
 		device->WaitIdle();
+		FlushReadback();
 	}
 }
@@ -2,7 +2,15 @@
 
 #include "../Vulkan/Raytracer.h"
 #include "../Vulkan/Computer.h"
+#include "../Vulkan/FrameContext.h"
 
+#include "CameraPath.h"
+#include "Job.h"
+#include "Options.h"
+
+#include <array>
+#include <chrono>
+#include <optional>
 #include <string>
 
 namespace Tracer
@@ -15,29 +23,53 @@ namespace Tracer
 	class Application final : public Vulkan::Raytracer
 	{
 	public:
-		Application();
+		explicit Application(const Options& options);
 		~Application();
 
 		void Run() override;
 
 	private:
 		void RegisterCallbacks();
-		void UpdateUniformBuffer(uint32_t imageIndex) override;
-		void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void UpdateUniformBuffer(uint32_t frameIndex) override;
+		void RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes) override;
+		void RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t frameIndex,
+		            uint32_t imageIndex) override;
 		void LoadScene() override;
 		void UpdateSettings();
+		void UpdateCameraPath();
+		void CreateJobs();
+		void ClaimTask();
+		void ApplyJob();
+		void BeginJob(uint32_t index);
+		void RunJobs();
 		void CompileShaders() const;
 		void RecreateSwapChain();
 		void RecompileShaders();
 		void CreateMenu();
 		void ResetAccumulation();
+		void UpdateTraceLevel();
+		void UpdateTraceTile(uint32_t frameIndex);
+		void UpdateCompaction(uint32_t frameIndex);
+		void UpdateTermination(uint32_t frameIndex);
 		void ResizeWindow() const;
 		void CheckScenesFolder();
 		void PrintGPUInfo() const;
 		void CreateComputePipeline();
-		void ComputePipeline(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
-		void SaveImage(std::string const &name,  uint32_t imageIndex);
-		void CreateTmpImage();
+		void ComputePipeline(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+		void SaveImage(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+		void RecordScreenshot(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex,
+		                      const std::string& path);
+		void PushScreenshot(uint32_t frameIndex);
+		void ExportImage(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void PushReadback(const std::string& path, bool aovs);
+		void FlushReadback();
+		void CreateReadbackRing();
+		bool StartCapture(const std::string& pattern, int fps, int samples, int timeBudget);
+		void ApplyCaptureFrame(uint32_t index);
+		void UpdateCapture();
+		void RecordCapture(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+		void DumpTelemetry() const;
 
 		// User interface API
 		void OnKeyChanged(int key, int scanCode, int action, int mods) override;
@@ -45,14 +77,48 @@ namespace Tracer
 		void OnMouseButtonChanged(int button, int action, int mods) override;
 		void OnScrollChanged(double xoffset, double yoffset) override;
 
+		const Options options;
+		std::vector<Job> jobs;
+		uint32_t currentJob = 0;
+		std::unique_ptr<class Camera> sceneCamera;
 		std::unique_ptr<class Menu> menu;
 		std::unique_ptr<class Compiler> compiler;
 		std::unique_ptr<class Vulkan::Computer> computer;
-		std::unique_ptr<class Vulkan::Image> tmpImage;
+		std::unique_ptr<class Vulkan::ReadbackRing> screenshots;
+		std::unique_ptr<class ImageWriter> writer;
+		std::unique_ptr<class Lease> lease; // Claim of the task rendered by a worker
 
 		uint32_t frame = 0;
+		uint32_t sampleIndex = 1; // One based index of the first sample traced by the frame
+		uint32_t framesSinceTraceLevelChange = 0;
+		std::chrono::steady_clock::time_point lastFrameTime = std::chrono::steady_clock::now();
+		uint32_t tileRow = 0;
+		uint32_t tileHeight = MIN_TILE_HEIGHT;
+		std::array<uint32_t, Vulkan::FrameContext::MAX_FRAMES_IN_FLIGHT> tracedRows{};
+		uint32_t lastCompaction = 0;
+		std::array<bool, Vulkan::FrameContext::MAX_FRAMES_IN_FLIGHT> errorMeasured{};
+		std::optional<float> estimatedError;
+		std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+		float postProcessTime = 0.f;
+		uint32_t postProcessFrames = 0;
+		std::optional<uint32_t> readbackFrame; // Frame in flight which has recorded the pending export
+		std::string readbackPath;
+		bool readbackAOVs = false;
+		std::array<std::optional<std::string>, Vulkan::FrameContext::MAX_FRAMES_IN_FLIGHT> screenshotPaths{};
+		uint32_t capturedFrames = 0;
+		CameraPath cameraPath;
+		std::optional<uint32_t> captureFrame; // Frame of the camera path being rendered
+		uint32_t captureFrames = 0;
+		bool captureRecorded = false; // The readback of the frame has been recorded, the next frame follows
+		std::string capturePattern;
+		int captureFps = 0;
+		int captureSamples = 0;
+		int captureTimeBudget = 0;
+		float captureAperture = 0.f;
+
+		static constexpr uint32_t MIN_TILE_HEIGHT = 16;
 		uint32_t imageIndex = 0;
-		bool terminate;
+		bool terminate = false;
 		bool newScene = false;
 	};
 }
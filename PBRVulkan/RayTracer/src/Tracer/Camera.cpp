@@ -125,6 +125,16 @@ namespace Tracer
 		return position;
 	}
 
+	float Camera::GetFov() const
+	{
+		return fov;
+	}
+
+	void Camera::SetAspect(float aspect)
+	{
+		this->aspect = aspect;
+	}
+
 	void Camera::TimeDeltaUpdate()
 	{
 		const auto currentFrame = static_cast<float>(glfwGetTime());
@@ -28,6 +28,9 @@ namespace Tracer
 
 		void static TimeDeltaUpdate();
 
+		// Headless renders might override the resolution of the scene
+		void SetAspect(float aspect);
+
 		[[nodiscard]] glm::mat4 GetView() const;
 
 		[[nodiscard]] glm::mat4 GetProjection() const;
@@ -36,6 +39,8 @@ namespace Tracer
 
 		[[nodiscard]] glm::vec3 GetPosition() const;
 
+		[[nodiscard]] float GetFov() const;
+
 	private:
 		void Update();
 
@@ -0,0 +1,131 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "../Loader/Loader.h"
+#include "../Loader/RenderOptions.h"
+#include "../Assets/Light.h"
+#include "../Assets/Material.h"
+#include "../Assets/Mesh.h"
+#include "../Assets/Primitive.h"
+
+namespace Tracer
+{
+	namespace
+	{
+		template <typename T>
+		T CatmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t)
+		{
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+
+			return 0.5f * (2.f * p1 + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 +
+				(3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+		}
+
+		// Path files are scene files with Keyframe blocks only, the other assets are ignored
+		class PathScene final : public Loader::SceneBase
+		{
+		public:
+			explicit PathScene(CameraPath& path): path(path) { }
+
+			void AddKeyframe(const Keyframe& keyframe) override
+			{
+				path.Add(keyframe);
+			}
+
+			void AddCamera(glm::vec3, glm::vec3, float, float) override { }
+			void AddHDR(const std::string&) override { }
+			int AddMesh(const std::string&) override { return -1; }
+			int AddTexture(const std::string&) override { return -1; }
+			int AddMaterial(Assets::Material) override { return 0; }
+			int AddLight(Assets::Light) override { return 0; }
+			int AddMeshInstance(Assets::MeshInstance) override { return 0; }
+			int AddPrimitive(Assets::Primitive) override { return 0; }
+
+		private:
+			CameraPath& path;
+		};
+	}
+
+	void CameraPath::Add(const Keyframe& keyframe)
+	{
+		const auto position = std::upper_bound(keyframes.begin(), keyframes.end(), keyframe.time,
+		                                       [](float time, const Keyframe& other) { return time < other.time; });
+
+		keyframes.insert(position, keyframe);
+	}
+
+	void CameraPath::Clear()
+	{
+		keyframes.clear();
+	}
+
+	Keyframe CameraPath::Evaluate(float time) const
+	{
+		if (keyframes.empty())
+			throw std::runtime_error("The camera path has no keyframes");
+
+		time = std::clamp(time + keyframes.front().time, keyframes.front().time, keyframes.back().time);
+
+		const auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+		                                   [](float time, const Keyframe& other) { return time < other.time; });
+
+		if (next == keyframes.end())
+			return keyframes.back();
+
+		const auto i = static_cast<size_t>(next - keyframes.begin()) - 1;
+		const auto& k0 = keyframes[i > 0 ? i - 1 : i];
+		const auto& k1 = keyframes[i];
+		const auto& k2 = keyframes[i + 1];
+		const auto& k3 = keyframes[std::min(i + 2, keyframes.size() - 1)];
+
+		const float t = k2.time > k1.time ? (time - k1.time) / (k2.time - k1.time) : 0.f;
+
+		Keyframe keyframe{};
+		keyframe.time = time;
+		keyframe.position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+		keyframe.lookAt = CatmullRom(k0.lookAt, k1.lookAt, k2.lookAt, k3.lookAt, t);
+		// The spline overshoots between distant values
+		keyframe.fov = std::clamp(CatmullRom(k0.fov, k1.fov, k2.fov, k3.fov, t), 1.f, 179.f);
+		keyframe.aperture = std::max(CatmullRom(k0.aperture, k1.aperture, k2.aperture, k3.aperture, t), 0.f);
+
+		return keyframe;
+	}
+
+	void CameraPath::Save(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+
+		for (const auto& keyframe : keyframes)
+		{
+			const auto& p = keyframe.position;
+			const auto& l = keyframe.lookAt;
+
+			file << "Keyframe\n{\n" <<
+				"\ttime " << keyframe.time << "\n" <<
+				"\tposition " << p.x << " " << p.y << " " << p.z << "\n" <<
+				"\tlookAt " << l.x << " " << l.y << " " << l.z << "\n" <<
+				"\tfov " << keyframe.fov << "\n" <<
+				"\taperture " << keyframe.aperture << "\n" <<
+				"}\n\n";
+		}
+
+		if (!file)
+			throw std::runtime_error("Failed to write the camera path " + path);
+	}
+
+	CameraPath CameraPath::Load(const std::string& path)
+	{
+		CameraPath cameraPath;
+		PathScene scene(cameraPath);
+		Loader::RenderOptions options;
+
+		if (!Loader::LoadSceneFromFile(path, scene, options))
+			throw std::runtime_error("Failed to load the camera path " + path);
+
+		return cameraPath;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Tracer
+{
+	struct Keyframe
+	{
+		float time; // Seconds from the start of the path
+		glm::vec3 position;
+		glm::vec3 lookAt;
+		float fov;
+		float aperture;
+	};
+
+	/*
+	 * Keyframed camera move, every property is interpolated with a Catmull-Rom spline through the keyframes.
+	 * Paths are stored as Keyframe blocks of the scene file format, thus they can be pasted into a scene file:
+	 *
+	 * Keyframe
+	 * {
+	 *     time 0
+	 *     position 0 1 5
+	 *     lookAt 0 1 0
+	 *     fov 45
+	 *     aperture 0
+	 * }
+	 */
+	class CameraPath final
+	{
+	public:
+		// Keyframes are kept sorted by their time
+		void Add(const Keyframe& keyframe);
+		void Clear();
+
+		// Seconds from the first keyframe, the first and the last keyframe are held outside of the path
+		[[nodiscard]] Keyframe Evaluate(float time) const;
+
+		void Save(const std::string& path) const;
+		static CameraPath Load(const std::string& path);
+
+		[[nodiscard]] const std::vector<Keyframe>& GetKeyframes() const
+		{
+			return keyframes;
+		}
+
+		[[nodiscard]] float GetDuration() const
+		{
+			return keyframes.empty() ? 0.f : keyframes.back().time - keyframes.front().time;
+		}
+
+	private:
+		std::vector<Keyframe> keyframes;
+	};
+}
@@ -28,6 +28,8 @@ namespace Tracer
 		std::string RAY_MISS_SHADER = "src/Assets/Shaders/Raytracer/Raytracing";
 		std::string RAY_SHADOW_SHADER = "src/Assets/Shaders/Raytracer/Shadow";
 		std::string RAY_GEN_SHADER = "src/Assets/Shaders/Raytracer/Raytracing";
+		std::string RAY_PROCEDURAL_SHADER = "src/Assets/Shaders/Raytracer/Procedural";
+		std::string RAY_LIGHT_SHADER = "src/Assets/Shaders/Raytracer/Light";
 
 		std::map<Include, std::string> INCLUDES = {
 			{Include::PATH_TRACER_DEFAULT, "#include \"Integrators/PathTracer.glsl\""},
@@ -44,7 +46,11 @@ namespace Tracer
 			{ShaderType::RAY_HIT, {RAY_HIT_SHADER, ".rchit"}},
 			{ShaderType::RAY_MISS, {RAY_MISS_SHADER, ".rmiss"}},
 			{ShaderType::RAY_GEN, {RAY_GEN_SHADER, ".rgen"}},
-			{ShaderType::RAY_SHADOW, {RAY_SHADOW_SHADER, ".rmiss"}}
+			{ShaderType::RAY_SHADOW, {RAY_SHADOW_SHADER, ".rmiss"}},
+			{ShaderType::RAY_INTERSECTION, {RAY_PROCEDURAL_SHADER, ".rint"}},
+			{ShaderType::RAY_PROCEDURAL_HIT, {RAY_PROCEDURAL_SHADER, ".rchit"}},
+			{ShaderType::RAY_LIGHT_INTERSECTION, {RAY_LIGHT_SHADER, ".rint"}},
+			{ShaderType::RAY_LIGHT_HIT, {RAY_LIGHT_SHADER, ".rchit"}}
 		};
 	}
 
@@ -88,7 +94,7 @@ namespace Tracer
 		auto output_folder = root / ".." / "Assets" / "Shaders";
 		auto shaders = root / "src" / "Assets" / "Shaders";
 		std::vector<std::string> extensionsToCheck = {
-			".frag", ".vert", ".comp", ".compiled.rchit", ".compiled.rgen", ".compiled.rmiss"
+			".frag", ".vert", ".comp", ".compiled.rchit", ".compiled.rgen", ".compiled.rmiss", ".compiled.rint"
 		};
 
 		std::filesystem::create_directory(output_folder);
@@ -119,6 +125,12 @@ namespace Tracer
 	 */
 	void Compiler::Compile(std::vector<Parser::Include> includes, std::vector<Parser::Define> defines) const
 	{
+		if (compiled && includes == compiledIncludes && defines == compiledDefines)
+		{
+			std::cout << "[COMPILER] Shaders are up to date." << std::endl;
+			return;
+		}
+
 		std::cout << "[COMPILER] Shaders compilation has begun." << std::endl;
 
 		for (const auto& pair : Parser::SHADERS)
@@ -160,6 +172,10 @@ namespace Tracer
 
 		GlslangValidator();
 
+		compiled = true;
+		compiledIncludes = std::move(includes);
+		compiledDefines = std::move(defines);
+
 		std::cout << "[COMPILER] Shaders compilation has ended." << std::endl;
 	}
 }
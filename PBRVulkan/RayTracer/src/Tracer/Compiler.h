@@ -29,7 +29,11 @@ namespace Tracer
 			RAY_GEN,
 			RAY_MISS,
 			RAY_SHADOW,
-			RAY_HIT
+			RAY_HIT,
+			RAY_INTERSECTION,
+			RAY_PROCEDURAL_HIT,
+			RAY_LIGHT_INTERSECTION,
+			RAY_LIGHT_HIT
 		};
 	}
 
@@ -46,5 +50,10 @@ namespace Tracer
 		void Read() const;
 		void GlslangValidator() const;
 		std::filesystem::path root;
+
+		// The shaders on disk are up to date while the includes and defines do not change
+		mutable bool compiled = false;
+		mutable std::vector<Parser::Include> compiledIncludes;
+		mutable std::vector<Parser::Define> compiledDefines;
 	};
 }
@@ -0,0 +1,335 @@
+#include "Coordinator.h"
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <utility>
+#include <iostream>
+#include <thread>
+
+namespace Tracer
+{
+	namespace
+	{
+		const char* DONE = "done";
+		const char* ACCUMULATION_HEADER = "ACCUM";
+		constexpr auto POLL_INTERVAL = std::chrono::milliseconds(100);
+		// Claims which have not been renewed for the lease are handed to another worker
+		constexpr auto CLAIM_LEASE = std::chrono::seconds(120);
+		constexpr auto RENEWAL_INTERVAL = std::chrono::seconds(15);
+		constexpr int MAX_REISSUES = 3;
+
+		std::filesystem::path TaskPath(const std::filesystem::path& directory, int task, const char* extension)
+		{
+			return directory / ("task_" + std::to_string(task) + extension);
+		}
+
+		// Files of every task extension, including the tasks of a previous render with more tasks
+		void RemoveTasks(const std::filesystem::path& directory, const std::string& extension = "")
+		{
+			std::vector<std::filesystem::path> files;
+
+			for (const auto& entry : std::filesystem::directory_iterator(directory))
+			{
+				const auto name = entry.path().filename().string();
+
+				if (name.rfind("task_", 0) == 0 && (extension.empty() || entry.path().extension() == extension))
+					files.push_back(entry.path());
+			}
+
+			for (const auto& file : files)
+				std::filesystem::remove(file);
+		}
+
+		// Readers never see a partially written file
+		void Publish(const std::filesystem::path& path, const std::function<void(std::ofstream&)>& write)
+		{
+			auto temporary = path;
+			temporary += ".tmp";
+
+			{
+				std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+				write(file);
+
+				if (!file)
+					throw std::runtime_error("Failed to write " + temporary.string());
+			}
+
+			std::filesystem::rename(temporary, path);
+		}
+
+		std::vector<float> ReadAccumulation(const std::filesystem::path& path, uint32_t& width, uint32_t& height)
+		{
+			std::ifstream file(path, std::ios::binary);
+			std::string header;
+
+			file >> header >> width >> height;
+			file.get();
+
+			if (header != ACCUMULATION_HEADER)
+				throw std::runtime_error("Invalid accumulation file " + path.string());
+
+			std::vector<float> rgba(4 * static_cast<size_t>(width) * height);
+			file.read(reinterpret_cast<char*>(rgba.data()),
+			          static_cast<std::streamsize>(sizeof(float) * rgba.size()));
+
+			if (!file)
+				throw std::runtime_error("Truncated accumulation file " + path.string());
+
+			return rgba;
+		}
+	}
+
+	Coordinator::Coordinator(const Options& options): options(options), directory(options.CoordinatorPath) { }
+
+	void Coordinator::Run() const
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		std::filesystem::create_directories(directory);
+		std::filesystem::remove(directory / DONE);
+
+		WriteTasks();
+		WaitForTasks();
+		Merge();
+
+		// Re-issued tasks whose first worker has finished after all
+		RemoveTasks(directory, ".task");
+
+		std::ofstream(directory / DONE).close();
+
+		const auto seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "[COORDINATOR] " << options.Samples << " samples in " << options.Tasks <<
+			" tasks have been merged into " << options.OutputPath << " in " << seconds << " s" << std::endl;
+	}
+
+	void Coordinator::WriteTasks() const
+	{
+		const auto scene = std::filesystem::absolute(options.ScenePath).string();
+		uint32_t first = 0;
+
+		RemoveTasks(directory);
+
+		for (int task = 0; task < options.Tasks; ++task)
+		{
+			// The remainder goes to the first tasks
+			const int samples = options.Samples / options.Tasks + (task < options.Samples % options.Tasks ? 1 : 0);
+			const auto output = std::filesystem::absolute(TaskPath(directory, task, ".accum")).string();
+
+			Publish(TaskPath(directory, task, ".task"), [&](std::ofstream& file)
+			{
+				file << "scene=" << scene << " output=" << output << " spp=" << samples << " first=" << first;
+
+				if (options.Width > 0)
+					file << " width=" << options.Width << " height=" << options.Height;
+
+				file << std::endl;
+			});
+
+			first += static_cast<uint32_t>(samples);
+		}
+
+		std::cout << "[COORDINATOR] " << options.Tasks << " tasks have been written to " << directory.string() <<
+			std::endl;
+	}
+
+	/*
+	 * Workers renew their claims while they own them. A claim which has expired belongs to a worker which
+	 * has crashed or lost the shared directory, the task is renamed back and claimed by another worker.
+	 * The lease runs on the clock of the coordinator from the last change of the claim it has seen,
+	 * thus neither the time kept by a fresh rename nor the clocks of the workers expire a claim.
+	 * A task abandoned too often is assumed to crash every worker and fails the render.
+	 */
+	void Coordinator::WaitForTasks() const
+	{
+		int finished = 0;
+		std::vector<int> reissues(options.Tasks, 0);
+		std::vector<std::optional<std::filesystem::file_time_type>> renewals(options.Tasks);
+		std::vector<std::chrono::steady_clock::time_point> renewedAt(options.Tasks);
+
+		while (finished < options.Tasks)
+		{
+			std::this_thread::sleep_for(POLL_INTERVAL);
+
+			int count = 0;
+
+			for (int task = 0; task < options.Tasks; ++task)
+			{
+				if (std::filesystem::exists(TaskPath(directory, task, ".accum")))
+				{
+					++count;
+					continue;
+				}
+
+				const auto claimed = TaskPath(directory, task, ".claimed");
+
+				std::error_code error;
+				const auto renewed = std::filesystem::last_write_time(claimed, error);
+				const auto now = std::chrono::steady_clock::now();
+
+				if (error)
+				{
+					renewals[task].reset();
+					continue;
+				}
+
+				if (renewals[task] != renewed)
+				{
+					renewals[task] = renewed;
+					renewedAt[task] = now;
+				}
+
+				if (now - renewedAt[task] < CLAIM_LEASE)
+					continue;
+
+				renewals[task].reset();
+
+				if (++reissues[task] > MAX_REISSUES)
+				{
+					throw std::runtime_error(claimed.filename().string() + " has been abandoned by " +
+						std::to_string(reissues[task]) + " workers");
+				}
+
+				std::filesystem::rename(claimed, TaskPath(directory, task, ".task"), error);
+
+				if (!error)
+				{
+					std::cout << "[COORDINATOR] " << claimed.filename().string() <<
+						" has expired and has been issued again" << std::endl;
+				}
+			}
+
+			if (count != finished)
+				std::cout << "[COORDINATOR] " << count << "/" << options.Tasks << " tasks have finished" << std::endl;
+
+			finished = count;
+		}
+	}
+
+	/*
+	 * Pixels are weighted by their sample counts, which differ between tasks with the adaptive sampling.
+	 */
+	void Coordinator::Merge() const
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<float> merged;
+
+		for (int task = 0; task < options.Tasks; ++task)
+		{
+			uint32_t taskWidth, taskHeight;
+			const auto rgba = ReadAccumulation(TaskPath(directory, task, ".accum"), taskWidth, taskHeight);
+
+			if (merged.empty())
+			{
+				width = taskWidth;
+				height = taskHeight;
+				merged.assign(rgba.size(), 0.f);
+			}
+			else if (taskWidth != width || taskHeight != height)
+			{
+				throw std::runtime_error("Tasks have been rendered at different resolutions");
+			}
+
+			for (size_t i = 0; i < rgba.size(); ++i)
+				merged[i] += rgba[i];
+		}
+
+		ImageWriter::Write(options.OutputPath, width, height, merged, true);
+	}
+
+	std::optional<Job> Coordinator::ClaimTask(const std::filesystem::path& directory)
+	{
+		// Workers might be started before the coordinator
+		std::filesystem::create_directories(directory);
+
+		while (true)
+		{
+			std::vector<std::filesystem::path> tasks;
+
+			for (const auto& entry : std::filesystem::directory_iterator(directory))
+			{
+				if (entry.path().extension() == ".task")
+					tasks.push_back(entry.path());
+			}
+
+			std::sort(tasks.begin(), tasks.end());
+
+			for (const auto& task : tasks)
+			{
+				auto claimed = task;
+				claimed.replace_extension(".claimed");
+
+				// The rename is atomic, only one worker claims the task
+				std::error_code error;
+				std::filesystem::rename(task, claimed, error);
+
+				if (error)
+					continue;
+
+				std::string line;
+				std::getline(std::ifstream(claimed), line);
+
+				RenewClaim(claimed.string());
+
+				// The coordinator has issued an expired claim again before it has been read
+				if (line.empty() || !std::filesystem::exists(claimed))
+					continue;
+
+				std::cout << "[WORKER] " << task.filename().string() << " has been claimed" << std::endl;
+
+				return Job::Parse(line);
+			}
+
+			if (std::filesystem::exists(directory / DONE))
+				return std::nullopt;
+
+			std::this_thread::sleep_for(POLL_INTERVAL);
+		}
+	}
+
+	void Coordinator::RenewClaim(const std::string& path)
+	{
+		auto claimed = std::filesystem::path(path);
+		claimed.replace_extension(".claimed");
+
+		// The coordinator might have issued the task again, the accumulation is still published
+		std::error_code error;
+		std::filesystem::last_write_time(claimed, std::filesystem::file_time_type::clock::now(), error);
+	}
+
+	void Coordinator::WriteAccumulation(const std::string& path, uint32_t width, uint32_t height,
+	                                    const std::vector<float>& rgba)
+	{
+		Publish(path, [&](std::ofstream& file)
+		{
+			file << ACCUMULATION_HEADER << "\n" << width << " " << height << "\n";
+			file.write(reinterpret_cast<const char*>(rgba.data()),
+			           static_cast<std::streamsize>(sizeof(float) * rgba.size()));
+		});
+	}
+
+	Lease::Lease(std::string path): path(std::move(path)), thread([this]() { Loop(); }) { }
+
+	Lease::~Lease()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+
+		wakeUp.notify_all();
+		thread.join();
+	}
+
+	void Lease::Loop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (!wakeUp.wait_for(lock, RENEWAL_INTERVAL, [this]() { return stop; }))
+			Coordinator::RenewClaim(path);
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Vulkan/Vulkan_api.h"
+
+#include "Job.h"
+#include "Options.h"
+
+namespace Tracer
+{
+	/*
+	 * Distributed render over a shared directory, the coordinator itself does not use the GPU.
+	 * The samples per pixel are split into disjoint ranges, each written as a <task>.task job.
+	 * A worker claims a task by renaming it to <task>.claimed, renders it headless with the seeds of its
+	 * sample range and publishes the radiance sums and sample counts of every pixel as <task>.accum.
+	 * Claims expire unless the worker renews them, a task of a crashed worker is issued again.
+	 * Once all ranges have landed the coordinator merges them and writes a done marker, which stops the workers.
+	 */
+	class Coordinator final
+	{
+	public:
+		NON_COPIABLE(Coordinator)
+
+		explicit Coordinator(const Options& options);
+		~Coordinator() = default;
+
+		void Run() const;
+
+		// Blocks until a task has been claimed, empty once the coordinator has finished
+		static std::optional<Job> ClaimTask(const std::filesystem::path& directory);
+
+		// Keeps the claim of the task with the given accumulation path from expiring
+		static void RenewClaim(const std::string& path);
+
+		// Sums of the radiance and the sample counts as RGBA
+		static void WriteAccumulation(const std::string& path, uint32_t width, uint32_t height,
+		                              const std::vector<float>& rgba);
+
+	private:
+		void WriteTasks() const;
+		void WaitForTasks() const;
+		void Merge() const;
+
+		const Options options;
+		const std::filesystem::path directory;
+	};
+
+	/*
+	 * Renews the claim of a task on a background thread while the worker owns it, thus loading the scene,
+	 * compiling the shaders and building the acceleration structures never expire the claim.
+	 * The claim is owned from ClaimTask() until the accumulation has been published.
+	 */
+	class Lease final
+	{
+	public:
+		NON_COPIABLE(Lease)
+
+		explicit Lease(std::string path);
+		~Lease();
+
+	private:
+		void Loop();
+
+		const std::string path;
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		bool stop = false;
+		std::thread thread;
+	};
+}
@@ -0,0 +1,325 @@
+#include "ImageWriter.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Tracer
+{
+	namespace
+	{
+		constexpr int JPEG_QUALITY = 95;
+
+		template <typename T>
+		void Append(std::vector<char>& bytes, const T& value)
+		{
+			const auto* data = reinterpret_cast<const char*>(&value);
+			bytes.insert(bytes.end(), data, data + sizeof(T));
+		}
+
+		void AppendAttribute(std::vector<char>& bytes, const std::string& name, const std::string& type,
+		                     const std::vector<char>& value)
+		{
+			bytes.insert(bytes.end(), name.c_str(), name.c_str() + name.size() + 1);
+			bytes.insert(bytes.end(), type.c_str(), type.c_str() + type.size() + 1);
+			Append(bytes, static_cast<int32_t>(value.size()));
+			bytes.insert(bytes.end(), value.begin(), value.end());
+		}
+
+		std::vector<float> ToRGB(const std::vector<float>& rgba, bool average)
+		{
+			std::vector<float> rgb(rgba.size() / 4 * 3);
+
+			for (size_t i = 0; i < rgba.size() / 4; ++i)
+			{
+				const float* pixel = &rgba[4 * i];
+				const float scale = !average ? 1.f : pixel[3] > 0.f ? 1.f / pixel[3] : 0.f;
+
+				for (int c = 0; c < 3; ++c)
+					rgb[3 * i + c] = pixel[c] * scale;
+			}
+
+			return rgb;
+		}
+
+		// Portable float map, the rows are stored from the bottom to the top
+		void WritePFM(std::ofstream& file, uint32_t width, uint32_t height, const std::vector<float>& rgb)
+		{
+			file << "PF\n" << width << " " << height << "\n-1.0\n";
+
+			const auto rowSize = static_cast<std::streamsize>(sizeof(float) * 3 * width);
+
+			for (uint32_t y = height; y-- > 0;)
+				file.write(reinterpret_cast<const char*>(&rgb[3 * static_cast<size_t>(y) * width]), rowSize);
+		}
+
+		/*
+		 * Uncompressed scanline OpenEXR with 32-bit float channels, the channels are sorted by name.
+		 * Every scanline is a chunk of its own, thus the offset table has an entry per row.
+		 */
+		void WriteEXR(std::ofstream& file, uint32_t width, uint32_t height, const std::vector<float>& rgb)
+		{
+			constexpr int32_t FLOAT = 2;
+
+			std::vector<char> channels;
+
+			for (const char* name : { "B", "G", "R" })
+			{
+				channels.insert(channels.end(), name, name + 2);
+				Append(channels, FLOAT);
+				Append(channels, int32_t{}); // pLinear and reserved bytes
+				Append(channels, int32_t{ 1 });
+				Append(channels, int32_t{ 1 });
+			}
+
+			channels.push_back('\0');
+
+			std::vector<char> window;
+
+			for (const int32_t value : { 0, 0, static_cast<int32_t>(width) - 1, static_cast<int32_t>(height) - 1 })
+				Append(window, value);
+
+			std::vector<char> header;
+
+			Append(header, int32_t{ 20000630 }); // Magic number
+			Append(header, int32_t{ 2 }); // Version, single part scanline file
+
+			AppendAttribute(header, "channels", "chlist", channels);
+			AppendAttribute(header, "compression", "compression", { 0 });
+			AppendAttribute(header, "dataWindow", "box2i", window);
+			AppendAttribute(header, "displayWindow", "box2i", window);
+			AppendAttribute(header, "lineOrder", "lineOrder", { 0 });
+
+			std::vector<char> one, center;
+			Append(one, 1.f);
+			Append(center, 0.f);
+			Append(center, 0.f);
+
+			AppendAttribute(header, "pixelAspectRatio", "float", one);
+			AppendAttribute(header, "screenWindowCenter", "v2f", center);
+			AppendAttribute(header, "screenWindowWidth", "float", one);
+			header.push_back('\0');
+
+			const auto dataSize = static_cast<int32_t>(sizeof(float) * 3 * width);
+			const auto chunkSize = sizeof(int32_t) * 2 + dataSize;
+			const auto firstChunk = header.size() + sizeof(uint64_t) * height;
+
+			for (uint32_t y = 0; y < height; ++y)
+				Append(header, static_cast<uint64_t>(firstChunk + y * chunkSize));
+
+			file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+			std::vector<float> row(3 * static_cast<size_t>(width));
+
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				const float* pixels = &rgb[3 * static_cast<size_t>(y) * width];
+
+				// Planar channels in the order of the channel list
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					row[x] = pixels[3 * x + 2];
+					row[width + x] = pixels[3 * x + 1];
+					row[2 * width + x] = pixels[3 * x];
+				}
+
+				const auto line = static_cast<int32_t>(y);
+				file.write(reinterpret_cast<const char*>(&line), sizeof(line));
+				file.write(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
+				file.write(reinterpret_cast<const char*>(row.data()), dataSize);
+			}
+		}
+	}
+
+	ImageWriter::ImageWriter(uint32_t threads)
+	{
+		for (uint32_t i = 0; i < std::max(threads, 1u); ++i)
+			this->threads.emplace_back([this]() { Loop(); });
+	}
+
+	ImageWriter::~ImageWriter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+
+		wakeUp.notify_all();
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	void ImageWriter::Push(const std::string& path, uint32_t width, uint32_t height, std::vector<float> rgba,
+	                       bool average)
+	{
+		const auto bytes = rgba.size() * sizeof(float);
+
+		Enqueue(path, bytes, [path, width, height, rgba = std::move(rgba), average]()
+		{
+			Write(path, width, height, rgba, average);
+		});
+	}
+
+	void ImageWriter::Push(const std::string& path, uint32_t width, uint32_t height, std::vector<uint8_t> pixels,
+	                       bool bgr)
+	{
+		const auto bytes = pixels.size();
+
+		Enqueue(path, bytes, [path, width, height, pixels = std::move(pixels), bgr]()
+		{
+			Write(path, width, height, pixels, bgr);
+		});
+	}
+
+	void ImageWriter::Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		drained.wait(lock, [this]() { return tasks.empty() && busy == 0; });
+	}
+
+	void ImageWriter::Write(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgba,
+	                        bool average)
+	{
+		const auto rgb = ToRGB(rgba, average);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (std::filesystem::path(path).extension() == ".exr")
+			WriteEXR(file, width, height, rgb);
+		else
+			WritePFM(file, width, height, rgb);
+
+		if (!file)
+			throw std::runtime_error("Failed to write " + path);
+	}
+
+	void ImageWriter::Write(const std::string& path, uint32_t width, uint32_t height,
+	                        const std::vector<uint8_t>& pixels, bool bgr)
+	{
+		const auto count = static_cast<size_t>(width) * height;
+		std::vector<uint8_t> rgb(3 * count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			rgb[3 * i + 0] = pixels[4 * i + (bgr ? 2 : 0)];
+			rgb[3 * i + 1] = pixels[4 * i + 1];
+			rgb[3 * i + 2] = pixels[4 * i + (bgr ? 0 : 2)];
+		}
+
+		const auto extension = std::filesystem::path(path).extension();
+		const auto w = static_cast<int>(width);
+		const auto h = static_cast<int>(height);
+
+		int written = 1;
+
+		if (extension == ".png")
+			written = stbi_write_png(path.c_str(), w, h, 3, rgb.data(), 3 * w);
+		else if (extension == ".jpg" || extension == ".jpeg")
+			written = stbi_write_jpg(path.c_str(), w, h, 3, rgb.data(), JPEG_QUALITY);
+		else if (extension == ".bmp")
+			written = stbi_write_bmp(path.c_str(), w, h, 3, rgb.data());
+		else if (extension == ".tga")
+			written = stbi_write_tga(path.c_str(), w, h, 3, rgb.data());
+		else
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file << "P6\n" << width << "\n" << height << "\n255\n";
+			file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+			written = file ? 1 : 0;
+		}
+
+		if (!written)
+			throw std::runtime_error("Failed to write " + path);
+	}
+
+	bool ImageWriter::IsFloatFormat(const std::string& path)
+	{
+		const auto extension = std::filesystem::path(path).extension();
+		return extension == ".exr" || extension == ".pfm";
+	}
+
+	std::string ImageWriter::Numbered(const std::string& path, uint32_t number)
+	{
+		char suffix[16];
+		std::snprintf(suffix, sizeof(suffix), "_%05u", number);
+
+		std::filesystem::path numbered(path);
+		numbered.replace_filename(numbered.stem().string() + suffix + numbered.extension().string());
+
+		return numbered.string();
+	}
+
+	/*
+	 * An image larger than the whole budget is still accepted once the queue is empty.
+	 */
+	void ImageWriter::Enqueue(const std::string& path, size_t bytes, std::function<void()> task)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			drained.wait(lock, [this, bytes]() { return queuedBytes == 0 || queuedBytes + bytes <= MAX_QUEUED_BYTES; });
+
+			queuedBytes += bytes;
+
+			tasks.push({ bytes, [path, task = std::move(task)]()
+			{
+				const auto start = std::chrono::steady_clock::now();
+
+				task();
+
+				const auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start);
+				std::cout << "[WRITER] " << path << " has been written in " << ms.count() << " ms" << std::endl;
+			} });
+		}
+
+		wakeUp.notify_one();
+	}
+
+	/*
+	 * A failed write is reported and skipped, it must not terminate the renderer.
+	 */
+	void ImageWriter::Loop()
+	{
+		while (true)
+		{
+			Task task;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeUp.wait(lock, [this]() { return stop || !tasks.empty(); });
+
+				if (tasks.empty())
+					return;
+
+				task = std::move(tasks.front());
+				tasks.pop();
+				++busy;
+			}
+
+			drained.notify_all();
+
+			try
+			{
+				task.Run();
+			}
+			catch (const std::exception& exception)
+			{
+				std::cerr << "[WRITER] " << exception.what() << std::endl;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--busy;
+				queuedBytes -= task.Bytes;
+			}
+
+			drained.notify_all();
+		}
+	}
+}
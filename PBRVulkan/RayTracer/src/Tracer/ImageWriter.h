@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Vulkan/Vulkan_api.h"
+
+namespace Tracer
+{
+	/*
+	 * Encodes and writes images on background threads, thus saving never stalls the render loop.
+	 * The queue is bounded by the size of the queued pixels, a push waits for the encoders only once they fall
+	 * far behind. The destructor drains the queue.
+	 */
+	class ImageWriter final
+	{
+	public:
+		NON_COPIABLE(ImageWriter)
+
+		explicit ImageWriter(uint32_t threads = 1);
+		~ImageWriter();
+
+		/*
+		 * Linear RGBA of every pixel, top row first, the format is selected by the .exr or .pfm extension.
+		 * Averaged images hold radiance sums divided by the sample count in the alpha.
+		 */
+		void Push(const std::string& path, uint32_t width, uint32_t height, std::vector<float> rgba, bool average);
+
+		// Four bytes per pixel, top row first, the format is selected by the .png, .jpg, .bmp, .tga or .ppm extension
+		void Push(const std::string& path, uint32_t width, uint32_t height, std::vector<uint8_t> pixels, bool bgr);
+
+		// Blocks until every pushed image has been written
+		void Wait();
+
+		static void Write(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgba,
+		                  bool average);
+		static void Write(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels,
+		                  bool bgr);
+		static bool IsFloatFormat(const std::string& path);
+
+		// Inserts the zero padded number before the extension, image.png becomes image_00042.png
+		static std::string Numbered(const std::string& path, uint32_t number);
+
+	private:
+		static constexpr size_t MAX_QUEUED_BYTES = size_t{ 1 } << 30;
+
+		struct Task
+		{
+			size_t Bytes;
+			std::function<void()> Run;
+		};
+
+		void Enqueue(const std::string& path, size_t bytes, std::function<void()> task);
+		void Loop();
+
+		std::queue<Task> tasks;
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::condition_variable drained;
+		size_t queuedBytes = 0;
+		uint32_t busy = 0;
+		bool stop = false;
+		std::vector<std::thread> threads;
+	};
+}
@@ -0,0 +1,149 @@
+#include "Job.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Tracer
+{
+	namespace
+	{
+		std::vector<float> ToFloats(const std::string& value)
+		{
+			std::vector<float> numbers;
+			std::stringstream stream(value);
+			std::string number;
+
+			while (std::getline(stream, number, ','))
+				numbers.push_back(std::stof(number));
+
+			return numbers;
+		}
+	}
+
+	Job Job::Parse(const std::string& line)
+	{
+		Job job;
+		std::istringstream stream(line);
+		std::string token;
+
+		while (stream >> token)
+		{
+			const auto separator = token.find('=');
+
+			if (separator == std::string::npos)
+				throw std::runtime_error("Expected key=value instead of " + token);
+
+			const auto key = token.substr(0, separator);
+			const auto value = token.substr(separator + 1);
+
+			if (key == "scene")
+				job.ScenePath = value;
+			else if (key == "output")
+				job.OutputPath = value;
+			else if (key == "width")
+				job.Width = static_cast<uint32_t>(std::stoul(value));
+			else if (key == "height")
+				job.Height = static_cast<uint32_t>(std::stoul(value));
+			else if (key == "spp")
+				job.Samples = std::stoi(value);
+			else if (key == "time")
+				job.TimeBudget = std::stoi(value);
+			else if (key == "depth")
+				job.MaxDepth = std::stoi(value);
+			else if (key == "integrator")
+				job.IntegratorType = std::stoi(value);
+			else if (key == "first")
+				job.FirstSample = static_cast<uint32_t>(std::stoul(value));
+			else if (key == "aovs")
+				job.WriteAOVs = std::stoi(value) != 0;
+			else if (key == "fps")
+				job.Fps = std::stoi(value);
+			else if (key == "path")
+				job.CameraPath = value;
+			else if (key == "camera")
+			{
+				const auto numbers = ToFloats(value);
+
+				if (numbers.size() != 7)
+					throw std::runtime_error("Camera requires 7 numbers: " + value);
+
+				job.Camera = Job::View{
+					{ numbers[0], numbers[1], numbers[2] }, { numbers[3], numbers[4], numbers[5] }, numbers[6]
+				};
+			}
+			else
+				throw std::runtime_error("Unknown key " + key);
+		}
+
+		if (!std::filesystem::exists(job.ScenePath))
+			throw std::runtime_error("Scene file does not exist: " + job.ScenePath);
+
+		if (job.OutputPath.empty())
+			throw std::runtime_error("Missing output");
+
+		if ((job.Width == 0) != (job.Height == 0))
+			throw std::runtime_error("Both width and height have to be set");
+
+		if (!job.CameraPath.empty() && job.Fps <= 0)
+			throw std::runtime_error("Camera path requires fps");
+
+		if (job.Samples <= 0 && job.TimeBudget <= 0)
+			throw std::runtime_error("Job requires spp or time");
+
+		return job;
+	}
+
+	std::vector<Job> Job::Load(const std::string& manifest)
+	{
+		std::ifstream file(manifest);
+
+		if (!file)
+			throw std::runtime_error("Failed to open the batch manifest " + manifest);
+
+		std::vector<Job> jobs;
+		std::string line;
+		int lineNumber = 0;
+
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+
+			if (line.find_first_not_of(" \t\r") == std::string::npos || line[line.find_first_not_of(" \t")] == '#')
+				continue;
+
+			try
+			{
+				jobs.push_back(Parse(line));
+			}
+			catch (const std::exception& exception)
+			{
+				throw std::runtime_error(manifest + ":" + std::to_string(lineNumber) + ": " + exception.what());
+			}
+		}
+
+		if (jobs.empty())
+			throw std::runtime_error("The batch manifest " + manifest + " has no jobs");
+
+		// Every scene is loaded once, the order of first appearance is kept
+		std::vector<Job> grouped;
+		grouped.reserve(jobs.size());
+
+		for (const auto& job : jobs)
+		{
+			const auto shared = std::find_if(grouped.rbegin(), grouped.rend(), [&job](const Job& other)
+			{
+				return job.SharesScene(other);
+			});
+
+			if (shared == grouped.rend())
+				grouped.push_back(job);
+			else
+				grouped.insert(shared.base(), job);
+		}
+
+		return grouped;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Tracer
+{
+	/*
+	 * Single headless render. A batch manifest lists one job per line as key=value pairs,
+	 * lines starting with # are ignored:
+	 *
+	 * scene=<file.scene> output=<file.ppm> [width=<px> height=<px>] [spp=<n>] [time=<s>]
+	 * [camera=<x,y,z,lookAtX,lookAtY,lookAtZ,fov>] [depth=<n>] [integrator=<id>] [first=<sample>] [aovs=<0|1>]
+	 * [fps=<n> [path=<file.path>]]
+	 *
+	 * Outputs with the .exr or .pfm extension hold the linear radiance instead of the tone mapped image.
+	 * With fps the camera path is rendered into numbered frames of the output, spp and time apply to every frame.
+	 */
+	struct Job final
+	{
+		struct View
+		{
+			glm::vec3 position;
+			glm::vec3 lookAt;
+			float fov;
+		};
+
+		std::string ScenePath;
+		std::string OutputPath;
+		uint32_t Width = 0; // The resolution of the scene file if 0
+		uint32_t Height = 0;
+		int Samples = 0;
+		int TimeBudget = 0;
+		std::optional<View> Camera; // The camera of the scene file if empty
+		std::optional<int> MaxDepth;
+		int IntegratorType = 0;
+		uint32_t FirstSample = 0; // Index of the first sample, seeds of other ranges do not correlate
+		bool WriteAOVs = false; // Normals and positions next to a float output
+		int Fps = 0; // Frames per second of the camera path capture, a single image if 0
+		std::string CameraPath; // The camera path of the scene file if empty
+
+		// Jobs rendering the same scene at the same resolution share the loaded scene and the render targets
+		[[nodiscard]] bool SharesScene(const Job& other) const
+		{
+			return ScenePath == other.ScenePath && Width == other.Width && Height == other.Height;
+		}
+
+		static Job Parse(const std::string& line);
+
+		// Jobs are grouped by scene, the manifest order is kept within a group
+		static std::vector<Job> Load(const std::string& manifest);
+	};
+}
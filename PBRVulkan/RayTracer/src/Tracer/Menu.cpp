@@ -6,6 +6,7 @@
 
 #include "../Vulkan/SwapChain.h"
 #include "../Vulkan/Device.h"
+#include "../Vulkan/PipelineCache.h"
 #include "../Vulkan/Surface.h"
 #include "../Vulkan/Instance.h"
 #include "../Vulkan/Window.h"
@@ -59,7 +60,7 @@ namespace Tracer
 		vulkanInit.Device = device.Get();
 		vulkanInit.QueueFamily = device.GraphicsFamilyIndex;
 		vulkanInit.Queue = device.GraphicsQueue;
-		vulkanInit.PipelineCache = nullptr;
+		vulkanInit.PipelineCache = device.GetPipelineCache().Get();
 		vulkanInit.DescriptorPool = descriptorPool;
 		vulkanInit.MinImageCount = swapChain.MinImageCount;
 		vulkanInit.ImageCount = static_cast<uint32_t>(swapChain.GetImage().size());
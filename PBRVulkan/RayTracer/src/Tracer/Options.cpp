@@ -0,0 +1,117 @@
+#include "Options.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace Tracer
+{
+	namespace
+	{
+		int ToInt(const std::string& flag, const std::string& value)
+		{
+			try
+			{
+				const int number = std::stoi(value);
+
+				if (number >= 0)
+					return number;
+			}
+			catch (const std::exception&) { }
+
+			throw std::runtime_error("Invalid value of " + flag + ": " + value);
+		}
+	}
+
+	Options Options::Parse(int argc, char* argv[])
+	{
+		Options options;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string flag = argv[i];
+
+			if (flag == "--headless")
+			{
+				options.Headless = true;
+				continue;
+			}
+
+			if (flag == "--aovs")
+			{
+				options.WriteAOVs = true;
+				continue;
+			}
+
+			if (i + 1 >= argc)
+				throw std::runtime_error("Missing value of " + flag);
+
+			const std::string value = argv[++i];
+
+			if (flag == "--batch")
+			{
+				options.BatchPath = value;
+				options.Headless = true;
+			}
+			else if (flag == "--worker")
+			{
+				options.WorkerPath = value;
+				options.Headless = true;
+			}
+			else if (flag == "--coordinate")
+				options.CoordinatorPath = value;
+			else if (flag == "--tasks")
+				options.Tasks = ToInt(flag, value);
+			else if (flag == "--scene")
+				options.ScenePath = value;
+			else if (flag == "--width")
+				options.Width = static_cast<uint32_t>(ToInt(flag, value));
+			else if (flag == "--height")
+				options.Height = static_cast<uint32_t>(ToInt(flag, value));
+			else if (flag == "--spp")
+				options.Samples = ToInt(flag, value);
+			else if (flag == "--time")
+				options.TimeBudget = ToInt(flag, value);
+			else if (flag == "--output")
+				options.OutputPath = value;
+			else if (flag == "--fps")
+				options.Fps = ToInt(flag, value);
+			else if (flag == "--path")
+				options.CameraPath = value;
+			else
+				throw std::runtime_error("Unknown option " + flag);
+		}
+
+		if (options.OutputPath.empty())
+			options.OutputPath = options.CoordinatorPath.empty() ? "render.ppm" : "render.pfm";
+
+		if (!options.CoordinatorPath.empty())
+		{
+			if (!std::filesystem::exists(options.ScenePath))
+				throw std::runtime_error("Scene file does not exist: " + options.ScenePath);
+
+			// Time budgets of the workers would not add up to a known number of samples
+			if (options.Tasks <= 0 || options.Samples < options.Tasks)
+				throw std::runtime_error("Distributed render requires --spp of at least --tasks");
+
+			return options;
+		}
+
+		if (!options.Headless || !options.BatchPath.empty() || !options.WorkerPath.empty())
+			return options;
+
+		if (!std::filesystem::exists(options.ScenePath))
+			throw std::runtime_error("Scene file does not exist: " + options.ScenePath);
+
+		if ((options.Width == 0) != (options.Height == 0))
+			throw std::runtime_error("Both --width and --height have to be set");
+
+		if (!options.CameraPath.empty() && options.Fps == 0)
+			throw std::runtime_error("--path requires --fps");
+
+		// Otherwise the headless render would never stop
+		if (options.Samples == 0 && options.TimeBudget == 0)
+			throw std::runtime_error("Headless render requires --spp or --time");
+
+		return options;
+	}
+}
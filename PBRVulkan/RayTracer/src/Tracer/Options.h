@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Tracer
+{
+	/*
+	 * Command line options. Without --headless the renderer opens the interactive window.
+	 *
+	 * PBRVulkan --headless --scene <file.scene> [--width <px> --height <px>] [--spp <n>] [--time <s>] [--output <file.ppm>]
+	 *           [--aovs] [--fps <n> [--path <file.path>]]
+	 * PBRVulkan --batch <manifest>
+	 * PBRVulkan --coordinate <directory> --scene <file.scene> --spp <n> [--tasks <n>] [--output <file.pfm>]
+	 * PBRVulkan --worker <directory>
+	 *
+	 * Outputs with the .exr or .pfm extension hold the linear radiance, --aovs adds the normals and positions.
+	 * Other outputs hold the tone mapped image encoded by the extension, i.e. .png, .jpg, .bmp, .tga or .ppm.
+	 * --fps renders the camera path of the scene or of --path into numbered frames, e.g. frames/frame_00042.png.
+	 */
+	struct Options final
+	{
+		bool Headless = false;
+		std::string ScenePath;
+		uint32_t Width = 0; // The resolution of the scene file if 0
+		uint32_t Height = 0;
+		int Samples = 0; // Samples per pixel of the headless render
+		int TimeBudget = 0; // Seconds of the headless render
+		std::string OutputPath; // render.ppm, or render.pfm for the coordinator if empty
+		bool WriteAOVs = false;
+		int Fps = 0; // Frames per second of the camera path capture
+		std::string CameraPath;
+		std::string BatchPath; // Headless jobs of the manifest, see Job.h
+		std::string CoordinatorPath; // Shared directory of the distributed render, see Coordinator.h
+		std::string WorkerPath;
+		int Tasks = 8; // Sample ranges of the distributed render
+
+		static Options Parse(int argc, char* argv[]);
+	};
+}
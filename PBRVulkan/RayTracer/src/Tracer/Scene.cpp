@@ -1,5 +1,6 @@
 #include "Scene.h"
 
+#include <cstring>
 #include <iostream>
 #include <future>
 #include <utility>
@@ -8,7 +9,7 @@
 #include "TextureImage.h"
 
 #include "../Vulkan/Device.h"
-#include "../Vulkan/CommandPool.h"
+#include "../Vulkan/Uploader.h"
 #include "../Vulkan/Buffer.h"
 
 #include "../Geometry/Vertex.h"
@@ -25,9 +26,8 @@ namespace Tracer
 {
 	Scene::Scene(
 		std::string config,
-		const Vulkan::Device& device,
-		const Vulkan::CommandPool& commandPool)
-		: config(std::move(config)), device(device), commandPool(commandPool)
+		const Vulkan::Device& device)
+		: config(std::move(config)), device(device)
 	{
 		const auto start = std::chrono::high_resolution_clock::now();
 
@@ -50,11 +50,24 @@ namespace Tracer
 		for (auto& texture : textures)
 		{
 			texture->Wait();
-			textureImages.emplace_back(new TextureImage(device, commandPool, *texture));
+			textureImages.emplace_back(new TextureImage(device, *texture));
 		}
 
+		// Meshes are split and optimized in parallel, each one on its own loader thread
+		std::vector<std::future<void>> optimizers;
+
 		for (const auto& mesh : meshes)
-			mesh->Wait();
+		{
+			optimizers.push_back(std::async(std::launch::async, [this, &mesh]()
+			{
+				mesh->Wait();
+				mesh->Split(options.splitThreshold);
+				mesh->Optimize(options.meshletSize);
+			}));
+		}
+
+		for (auto& optimizer : optimizers)
+			optimizer.get();
 
 		if (hdrLoader.valid())
 			hdrLoader.get();
@@ -69,6 +82,7 @@ namespace Tracer
 		std::cout << "	# instances: " << meshInstances.size() << std::endl;
 		std::cout << "	# textures:  " << textures.size() << std::endl;
 		std::cout << "	# lights:    " << lights.size() << std::endl;
+		std::cout << "	# primitives: " << primitives.size() << std::endl;
 		std::cout << "	# materials: " << materials.size() << std::endl;
 	}
 
@@ -105,22 +119,27 @@ namespace Tracer
 		VkFormat format = VK_FORMAT_R32G32B32_SFLOAT;
 		VkImageTiling tiling = VK_IMAGE_TILING_LINEAR;
 		VkImageType imageType = VK_IMAGE_TYPE_2D;
+		auto category = Vulkan::MemoryCategory::HDR;
 
 		auto columns = std::make_unique<Assets::Texture>(hdr->width, hdr->height, 12, hdr->cols);
-		hdrImages.emplace_back(new TextureImage(device, commandPool, *columns, format, tiling, imageType));
+		hdrImages.emplace_back(new TextureImage(device, *columns, format, tiling, imageType, category));
 
 		auto conditional = std::make_unique<Assets::Texture>(hdr->width, hdr->height, 12, hdr->conditionalDistData);
-		hdrImages.emplace_back(new TextureImage(device, commandPool, *conditional, format, tiling, imageType));
+		hdrImages.emplace_back(new TextureImage(device, *conditional, format, tiling, imageType, category));
 
 		auto marginal = std::make_unique<Assets::Texture>(hdr->width, hdr->height, 12, hdr->marginalDistData);
-		hdrImages.emplace_back(new TextureImage(device, commandPool, *marginal, format, tiling, imageType));
+		hdrImages.emplace_back(new TextureImage(device, *marginal, format, tiling, imageType, category));
 	}
 
 	void Scene::CreateBuffers()
 	{
-		std::vector<uint32_t> indices;
-		std::vector<Geometry::Vertex> vertices;
-		std::vector<glm::uvec2> offsets;
+		// Indices of every mesh are stored with its own width, see Mesh::GetIndexStride
+		std::vector<uint8_t> indices;
+		std::vector<Geometry::PackedVertex> vertices;
+		// {firstIndex, vertexOffset, materialId, indexStride} per BLAS instance
+		std::vector<glm::uvec4> offsets;
+
+		indexOffsets.clear();
 
 		for (const auto& meshInstance : meshInstances)
 		{
@@ -128,22 +147,40 @@ namespace Tracer
 			glm::mat4 modelMatrix = meshInstance.modelTransform;
 			glm::mat4 modelTransInvMatrix = transpose(inverse(modelMatrix));
 
-			for (auto& vertex : mesh->GetVertices())
+			// Every mesh starts at a 4 bytes boundary, thus the hit shader can fetch both widths as uint words
+			const auto stride = mesh->GetIndexStride();
+			const auto indexOffset = static_cast<uint32_t>((indices.size() + 3) / 4 * 4);
+			const auto vertexOffset = static_cast<uint32_t>(vertices.size());
+			const auto materialId = static_cast<uint32_t>(meshInstance.materialId);
+
+			indexOffsets.push_back(indexOffset);
+			indices.resize(indexOffset + mesh->GetIndeciesSize() * stride);
+
+			for (size_t i = 0; i < mesh->GetIndeciesSize(); ++i)
+			{
+				const uint32_t index = mesh->GetIndecies()[i];
+				const auto narrow = static_cast<uint16_t>(index);
+
+				if (stride == sizeof(uint16_t))
+					std::memcpy(&indices[indexOffset + i * stride], &narrow, stride);
+				else
+					std::memcpy(&indices[indexOffset + i * stride], &index, stride);
+			}
+
+			for (auto vertex : mesh->GetVertices())
 			{
 				vertex.position = modelMatrix * glm::vec4(vertex.position, 1.f);
 				vertex.normal = normalize(modelTransInvMatrix * glm::vec4(vertex.normal, 1.f));
-				vertex.materialId = meshInstance.materialId;
+				vertices.push_back(Geometry::PackedVertex::Pack(vertex));
 			}
 
-			const auto indexOffset = static_cast<uint32_t>(indices.size());
-			const auto vertexOffset = static_cast<uint32_t>(vertices.size());
-
-			offsets.emplace_back(indexOffset, vertexOffset);
-
-			vertices.insert(vertices.end(), mesh->GetVertices().begin(), mesh->GetVertices().end());
-			indices.insert(indices.end(), mesh->GetIndecies().begin(), mesh->GetIndecies().end());
+			// Every cluster is a separate BLAS instance indexed by gl_InstanceCustomIndexEXT
+			for (const auto& cluster : mesh->GetClusters())
+				offsets.emplace_back(indexOffset / stride + cluster.firstIndex, vertexOffset, materialId, stride);
 		}
 
+		indices.resize((indices.size() + 3) / 4 * 4);
+
 		// =============== VERTEX BUFFER ===============
 
 		auto usage = static_cast<VkBufferUsageFlagBits>(
@@ -151,7 +188,7 @@ namespace Tracer
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
 			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
 			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR);
-		auto size = sizeof(meshes[0]->GetVertices()[0]) * vertices.size();
+		auto size = sizeof(vertices[0]) * vertices.size();
 
 		if (size == 0)
 		{
@@ -161,7 +198,7 @@ namespace Tracer
 
 		std::cout << "[SCENE] Vertex buffer size = " << static_cast<double>(size) / 1000000.0 << " MB" << std::endl;
 		Fill(vertexBuffer, vertices.data(), size, usage,
-		     VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+		     VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, Vulkan::MemoryCategory::Geometry);
 
 		// =============== INDEX BUFFER ===============
 
@@ -170,24 +207,146 @@ namespace Tracer
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
 			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
 			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR);
-		size = sizeof(indices[0]) * indices.size();
+		size = indices.size();
+		std::cout << "[SCENE] Index buffer size = " << static_cast<double>(size) / 1000000.0 << " MB" << std::endl;
 		Fill(indexBuffer, indices.data(), size, usage,
-		     VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+		     VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, Vulkan::MemoryCategory::Geometry);
 
 		// =============== MATERIAL BUFFER ===============
 
 		size = sizeof(materials[0]) * materials.size();
-		Fill(materialBuffer, materials.data(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0);
+		Fill(materialBuffer, materials.data(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0,
+		     Vulkan::MemoryCategory::SceneData);
 
 		// =============== OFFSET BUFFER ===============
 
 		size = sizeof(offsets[0]) * offsets.size();
-		Fill(offsetBuffer, offsets.data(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0);
+		Fill(offsetBuffer, offsets.data(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0,
+		     Vulkan::MemoryCategory::Geometry);
 
+		CreateLightsBuffers();
+		CreatePrimitivesBuffers();
+	}
+
+	void Scene::CreateLightsBuffers()
+	{
 		// =============== LIGHTS BUFFER ===============
 
-		size = sizeof(lights[0]) * lights.size();
-		Fill(lightsBuffer, lights.data(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0);
+		Fill(lightsBuffer, lights.data(), sizeof(lights[0]) * lights.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0,
+		     Vulkan::MemoryCategory::SceneData);
+
+		if (lights.front().type == -1)
+			return;
+
+		// =============== LIGHTS AABBS BUFFER ===============
+
+		std::vector<VkAabbPositionsKHR> aabbs;
+		aabbs.reserve(lights.size());
+
+		for (const auto& light : lights)
+		{
+			glm::vec3 min(0.f);
+			glm::vec3 max(0.f);
+
+			if (light.type == Assets::LightType::SphereLight)
+			{
+				min = light.position - glm::vec3(light.radius);
+				max = light.position + glm::vec3(light.radius);
+			}
+			else
+			{
+				min = glm::min(light.position, light.position + light.u + light.v);
+				max = glm::max(light.position, light.position + light.u + light.v);
+				min = glm::min(min, glm::min(light.position + light.u, light.position + light.v));
+				max = glm::max(max, glm::max(light.position + light.u, light.position + light.v));
+			}
+
+			// Quad lights have zero extent along their normal
+			min -= glm::vec3(1e-4f);
+			max += glm::vec3(1e-4f);
+
+			aabbs.push_back({ min.x, min.y, min.z, max.x, max.y, max.z });
+		}
+
+		const auto usage = static_cast<VkBufferUsageFlagBits>(
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR);
+
+		Fill(lightsAABBsBuffer, aabbs.data(), sizeof(aabbs[0]) * aabbs.size(), usage,
+		     VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, Vulkan::MemoryCategory::Geometry);
+	}
+
+	void Scene::CreatePrimitivesBuffers()
+	{
+		// =============== PRIMITIVES BUFFER ===============
+
+		// A dummy primitive keeps the descriptor valid, the procedural BLAS is skipped in that case
+		std::vector<Assets::Primitive> data = primitives;
+
+		if (data.empty())
+			data.emplace_back();
+
+		Fill(primitivesBuffer, data.data(), sizeof(data[0]) * data.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0,
+		     Vulkan::MemoryCategory::SceneData);
+
+		if (primitives.empty())
+			return;
+
+		// =============== AABBS BUFFER ===============
+
+		std::vector<VkAabbPositionsKHR> aabbs;
+		aabbs.reserve(primitives.size());
+
+		for (const auto& primitive : primitives)
+		{
+			glm::vec3 min(0.f);
+			glm::vec3 max(0.f);
+
+			if (primitive.type == Assets::PrimitiveType::SpherePrimitive)
+			{
+				min = primitive.position - glm::vec3(primitive.radius);
+				max = primitive.position + glm::vec3(primitive.radius);
+			}
+			else if (primitive.type == Assets::PrimitiveType::DiskPrimitive)
+			{
+				const glm::vec3 n = primitive.normal;
+				const glm::vec3 extent = primitive.radius * glm::sqrt(glm::max(glm::vec3(1.f) - n * n, glm::vec3(0.f)));
+				min = primitive.position - extent;
+				max = primitive.position + extent;
+			}
+			else
+			{
+				const glm::vec3 corners[] = {
+					primitive.position,
+					primitive.position + primitive.u,
+					primitive.position + primitive.v,
+					primitive.position + primitive.u + primitive.v
+				};
+
+				min = max = corners[0];
+
+				for (const auto& corner : corners)
+				{
+					min = glm::min(min, corner);
+					max = glm::max(max, corner);
+				}
+			}
+
+			// Planar primitives have zero extent along their normal
+			min -= glm::vec3(1e-4f);
+			max += glm::vec3(1e-4f);
+
+			aabbs.push_back({ min.x, min.y, min.z, max.x, max.y, max.z });
+		}
+
+		const auto usage = static_cast<VkBufferUsageFlagBits>(
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR);
+
+		Fill(aabbsBuffer, aabbs.data(), sizeof(aabbs[0]) * aabbs.size(), usage, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+		     Vulkan::MemoryCategory::Geometry);
 	}
 
 	bool Scene::IsValid(const std::string config) const
@@ -208,24 +367,19 @@ namespace Tracer
 		void* data,
 		size_t size,
 		VkBufferUsageFlagBits usage,
-		VkMemoryAllocateFlags allocateFlags) const
+		VkMemoryAllocateFlags allocateFlags,
+		Vulkan::MemoryCategory category) const
 	{
-		const std::unique_ptr<Vulkan::Buffer> buffer_staging(
-			new Vulkan::Buffer(
-				device, size,
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-
-		buffer_staging->Fill(data);
-
 		buffer.reset(
 			new Vulkan::Buffer(
 				device, size,
 				static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage),
 				allocateFlags,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				category));
 
-		buffer->Copy(commandPool, *buffer_staging);
+		// Graphics submissions issued later are ordered after the upload, no need to wait for it
+		device.GetUploader().Upload(*buffer, data, size);
 	}
 
 	void Scene::AddCamera(glm::vec3 pos, glm::vec3 lookAt, float fov, float aspect)
@@ -233,6 +387,11 @@ namespace Tracer
 		camera.reset(new Camera(pos, lookAt, fov, aspect));
 	}
 
+	void Scene::AddKeyframe(const Keyframe& keyframe)
+	{
+		cameraPath.Add(keyframe);
+	}
+
 	void Scene::AddHDR(const std::string& path)
 	{
 		hdrLoader = std::async(std::launch::async, [this, path]()
@@ -260,6 +419,13 @@ namespace Tracer
 		return id;
 	}
 
+	int Scene::AddPrimitive(Assets::Primitive primitive)
+	{
+		int id = primitives.size();
+		primitives.push_back(primitive);
+		return id;
+	}
+
 	int Scene::AddMesh(const std::string& path)
 	{
 		int id;
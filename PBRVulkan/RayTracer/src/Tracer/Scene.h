@@ -11,11 +11,14 @@
 #include <glm/glm.hpp>
 
 #include "Application.h"
+#include "CameraPath.h"
 
 #include "../Geometry/Vertex.h"
 #include "../Loader/Loader.h"
 #include "../Vulkan/Vulkan_api.h"
+#include "../Vulkan/Telemetry.h"
 #include "../Assets/Light.h"
+#include "../Assets/Primitive.h"
 #include "../Loader/RenderOptions.h"
 
 #include "../3rdParty/HDRLoader.h"
@@ -24,7 +27,6 @@ namespace Vulkan
 {
 	class Device;
 	class Buffer;
-	class CommandPool;
 	class Image;
 }
 
@@ -47,17 +49,18 @@ namespace Tracer
 
 		Scene(
 			std::string config,
-			const class Vulkan::Device& device,
-			const Vulkan::CommandPool& commandPool);
+			const class Vulkan::Device& device);
 		~Scene() override;
 
 		void AddCamera(glm::vec3 pos, glm::vec3 lookAt, float fov, float aspect) override;
+		void AddKeyframe(const Keyframe& keyframe) override;
 		void AddHDR(const std::string& path) override;
 		int AddMesh(const std::string& path) override;
 		int AddTexture(const std::string& path) override;
 		int AddMaterial(Assets::Material material) override;
 		int AddLight(Assets::Light light) override;
 		int AddMeshInstance(class Assets::MeshInstance meshInstance) override;
+		int AddPrimitive(Assets::Primitive primitive) override;
 		void CreateBuffers();
 
 		[[nodiscard]] const std::vector<std::unique_ptr<Assets::Mesh>>& GetMeshes() const
@@ -72,6 +75,11 @@ namespace Tracer
 			return meshInstances;
 		}
 
+		[[nodiscard]] const CameraPath& GetCameraPath() const
+		{
+			return cameraPath;
+		}
+
 		[[nodiscard]] class Camera& GetCamera() const
 		{
 			return *camera;
@@ -102,6 +110,21 @@ namespace Tracer
 			return *lightsBuffer;
 		}
 
+		[[nodiscard]] const Vulkan::Buffer& GetPrimitivesBuffer() const
+		{
+			return *primitivesBuffer;
+		}
+
+		[[nodiscard]] const Vulkan::Buffer& GetAABBsBuffer() const
+		{
+			return *aabbsBuffer;
+		}
+
+		[[nodiscard]] const Vulkan::Buffer& GetLightsAABBsBuffer() const
+		{
+			return *lightsAABBsBuffer;
+		}
+
 		[[nodiscard]] const std::vector<std::unique_ptr<class TextureImage>>& GetTextures() const
 		{
 			return textureImages;
@@ -122,11 +145,30 @@ namespace Tracer
 			return lights.size();
 		}
 
+		// The dummy light of a scene without lights is not an emitter
+		[[nodiscard]] bool HasEmitters() const
+		{
+			return lightsAABBsBuffer != nullptr;
+		}
+
+		[[nodiscard]] uint32_t GetPrimitivesSize() const
+		{
+			return primitives.size();
+		}
+
 		[[nodiscard]] uint32_t GetTextureSize() const
 		{
 			return textureImages.size();
 		}
 
+		/*
+		 * Byte offset of every mesh instance in the index buffer
+		 */
+		[[nodiscard]] const std::vector<uint32_t>& GetIndexOffsets() const
+		{
+			return indexOffsets;
+		}
+
 		[[nodiscard]] uint32_t GetIndexSize() const
 		{
 			return indeciesSize;
@@ -153,9 +195,9 @@ namespace Tracer
 		uint32_t verticesSize{};
 		uint32_t indeciesSize{};
 		std::unique_ptr<class Camera> camera;
+		CameraPath cameraPath;
 
 		const class Vulkan::Device& device;
-		const class Vulkan::CommandPool& commandPool;
 
 		// Assets
 		std::map<std::string, int> meshMap;
@@ -170,12 +212,17 @@ namespace Tracer
 		std::vector<Assets::MeshInstance> meshInstances;
 		std::vector<Assets::Material> materials;
 		std::vector<Assets::Light> lights;
+		std::vector<Assets::Primitive> primitives;
+		std::vector<uint32_t> indexOffsets;
 
 		std::unique_ptr<class Vulkan::Buffer> vertexBuffer;
 		std::unique_ptr<class Vulkan::Buffer> indexBuffer;
 		std::unique_ptr<class Vulkan::Buffer> materialBuffer;
 		std::unique_ptr<class Vulkan::Buffer> offsetBuffer;
 		std::unique_ptr<class Vulkan::Buffer> lightsBuffer;
+		std::unique_ptr<class Vulkan::Buffer> primitivesBuffer;
+		std::unique_ptr<class Vulkan::Buffer> aabbsBuffer;
+		std::unique_ptr<class Vulkan::Buffer> lightsAABBsBuffer;
 		std::unique_ptr<class Vulkan::Image> image;
 
 		std::future<void> hdrLoader{};
@@ -187,9 +234,12 @@ namespace Tracer
 		void Print() const;
 		bool Load();
 		void LoadEmptyBuffers();
+		void CreatePrimitivesBuffers();
+		void CreateLightsBuffers();
 		void LoadHDR(HDRData* hdr);
 		void Fill(std::unique_ptr<class Vulkan::Buffer>& buffer, void* data, size_t size,
 		          VkBufferUsageFlagBits storage,
-		          VkMemoryAllocateFlags allocateFlags) const;
+		          VkMemoryAllocateFlags allocateFlags,
+		          Vulkan::MemoryCategory category) const;
 	};
 }
@@ -19,19 +19,54 @@ struct Settings final
 	float Aperture = 0.001f;
 	float FocalDistance = 1.f;
 	float AORayLength = 0.5f;
+	bool UseThroughputMode = false;
+	int TargetFrameTime = 33; // Present interval of the throughput mode in milliseconds
+	bool UseTiledTrace = false;
+	int TileBudget = 50; // GPU time of a single tile in milliseconds
+	bool UseAdaptiveSampling = false;
+	float AdaptiveThreshold = 0.02f; // Relative standard error of converged pixels
+	int AdaptiveInterval = 8; // Samples between compactions of the unconverged pixels
+	int TargetSamples = 0; // The render stops after the samples, 0 disables the criterion
+	int TimeBudget = 0; // The render stops after the seconds, 0 disables the criterion
+	float TargetError = 0.f; // The render stops below the mean relative error, 0 disables the criterion
 
 	std::string SavedImageName;
 	bool ShouldSaveImage = false;
+	bool CaptureFrames = false; // Every presented frame is saved with its number appended to the name
+	std::string ExportedImageName; // Linear radiance as .exr or .pfm
+	bool ShouldExportImage = false;
+	bool ExportAOVs = false; // Normals and positions are written next to the radiance
+	float KeyframeInterval = 2.f; // Seconds between the last keyframe of the camera path and an added one
+	bool ShouldAddKeyframe = false;
+	bool ShouldClearKeyframes = false;
+	std::string CameraPathName;
+	bool ShouldSavePath = false;
+	bool ShouldLoadPath = false;
+	int CaptureFps = 24;
+	int CaptureSamples = 64; // Samples of every frame of the camera path
+	std::string CaptureName; // Numbered frames, .exr or .pfm hold the linear radiance
+	bool ShouldCapturePath = false;
 
 	[[nodiscard]] bool RequiresShaderRecompliation(const Settings& prev) const
 	{
 		return UseGammaCorrection != prev.UseGammaCorrection || IntegratorType != prev.IntegratorType;
 	}
 
+	[[nodiscard]] bool RequiresCommandsRecording(const Settings& prev) const
+	{
+		return
+			UseRasterizer != prev.UseRasterizer ||
+			UseComputeShaders != prev.UseComputeShaders ||
+			UseAdaptiveSampling != prev.UseAdaptiveSampling ||
+			AdaptiveThreshold != prev.AdaptiveThreshold;
+	}
+
 	[[nodiscard]] bool RequiresAccumulationReset(const Settings& prev) const
 	{
 		return
 			UseRasterizer != prev.UseRasterizer ||
+			UseTiledTrace != prev.UseTiledTrace ||
+			UseAdaptiveSampling != prev.UseAdaptiveSampling ||
 			UseGammaCorrection != prev.UseGammaCorrection ||
 			IntegratorType != prev.IntegratorType ||
 			SceneId != prev.SceneId ||
@@ -1,26 +1,18 @@
 ﻿#include "TextureImage.h"
 
-#include "../Vulkan/Buffer.h"
-#include "../Vulkan/CommandPool.h"
+#include "../Vulkan/Device.h"
 
 #include "../Assets/Texture.h"
 
 namespace Tracer
 {
 	TextureImage::TextureImage(const Vulkan::Device& device,
-	                           const Vulkan::CommandPool& commandPool,
 	                           Assets::Texture& texture,
 	                           VkFormat format,
 	                           VkImageTiling tiling,
-	                           VkImageType imageType)
+	                           VkImageType imageType,
+	                           Vulkan::MemoryCategory category)
 	{
-		const std::unique_ptr<Vulkan::Buffer> stagingBuffer(new Vulkan::Buffer(
-			device, texture.GetImageSize(),
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-
-		stagingBuffer->Fill(texture.GetPixels());
-
 		const auto extent = VkExtent2D{
 			static_cast<uint32_t>(texture.GetWidth()), static_cast<uint32_t>(texture.GetHeight())
 		};
@@ -28,12 +20,11 @@ namespace Tracer
 		image.reset(new Vulkan::Image(
 			device, extent, format, tiling, imageType,
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category));
 
-		image->TransitionImageLayout(commandPool, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		image->Copy(commandPool, *stagingBuffer);
-		image->TransitionImageLayout(commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// Pixels are copied into a staging buffer right away, the texture can be released before the upload ends
+		upload = device.GetUploader().Upload(*image, texture.GetPixels(), texture.GetImageSize(),
+		                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		sampler.reset(new Vulkan::TextureSampler(device));
 
@@ -6,13 +6,12 @@
 #include "../Vulkan/TextureSampler.h"
 #include "../Vulkan/ImageView.h"
 #include "../Vulkan/Image.h"
+#include "../Vulkan/Uploader.h"
 
 namespace Vulkan
 {
-	class Buffer;
 	class Device;
 	class TextureSampler;
-	class CommandPool;
 	class Image;
 	class ImageView;
 }
@@ -30,11 +29,11 @@ namespace Tracer
 		NON_COPIABLE(TextureImage)
 
 		TextureImage(const Vulkan::Device& device,
-		             const Vulkan::CommandPool& commandPool,
 		             Assets::Texture& texture,
 		             VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
 		             VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL,
-		             VkImageType imageType = VK_IMAGE_TYPE_2D);
+		             VkImageType imageType = VK_IMAGE_TYPE_2D,
+		             Vulkan::MemoryCategory category = Vulkan::MemoryCategory::Textures);
 		~TextureImage() = default;
 
 		[[nodiscard]] const Vulkan::Image& GetImage() const
@@ -52,9 +51,15 @@ namespace Tracer
 			return sampler->Get();
 		}
 
+		[[nodiscard]] const Vulkan::UploadFuture& GetUpload() const
+		{
+			return upload;
+		}
+
 	private:
 		std::unique_ptr<Vulkan::Image> image;
 		std::unique_ptr<Vulkan::ImageView> imageView;
 		std::unique_ptr<Vulkan::TextureSampler> sampler;
+		Vulkan::UploadFuture upload;
 	};
 }
@@ -1,6 +1,58 @@
 #include "CinemaWidget.h"
 
+#include <imgui.h>
+
+#include "../CameraPath.h"
+
 namespace Interface
 {
-	void CinemaWidget::Render(Settings& settings) {}
+	void CinemaWidget::Render(Settings& settings)
+	{
+		ImGui::Text("Camera path");
+		ImGui::Separator();
+
+		const auto& keyframes = cameraPath.GetKeyframes();
+
+		ImGui::Text("%u keyframes, %.2f s", static_cast<uint32_t>(keyframes.size()), cameraPath.GetDuration());
+
+		if (!keyframes.empty() && ImGui::CollapsingHeader("Keyframes"))
+		{
+			for (const auto& keyframe : keyframes)
+			{
+				ImGui::Text("%6.2f s  (%.2f, %.2f, %.2f) fov %.1f", keyframe.time, keyframe.position.x,
+				            keyframe.position.y, keyframe.position.z, keyframe.fov);
+			}
+		}
+
+		ImGui::Text("Interval [s]");
+		ImGui::SameLine();
+		ImGui::InputFloat("float_keyframe_interval", &settings.KeyframeInterval, 0.5f);
+
+		settings.ShouldAddKeyframe = ImGui::Button("Add keyframe");
+		ImGui::SameLine();
+		settings.ShouldClearKeyframes = ImGui::Button("Clear");
+
+		constexpr auto BUF_SIZE = 256;
+		static char pathBuf[BUF_SIZE] = "camera.path";
+		ImGui::InputText("Path file name", pathBuf, BUF_SIZE);
+		settings.CameraPathName = pathBuf;
+
+		settings.ShouldSavePath = ImGui::Button("Save path");
+		ImGui::SameLine();
+		settings.ShouldLoadPath = ImGui::Button("Load path");
+
+		ImGui::Text("FPS         ");
+		ImGui::SameLine();
+		ImGui::InputInt("int_capture_fps", &settings.CaptureFps, 1);
+
+		ImGui::Text("Samples     ");
+		ImGui::SameLine();
+		ImGui::InputInt("int_capture_samples", &settings.CaptureSamples, 1);
+
+		static char frameBuf[BUF_SIZE] = "frames/frame.png";
+		ImGui::InputText("Frame file name", frameBuf, BUF_SIZE);
+		settings.CaptureName = frameBuf;
+
+		settings.ShouldCapturePath = ImGui::Button("Capture");
+	}
 }
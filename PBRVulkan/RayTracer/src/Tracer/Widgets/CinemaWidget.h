@@ -2,13 +2,22 @@
 
 #include "Widget.h"
 
+namespace Tracer
+{
+	class CameraPath;
+}
+
 namespace Interface
 {
 	class CinemaWidget final : public Widget
 	{
 	public:
+		explicit CinemaWidget(const Tracer::CameraPath& cameraPath): cameraPath(cameraPath) { }
 		~CinemaWidget() = default;
 		
 		void Render(Settings& settings) override;
+
+	private:
+		const Tracer::CameraPath& cameraPath;
 	};
 }
@@ -0,0 +1,46 @@
+#include "MemoryWidget.h"
+
+#include <imgui.h>
+
+#include "../../Vulkan/Allocator.h"
+#include "../../Vulkan/Telemetry.h"
+
+namespace Interface
+{
+	namespace
+	{
+		float ToMB(uint64_t bytes)
+		{
+			return static_cast<float>(static_cast<double>(bytes) / 1000000.0);
+		}
+	}
+
+	void MemoryWidget::Render(Settings& settings)
+	{
+		ImGui::Text("Memory");
+		ImGui::Separator();
+
+		if (!ImGui::CollapsingHeader("Usage by category"))
+			return;
+
+		const auto counters = Vulkan::Telemetry::Get().GetCounters();
+
+		for (size_t i = 0; i < counters.size(); ++i)
+		{
+			const auto& counter = counters[i];
+			const auto category = static_cast<Vulkan::MemoryCategory>(i);
+
+			if (counter.peak == 0)
+				continue;
+
+			ImGui::Text("%-22s %8.2f MB (peak %.2f) x%u", Vulkan::Telemetry::ToString(category),
+			            ToMB(counter.current), ToMB(counter.peak), static_cast<uint32_t>(counter.count));
+		}
+
+		const auto statistics = allocator.GetStatistics();
+
+		ImGui::Separator();
+		ImGui::Text("Blocks %u, dedicated %u", statistics.blocks, statistics.dedicated);
+		ImGui::Text("Reserved %.2f MB, used %.2f MB", ToMB(statistics.reserved), ToMB(statistics.used));
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Widget.h"
+
+namespace Vulkan
+{
+	class Allocator;
+}
+
+namespace Interface
+{
+	class MemoryWidget final : public Widget
+	{
+	public:
+		explicit MemoryWidget(const Vulkan::Allocator& allocator): allocator(allocator) { }
+		~MemoryWidget() = default;
+
+		void Render(Settings& settings) override;
+
+	private:
+		const Vulkan::Allocator& allocator;
+	};
+}
@@ -21,6 +21,51 @@ namespace Interface
 			ImGui::PopItemWidth();
 		}
 
+		ImGui::Checkbox("Throughput mode", &settings.UseThroughputMode);
+
+		if (settings.UseThroughputMode)
+		{
+			ImGui::Text("Frame [ms]");
+			ImGui::SameLine();
+			ImGui::InputInt("int_frame_time", &settings.TargetFrameTime, 1);
+		}
+
+		ImGui::Checkbox("Tiled trace", &settings.UseTiledTrace);
+
+		if (settings.UseTiledTrace)
+		{
+			ImGui::Text("Tile [ms] ");
+			ImGui::SameLine();
+			ImGui::InputInt("int_tile_budget", &settings.TileBudget, 1);
+		}
+
+		ImGui::Checkbox("Adaptive sampling", &settings.UseAdaptiveSampling);
+
+		if (settings.UseAdaptiveSampling)
+		{
+			ImGui::Text("Error     ");
+			ImGui::SameLine();
+			ImGui::InputFloat("float_adaptive_threshold", &settings.AdaptiveThreshold, 0.005f);
+
+			ImGui::Text("Interval  ");
+			ImGui::SameLine();
+			ImGui::InputInt("int_adaptive_interval", &settings.AdaptiveInterval, 1);
+		}
+
+		ImGui::Text("Stop at (0 disables)");
+
+		ImGui::Text("# total   ");
+		ImGui::SameLine();
+		ImGui::InputInt("int_target_samples", &settings.TargetSamples, 64);
+
+		ImGui::Text("Time [s]  ");
+		ImGui::SameLine();
+		ImGui::InputInt("int_time_budget", &settings.TimeBudget, 10);
+
+		ImGui::Text("Error     ");
+		ImGui::SameLine();
+		ImGui::InputFloat("float_target_error", &settings.TargetError, 0.005f);
+
 		ImGui::Text("# samples ");
 		ImGui::SameLine();
 		ImGui::InputInt("int_samples", &settings.SSP, 1);
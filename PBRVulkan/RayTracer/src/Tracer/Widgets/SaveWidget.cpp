@@ -10,10 +10,19 @@ namespace Interface
 		ImGui::Separator();
 
 		constexpr auto BUF_SIZE = 256;
-		static char buf[BUF_SIZE] = "image.ppm";
+		static char buf[BUF_SIZE] = "image.png";
 		ImGui::InputText("Image file name", buf, BUF_SIZE);
 		settings.SavedImageName = buf;
 
 		settings.ShouldSaveImage = ImGui::Button("Save");
+		ImGui::SameLine();
+		ImGui::Checkbox("Capture every frame", &settings.CaptureFrames);
+
+		static char hdrBuf[BUF_SIZE] = "image.exr";
+		ImGui::InputText("HDR file name", hdrBuf, BUF_SIZE);
+		settings.ExportedImageName = hdrBuf;
+
+		ImGui::Checkbox("Normals and positions", &settings.ExportAOVs);
+		settings.ShouldExportImage = ImGui::Button("Export");
 	}
 }
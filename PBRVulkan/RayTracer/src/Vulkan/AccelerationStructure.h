@@ -10,6 +10,9 @@ namespace Vulkan
 	class AccelerationStructure
 	{
 	public:
+		// Offsets of the structures within their buffer have to be a multiple of 256 bytes
+		static constexpr VkDeviceSize RESULT_ALIGNMENT = 256;
+
 		AccelerationStructure() = delete;
 		AccelerationStructure(const AccelerationStructure&) = delete;
 		AccelerationStructure& operator =(const AccelerationStructure&) = delete;
@@ -36,6 +39,37 @@ namespace Vulkan
 
 			return total;
 		}
+
+		/*
+		 * Sizes of arenas holding the structures back to back, every offset is rounded up to its alignment.
+		 * One alignment more covers the start address of the arena.
+		 */
+		template<class T>
+		static VkAccelerationStructureBuildSizesInfoKHR ReduceAligned(
+			const std::vector<T>& structures,
+			VkDeviceSize scratchAlignment)
+		{
+			const auto align = [](VkDeviceSize size, VkDeviceSize alignment)
+			{
+				return (size + alignment - 1) / alignment * alignment;
+			};
+
+			VkAccelerationStructureBuildSizesInfoKHR total{};
+			total.accelerationStructureSize = RESULT_ALIGNMENT;
+			total.buildScratchSize = scratchAlignment;
+			total.updateScratchSize = scratchAlignment;
+
+			for (const auto& accelerationStructure : structures)
+			{
+				const auto& sizes = accelerationStructure.buildSizesInfo;
+
+				total.accelerationStructureSize += align(sizes.accelerationStructureSize, RESULT_ALIGNMENT);
+				total.buildScratchSize += align(sizes.buildScratchSize, scratchAlignment);
+				total.updateScratchSize += align(sizes.updateScratchSize, scratchAlignment);
+			}
+
+			return total;
+		}
 		
 		[[nodiscard]] VkAccelerationStructureBuildSizesInfoKHR GetMemorySizes(const uint32_t* count) const;
 
@@ -0,0 +1,99 @@
+#include "AccelerationStructurePool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "Buffer.h"
+#include "Device.h"
+
+namespace Vulkan
+{
+	MemoryArena::MemoryArena(
+		const Device& device,
+		std::string name,
+		MemoryCategory category,
+		VkBufferUsageFlagBits usage,
+		VkMemoryAllocateFlags allocateFlags,
+		VkMemoryPropertyFlags properties)
+		: device(device), name(std::move(name)), category(category), usage(usage), allocateFlags(allocateFlags),
+		  properties(properties) { }
+
+	MemoryArena::~MemoryArena() = default;
+
+	void MemoryArena::Reserve(VkDeviceSize size)
+	{
+		if (size <= capacity)
+			return;
+
+		if (head != 0)
+			throw std::runtime_error("Memory arena " + name + " cannot grow with live allocations!");
+
+		// Grow geometrically to avoid reallocations when scenes are switched back and forth
+		capacity = std::max(size, capacity + capacity / 2);
+		buffer.reset(new Buffer(device, capacity, usage, allocateFlags, properties, category));
+		address = usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT ? buffer->GetDeviceAddress() : 0;
+
+		std::cout << "[AS POOL] " << name << " arena has been resized to "
+			<< static_cast<double>(capacity) / 1000000.0 << " MB" << std::endl;
+	}
+
+	void MemoryArena::Reset()
+	{
+		head = 0;
+	}
+
+	VkDeviceSize MemoryArena::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		// Align the device address when it is used (e.g. scratch memory), otherwise the buffer offset
+		const VkDeviceSize offset = (address + head + alignment - 1) / alignment * alignment - address;
+
+		if (offset + size > capacity)
+			throw std::runtime_error("Memory arena " + name + " is out of memory!");
+
+		head = offset + size;
+
+		return offset;
+	}
+
+	AccelerationStructurePool::AccelerationStructurePool(const Device& device)
+	{
+		const auto storage = static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR);
+
+		const auto scratch = static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		const auto instance = static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR);
+
+		const auto deviceLocal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		const auto hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		const auto address = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+		blas.reset(new MemoryArena(device, "BLAS", MemoryCategory::AccelerationStructures, storage, 0, deviceLocal));
+		tlas.reset(new MemoryArena(device, "TLAS", MemoryCategory::AccelerationStructures, storage, 0, deviceLocal));
+
+		scratchBLAS.reset(new MemoryArena(device, "Scratch BLAS", MemoryCategory::Scratch, scratch, address,
+		                                  deviceLocal));
+		scratchTLAS.reset(new MemoryArena(device, "Scratch TLAS", MemoryCategory::Scratch, scratch, address,
+		                                  deviceLocal));
+		instances.reset(new MemoryArena(device, "Instances", MemoryCategory::Instances, instance, address,
+		                                deviceLocal));
+
+		staging.reset(new MemoryArena(device, "Staging", MemoryCategory::Staging, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0,
+		                              hostVisible));
+	}
+
+	AccelerationStructurePool::~AccelerationStructurePool() = default;
+
+	void AccelerationStructurePool::Reset() const
+	{
+		blas->Reset();
+		scratchBLAS->Reset();
+		tlas->Reset();
+		scratchTLAS->Reset();
+		instances->Reset();
+		staging->Reset();
+	}
+}
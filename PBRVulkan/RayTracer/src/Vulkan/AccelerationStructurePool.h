@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Vulkan_api.h"
+#include "Telemetry.h"
+
+#include <memory>
+#include <string>
+
+namespace Vulkan
+{
+	/*
+	 * Persistent buffer which hands out aligned sub-ranges with a bump pointer.
+	 * All sub-allocations are released at once and the buffer is reallocated only when it has to grow.
+	 */
+	class MemoryArena final
+	{
+	public:
+		NON_COPIABLE(MemoryArena)
+
+		MemoryArena(
+			const class Device& device,
+			std::string name,
+			MemoryCategory category,
+			VkBufferUsageFlagBits usage,
+			VkMemoryAllocateFlags allocateFlags,
+			VkMemoryPropertyFlags properties);
+		~MemoryArena();
+
+		void Reserve(VkDeviceSize size);
+		void Reset();
+
+		[[nodiscard]] VkDeviceSize Allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+		[[nodiscard]] const class Buffer& GetBuffer() const
+		{
+			return *buffer;
+		}
+
+		[[nodiscard]] VkDeviceSize GetCapacity() const
+		{
+			return capacity;
+		}
+
+	private:
+		const Device& device;
+		const std::string name;
+		const MemoryCategory category;
+		const VkBufferUsageFlagBits usage;
+		const VkMemoryAllocateFlags allocateFlags;
+		const VkMemoryPropertyFlags properties;
+
+		VkDeviceSize capacity{};
+		VkDeviceSize head{};
+		VkDeviceAddress address{};
+		std::unique_ptr<Buffer> buffer;
+	};
+
+	/*
+	 * Memory of the acceleration structures which survives scene switches.
+	 * Reset() is called before every rebuild, the arenas keep their buffers and grow on demand.
+	 */
+	class AccelerationStructurePool final
+	{
+	public:
+		NON_COPIABLE(AccelerationStructurePool)
+
+		AccelerationStructurePool(const Device& device);
+		~AccelerationStructurePool();
+
+		void Reset() const;
+
+		[[nodiscard]] MemoryArena& GetBLAS() const
+		{
+			return *blas;
+		}
+
+		[[nodiscard]] MemoryArena& GetScratchBLAS() const
+		{
+			return *scratchBLAS;
+		}
+
+		[[nodiscard]] MemoryArena& GetTLAS() const
+		{
+			return *tlas;
+		}
+
+		[[nodiscard]] MemoryArena& GetScratchTLAS() const
+		{
+			return *scratchTLAS;
+		}
+
+		[[nodiscard]] MemoryArena& GetInstances() const
+		{
+			return *instances;
+		}
+
+		[[nodiscard]] MemoryArena& GetStaging() const
+		{
+			return *staging;
+		}
+
+	private:
+		std::unique_ptr<MemoryArena> blas;
+		std::unique_ptr<MemoryArena> scratchBLAS;
+		std::unique_ptr<MemoryArena> tlas;
+		std::unique_ptr<MemoryArena> scratchTLAS;
+		std::unique_ptr<MemoryArena> instances;
+		std::unique_ptr<MemoryArena> staging;
+	};
+}
@@ -0,0 +1,294 @@
+#include "AdaptiveSampler.h"
+
+#include <array>
+
+#include "Buffer.h"
+#include "Device.h"
+#include "PipelineCache.h"
+#include "Image.h"
+#include "ImageView.h"
+#include "Shader.h"
+#include "UniformRing.h"
+#include "DescriptorSetLayout.h"
+#include "DescriptorsManager.h"
+
+#include "../Geometry/Global.h"
+
+namespace Vulkan
+{
+	namespace
+	{
+		constexpr uint32_t GROUP_SIZE = 16;
+
+		struct PushConstants
+		{
+			float threshold;
+			uint32_t minSamples;
+		};
+	}
+
+	AdaptiveSampler::AdaptiveSampler(const Device& device,
+	                                 VkExtent2D extent,
+	                                 const ImageView& accumulationImage,
+	                                 const UniformRing& uniformRing):
+		device(device), extent(extent)
+	{
+		const auto momentsFormat = VK_FORMAT_R32_SFLOAT;
+
+		momentsImage.reset(
+			new Image(device, extent, momentsFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_TYPE_2D,
+			          VK_IMAGE_USAGE_STORAGE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
+
+		momentsImageView.reset(new ImageView(device, momentsImage->Get(), momentsFormat));
+
+		const auto usage = static_cast<VkBufferUsageFlagBits>(
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+
+		const size_t size = sizeof(Header) + sizeof(uint32_t) * extent.width * extent.height;
+
+		pixelList.reset(new Buffer(device, size, usage, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+		                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
+
+		groups = ((extent.width + GROUP_SIZE - 1) / GROUP_SIZE) * ((extent.height + GROUP_SIZE - 1) / GROUP_SIZE);
+
+		groupErrors.reset(new Buffer(device, sizeof(float) * groups,
+		                             static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT),
+		                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
+
+		// One region per frame in flight, persistently mapped like the uniform ring
+		const size_t readbackSize = sizeof(float) * groups * uniformRing.GetRegions();
+
+		readback.reset(new Buffer(device, readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                          MemoryCategory::Readback));
+
+		readbackErrors = static_cast<const float*>(readback->Map(0, readbackSize));
+
+		const Shader compactionShader(device, "Compaction.comp.spv");
+
+		const std::vector<DescriptorBinding> descriptorBindings =
+		{
+			{ 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT },
+		};
+
+		descriptorsManager.reset(new DescriptorsManager(device, uniformRing.GetRegions(), descriptorBindings));
+
+		std::vector<VkDescriptorSetLayout> layouts(uniformRing.GetRegions(),
+		                                           descriptorsManager->GetDescriptorSetLayout().Get());
+
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorsManager->GetDescriptorPool();
+		allocInfo.descriptorSetCount = uniformRing.GetRegions();
+		allocInfo.pSetLayouts = layouts.data();
+
+		descriptorSets.resize(uniformRing.GetRegions());
+
+		VK_CHECK(vkAllocateDescriptorSets(device.Get(), &allocInfo, descriptorSets.data()),
+		         "Allocate descriptor sets");
+
+		// The compaction reads the frame of the uniform region written for the same frame in flight
+		for (uint32_t frameIndex = 0; frameIndex < uniformRing.GetRegions(); frameIndex++)
+		{
+			std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
+
+			// Accumulation image
+			VkDescriptorImageInfo accumulationImageInfo = {};
+			accumulationImageInfo.imageView = accumulationImage.Get();
+			accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[0].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[0].dstBinding = 0;
+			descriptorWrites[0].dstArrayElement = 0;
+			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			descriptorWrites[0].descriptorCount = 1;
+			descriptorWrites[0].pImageInfo = &accumulationImageInfo;
+
+			// Moments image
+			VkDescriptorImageInfo momentsImageInfo = {};
+			momentsImageInfo.imageView = momentsImageView->Get();
+			momentsImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[1].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[1].dstBinding = 1;
+			descriptorWrites[1].dstArrayElement = 0;
+			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			descriptorWrites[1].descriptorCount = 1;
+			descriptorWrites[1].pImageInfo = &momentsImageInfo;
+
+			// Pixel list
+			VkDescriptorBufferInfo pixelListInfo = {};
+			pixelListInfo.buffer = pixelList->Get();
+			pixelListInfo.range = VK_WHOLE_SIZE;
+
+			descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[2].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[2].dstBinding = 2;
+			descriptorWrites[2].dstArrayElement = 0;
+			descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[2].descriptorCount = 1;
+			descriptorWrites[2].pBufferInfo = &pixelListInfo;
+
+			// Uniform buffer
+			VkDescriptorBufferInfo uniformBufferInfo = {};
+			uniformBufferInfo.buffer = uniformRing.GetBuffer().Get();
+			uniformBufferInfo.offset = uniformRing.GetRegionOffset(frameIndex);
+			uniformBufferInfo.range = sizeof(Uniforms::Global);
+
+			descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[3].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[3].dstBinding = 3;
+			descriptorWrites[3].dstArrayElement = 0;
+			descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrites[3].descriptorCount = 1;
+			descriptorWrites[3].pBufferInfo = &uniformBufferInfo;
+
+			// Errors of workgroups
+			VkDescriptorBufferInfo groupErrorsInfo = {};
+			groupErrorsInfo.buffer = groupErrors->Get();
+			groupErrorsInfo.range = VK_WHOLE_SIZE;
+
+			descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[4].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[4].dstBinding = 4;
+			descriptorWrites[4].dstArrayElement = 0;
+			descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[4].descriptorCount = 1;
+			descriptorWrites[4].pBufferInfo = &groupErrorsInfo;
+
+			vkUpdateDescriptorSets(device.Get(), static_cast<uint32_t>(descriptorWrites.size()),
+			                       descriptorWrites.data(), 0, nullptr);
+		}
+
+		VkDescriptorSetLayout descriptorSetLayouts[] = { descriptorsManager->GetDescriptorSetLayout().Get() };
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(PushConstants);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
+
+		VK_CHECK(vkCreatePipelineLayout(device.Get(), &pipelineLayoutInfo, nullptr, &pipelineLayout),
+		         "Create compaction pipeline layout");
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.stage = compactionShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+		pipelineInfo.basePipelineHandle = nullptr;
+		pipelineInfo.basePipelineIndex = -1;
+
+		VK_CHECK(vkCreateComputePipelines(device.Get(), device.GetPipelineCache().Get(), 1, &pipelineInfo,
+		                                  nullptr, &pipeline),
+		         "Create compaction pipeline");
+	}
+
+	AdaptiveSampler::~AdaptiveSampler()
+	{
+		readback->Unmap();
+
+		if (pipeline != nullptr)
+		{
+			vkDestroyPipeline(device.Get(), pipeline, nullptr);
+			pipeline = nullptr;
+		}
+
+		if (pipelineLayout != nullptr)
+		{
+			vkDestroyPipelineLayout(device.Get(), pipelineLayout, nullptr);
+			pipelineLayout = nullptr;
+		}
+	}
+
+	void AdaptiveSampler::Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, float threshold) const
+	{
+		// The previous traces read the list and write the statistics
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		const Header header{ 0, 1, 1, 0 };
+		vkCmdUpdateBuffer(commandBuffer, pixelList->Get(), 0, sizeof(header), &header);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		const PushConstants constants{ threshold, MIN_SAMPLES };
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout,
+		                        0, 1, &descriptorSets[frameIndex], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants),
+		                   &constants);
+		vkCmdDispatch(commandBuffer, (extent.width + GROUP_SIZE - 1) / GROUP_SIZE,
+		              (extent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+		// The trace reads the dispatch size and the pixels, the errors are copied for the host
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+			VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.dstOffset = sizeof(float) * groups * frameIndex;
+		copyRegion.size = sizeof(float) * groups;
+
+		vkCmdCopyBuffer(commandBuffer, groupErrors->Get(), readback->Get(), 1, &copyRegion);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_HOST_BIT,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	float AdaptiveSampler::GetError(uint32_t frameIndex) const
+	{
+		const float* errors = readbackErrors + groups * frameIndex;
+		double sum = 0.0;
+
+		for (uint32_t i = 0; i < groups; ++i)
+			sum += errors[i];
+
+		return static_cast<float>(sum / (static_cast<double>(extent.width) * extent.height));
+	}
+
+	VkDeviceAddress AdaptiveSampler::GetIndirectAddress() const
+	{
+		return pixelList->GetDeviceAddress();
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Vulkan
+{
+	/*
+	 * Per pixel adaptive sampling. The ray generation shader keeps the sample count in the alpha channel
+	 * of the accumulation image and the sum of squared luminances in the moments image.
+	 * A compute pass compacts pixels whose standard error is above the threshold into a list,
+	 * which is traced with vkCmdTraceRaysIndirectKHR until the next compaction.
+	 * Every workgroup also sums the errors of its pixels, the sums are read back to estimate the error of the frame.
+	 */
+	class AdaptiveSampler final
+	{
+	public:
+		NON_COPIABLE(AdaptiveSampler)
+
+		// Pixels with less samples are always traced as their variance estimate is not reliable
+		static constexpr uint32_t MIN_SAMPLES = 16;
+
+		// Matches the header of the PixelList buffer, the layout of VkTraceRaysIndirectCommandKHR
+		struct Header
+		{
+			uint32_t width;
+			uint32_t height;
+			uint32_t depth;
+			uint32_t padding;
+		};
+
+		AdaptiveSampler(const class Device& device,
+		                VkExtent2D extent,
+		                const class ImageView& accumulationImage,
+		                const class UniformRing& uniformRing);
+		~AdaptiveSampler();
+
+		// Rebuilds the list of unconverged pixels from the accumulated statistics
+		void Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, float threshold) const;
+
+		/*
+		 * Mean relative standard error of the frame measured by the last compaction of the frame in flight,
+		 * pixels with too few samples count as 1. It can be read once the frame fence was waited on.
+		 */
+		[[nodiscard]] float GetError(uint32_t frameIndex) const;
+
+		[[nodiscard]] const class ImageView& GetMomentsImageView() const
+		{
+			return *momentsImageView;
+		}
+
+		[[nodiscard]] const class Buffer& GetPixelList() const
+		{
+			return *pixelList;
+		}
+
+		[[nodiscard]] VkDeviceAddress GetIndirectAddress() const;
+
+	private:
+		const Device& device;
+		const VkExtent2D extent;
+
+		std::unique_ptr<class Image> momentsImage;
+		std::unique_ptr<class ImageView> momentsImageView;
+		std::unique_ptr<class Buffer> pixelList;
+		std::unique_ptr<class Buffer> groupErrors;
+		std::unique_ptr<class Buffer> readback;
+		const float* readbackErrors{};
+		uint32_t groups{};
+
+		VkPipeline pipeline{};
+		VkPipelineLayout pipelineLayout{};
+
+		std::vector<VkDescriptorSet> descriptorSets;
+		std::unique_ptr<class DescriptorsManager> descriptorsManager;
+	};
+}
@@ -0,0 +1,205 @@
+#include "Allocator.h"
+
+#include <iostream>
+
+#include "Device.h"
+
+namespace Vulkan
+{
+	Allocator::Allocator(const Device& device) : device(device)
+	{
+		vkGetPhysicalDeviceMemoryProperties(device.GetPhysical(), &memoryProperties);
+	}
+
+	Allocator::~Allocator()
+	{
+		for (auto& pool : pools)
+		{
+			for (const auto& block : pool.blocks)
+			{
+				if (block.memory != nullptr)
+					FreeMemory(block.memory, block.mapped);
+			}
+		}
+	}
+
+	Allocation Allocator::Allocate(
+		VkMemoryRequirements requirements,
+		VkMemoryAllocateFlags allocateFlags,
+		VkMemoryPropertyFlags properties,
+		bool linear)
+	{
+		// Persistent mappings are never flushed, every resource supports a host visible and coherent type
+		if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		const uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Allocation allocation{};
+		allocation.size = requirements.size;
+
+		if (BlockList::IsDedicated(requirements.size))
+		{
+			allocation.memory = AllocateMemory(requirements.size, memoryType, allocateFlags, &allocation.mapped);
+
+			statistics.dedicated++;
+			statistics.allocations++;
+			statistics.reserved += requirements.size;
+			statistics.used += requirements.size;
+
+			return allocation;
+		}
+
+		allocation.pool = GetPool(memoryType, allocateFlags, linear);
+		auto& pool = pools[allocation.pool];
+
+		allocation.placement = pool.placement.Allocate(requirements.size, requirements.alignment);
+
+		if (allocation.placement.block != BlockList::INVALID)
+		{
+			const auto& block = pool.blocks[allocation.placement.block];
+
+			allocation.memory = block.memory;
+			allocation.offset = allocation.placement.offset;
+			allocation.mapped = block.mapped;
+
+			statistics.allocations++;
+			statistics.used += requirements.size;
+
+			return allocation;
+		}
+
+		// The device memory is allocated first, the placement is left untouched when it fails
+		Block block{};
+		block.memory = AllocateMemory(BlockList::BLOCK_SIZE, memoryType, allocateFlags, &block.mapped);
+
+		allocation.placement = pool.placement.AllocateBlock(requirements.size, requirements.alignment);
+
+		if (allocation.placement.block >= pool.blocks.size())
+			pool.blocks.resize(allocation.placement.block + 1);
+
+		pool.blocks[allocation.placement.block] = block;
+
+		allocation.memory = block.memory;
+		allocation.offset = allocation.placement.offset;
+		allocation.mapped = block.mapped;
+
+		statistics.blocks++;
+		statistics.allocations++;
+		statistics.reserved += BlockList::BLOCK_SIZE;
+		statistics.used += requirements.size;
+
+		std::cout << "[ALLOCATOR] New block of memory type " << memoryType << ", " << statistics.blocks <<
+			" blocks in total" << std::endl;
+
+		return allocation;
+	}
+
+	void Allocator::Free(const Allocation& allocation)
+	{
+		if (allocation.memory == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		statistics.allocations--;
+		statistics.used -= allocation.size;
+
+		if (allocation.placement.block == BlockList::INVALID)
+		{
+			FreeMemory(allocation.memory, allocation.mapped);
+
+			statistics.dedicated--;
+			statistics.reserved -= allocation.size;
+
+			return;
+		}
+
+		auto& pool = pools[allocation.pool];
+
+		if (!pool.placement.Free(allocation.placement, allocation.size))
+			return;
+
+		auto& block = pool.blocks[allocation.placement.block];
+
+		FreeMemory(block.memory, block.mapped);
+		pool.placement.Release(allocation.placement.block);
+		block = {};
+
+		statistics.blocks--;
+		statistics.reserved -= BlockList::BLOCK_SIZE;
+	}
+
+	uint32_t Allocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i != memoryProperties.memoryTypeCount; ++i)
+		{
+			if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+
+		throw std::runtime_error("Failed to find suitable memory type!");
+	}
+
+	Allocator::Statistics Allocator::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return statistics;
+	}
+
+	size_t Allocator::GetPool(uint32_t memoryType, VkMemoryAllocateFlags allocateFlags, bool linear)
+	{
+		for (size_t i = 0; i < pools.size(); ++i)
+		{
+			const auto& pool = pools[i];
+
+			if (pool.memoryType == memoryType && pool.allocateFlags == allocateFlags && pool.linear == linear)
+				return i;
+		}
+
+		pools.push_back({ memoryType, allocateFlags, linear, {} });
+
+		return pools.size() - 1;
+	}
+
+	VkDeviceMemory Allocator::AllocateMemory(
+		VkDeviceSize size,
+		uint32_t memoryType,
+		VkMemoryAllocateFlags allocateFlags,
+		void** mapped) const
+	{
+		VkMemoryAllocateFlagsInfo flagsInfo = {};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+		flagsInfo.pNext = nullptr;
+		flagsInfo.flags = allocateFlags;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = &flagsInfo;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory;
+
+		VK_CHECK(vkAllocateMemory(device.Get(), &allocInfo, nullptr, &memory), "Allocate memory");
+
+		*mapped = nullptr;
+
+		if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			VK_CHECK(vkMapMemory(device.Get(), memory, 0, VK_WHOLE_SIZE, 0, mapped), "Map memory");
+
+		return memory;
+	}
+
+	void Allocator::FreeMemory(VkDeviceMemory memory, void* mapped) const
+	{
+		if (mapped != nullptr)
+			vkUnmapMemory(device.Get(), memory);
+
+		vkFreeMemory(device.Get(), memory, nullptr);
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <mutex>
+#include <vector>
+
+#include "BlockList.h"
+
+namespace Vulkan
+{
+	/*
+	 * Sub-range of a device memory block handed out by the allocator.
+	 */
+	struct Allocation
+	{
+		VkDeviceMemory memory{};
+		VkDeviceSize offset{};
+		VkDeviceSize size{};
+		// Host visible memory is coherent and mapped once for its whole lifetime
+		void* mapped{};
+		// Owning block of the pool, INVALID for dedicated allocations
+		BlockList::Placement placement{};
+		size_t pool{};
+	};
+
+	/*
+	 * Device memory sub-allocator.
+	 * Resources are placed in large blocks pooled by memory type, allocation flags and tiling.
+	 * Linear and optimal resources never share a block, thus bufferImageGranularity does not apply.
+	 * The placement within the blocks follows BlockList.
+	 */
+	class Allocator final
+	{
+	public:
+		NON_COPIABLE(Allocator)
+
+		struct Statistics
+		{
+			uint32_t blocks;
+			uint32_t dedicated;
+			uint32_t allocations;
+			VkDeviceSize reserved;
+			VkDeviceSize used;
+		};
+
+		explicit Allocator(const class Device& device);
+		~Allocator();
+
+		[[nodiscard]] Allocation Allocate(
+			VkMemoryRequirements requirements,
+			VkMemoryAllocateFlags allocateFlags,
+			VkMemoryPropertyFlags properties,
+			bool linear);
+
+		void Free(const Allocation& allocation);
+
+		[[nodiscard]] uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory{};
+			void* mapped{};
+		};
+
+		struct Pool
+		{
+			uint32_t memoryType;
+			VkMemoryAllocateFlags allocateFlags;
+			bool linear;
+			BlockList placement;
+			// Indexed like the blocks of the placement
+			std::vector<Block> blocks;
+		};
+
+		const Device& device;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		std::vector<Pool> pools;
+		Statistics statistics{};
+		mutable std::mutex mutex;
+
+		[[nodiscard]] size_t GetPool(uint32_t memoryType, VkMemoryAllocateFlags allocateFlags, bool linear);
+		[[nodiscard]] VkDeviceMemory AllocateMemory(
+			VkDeviceSize size,
+			uint32_t memoryType,
+			VkMemoryAllocateFlags allocateFlags,
+			void** mapped) const;
+		void FreeMemory(VkDeviceMemory memory, void* mapped) const;
+	};
+}
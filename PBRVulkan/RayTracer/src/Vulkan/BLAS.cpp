@@ -1,5 +1,6 @@
 #include "BLAS.h"
 
+#include <iostream>
 #include <utility>
 #include <vector>
 
@@ -13,14 +14,95 @@
 
 namespace Vulkan
 {
+	namespace
+	{
+		VkBuildAccelerationStructureFlagsKHR GetBuildFlags(BuildPolicy policy)
+		{
+			switch (policy)
+			{
+			case BuildPolicy::FastBuild:
+				return VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+			case BuildPolicy::LowMemory:
+				return VK_BUILD_ACCELERATION_STRUCTURE_LOW_MEMORY_BIT_KHR;
+			default:
+				return VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+			}
+		}
+	}
+
+	void BuildPolicySelector::Reset(float budget, uint32_t lowMemoryThreshold)
+	{
+		this->budget = budget;
+		this->lowMemoryThreshold = lowMemoryThreshold;
+		estimated = 0.f;
+		fastTracePrimitives = 0;
+		otherPrimitives = 0;
+	}
+
+	void BuildPolicySelector::Calibrate(float milliseconds)
+	{
+		const float work = fastTracePrimitives + otherPrimitives / FAST_BUILD_SPEEDUP;
+
+		if (milliseconds <= 0.f || work <= 0.f)
+			return;
+
+		throughput = work / milliseconds;
+
+		std::cout << "[BLAS] Build throughput: " << throughput << " triangles per millisecond" << std::endl;
+	}
+
+	BuildPolicy BuildPolicySelector::Select(uint32_t primitiveCount, bool isDynamic)
+	{
+		BuildPolicy policy = BuildPolicy::FastTrace;
+
+		if (isDynamic)
+		{
+			policy = BuildPolicy::FastBuild;
+		}
+		else if (lowMemoryThreshold > 0 && primitiveCount > lowMemoryThreshold)
+		{
+			policy = BuildPolicy::LowMemory;
+		}
+		else if (budget > 0.f && estimated + primitiveCount / throughput > budget)
+		{
+			policy = BuildPolicy::FastBuild;
+		}
+
+		if (policy == BuildPolicy::FastTrace)
+		{
+			estimated += primitiveCount / throughput;
+			fastTracePrimitives += primitiveCount;
+		}
+		else
+		{
+			estimated += primitiveCount / (throughput * FAST_BUILD_SPEEDUP);
+			otherPrimitives += primitiveCount;
+		}
+
+		return policy;
+	}
+
+	const char* BuildPolicySelector::ToString(BuildPolicy policy)
+	{
+		switch (policy)
+		{
+		case BuildPolicy::FastBuild:
+			return "FAST_BUILD";
+		case BuildPolicy::LowMemory:
+			return "LOW_MEMORY";
+		default:
+			return "FAST_TRACE";
+		}
+	}
+
 	BLAS::BLAS(BLAS&& other) noexcept
-		: AccelerationStructure(std::move(other)), geometry(std::move(other.geometry)) { }
+		: AccelerationStructure(std::move(other)), geometry(std::move(other.geometry)), policy(other.policy) { }
 
-	BLAS::BLAS(const Device& _device, BLASGeometry _geometry):
-		AccelerationStructure(_device), geometry(std::move(_geometry))
+	BLAS::BLAS(const Device& _device, BLASGeometry _geometry, BuildPolicy policy):
+		AccelerationStructure(_device), geometry(std::move(_geometry)), policy(policy)
 	{
 		buildGeometryInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
-		buildGeometryInfo.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+		buildGeometryInfo.flags = GetBuildFlags(policy);
 		buildGeometryInfo.geometryCount = static_cast<uint32_t>(geometry.triangles.size());
 		buildGeometryInfo.pGeometries = geometry.triangles.data();
 		buildGeometryInfo.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
@@ -37,9 +119,19 @@ namespace Vulkan
 		buildSizesInfo = GetMemorySizes(maxPrimCount.data());
 	}
 
+	uint32_t BLAS::GetPrimitiveCount() const
+	{
+		uint32_t count = 0;
+
+		for (const auto& buildOffset : geometry.buildOffsets)
+			count += buildOffset.primitiveCount;
+
+		return count;
+	}
+
 	void BLASGeometry::CreateGeometry(
 		const Tracer::Scene& scene, uint32_t vertexOffset, uint32_t vertexCount,
-		uint32_t indexOffset, uint32_t indexCount, bool isOpaque)
+		uint32_t indexOffset, uint32_t indexCount, VkIndexType indexType, bool isOpaque)
 	{
 		VkAccelerationStructureGeometryKHR geometry = {};
 
@@ -49,17 +141,17 @@ namespace Vulkan
 		geometry.geometry.triangles.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
 		geometry.geometry.triangles.pNext = nullptr;
 		geometry.geometry.triangles.vertexData.deviceAddress = scene.GetVertexBuffer().GetDeviceAddress();
-		geometry.geometry.triangles.vertexStride = sizeof(Geometry::Vertex);
+		geometry.geometry.triangles.vertexStride = sizeof(Geometry::PackedVertex);
 		geometry.geometry.triangles.maxVertex = vertexCount;
 		geometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
 		geometry.geometry.triangles.indexData.deviceAddress = scene.GetIndexBuffer().GetDeviceAddress();
-		geometry.geometry.triangles.indexType = VK_INDEX_TYPE_UINT32;
+		geometry.geometry.triangles.indexType = indexType;
 		geometry.geometry.triangles.transformData = {};
 		geometry.flags = isOpaque ? VK_GEOMETRY_OPAQUE_BIT_KHR : 0;
 
 		VkAccelerationStructureBuildRangeInfoKHR buildOffsetInfo = {};
 
-		buildOffsetInfo.firstVertex = vertexOffset / sizeof(Geometry::Vertex);
+		buildOffsetInfo.firstVertex = vertexOffset / sizeof(Geometry::PackedVertex);
 		buildOffsetInfo.primitiveOffset = indexOffset;
 		buildOffsetInfo.primitiveCount = indexCount / 3;
 		buildOffsetInfo.transformOffset = 0;
@@ -68,6 +160,30 @@ namespace Vulkan
 		buildOffsets.emplace_back(buildOffsetInfo);
 	}
 
+	void BLASGeometry::CreateAABBs(VkDeviceAddress aabbsAddress, uint32_t aabbsCount, bool isOpaque)
+	{
+		VkAccelerationStructureGeometryKHR geometry = {};
+
+		geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+		geometry.pNext = nullptr;
+		geometry.geometryType = VK_GEOMETRY_TYPE_AABBS_KHR;
+		geometry.geometry.aabbs.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
+		geometry.geometry.aabbs.pNext = nullptr;
+		geometry.geometry.aabbs.data.deviceAddress = aabbsAddress;
+		geometry.geometry.aabbs.stride = sizeof(VkAabbPositionsKHR);
+		geometry.flags = isOpaque ? VK_GEOMETRY_OPAQUE_BIT_KHR : 0;
+
+		VkAccelerationStructureBuildRangeInfoKHR buildOffsetInfo = {};
+
+		buildOffsetInfo.firstVertex = 0;
+		buildOffsetInfo.primitiveOffset = 0;
+		buildOffsetInfo.primitiveCount = aabbsCount;
+		buildOffsetInfo.transformOffset = 0;
+
+		triangles.emplace_back(geometry);
+		buildOffsets.emplace_back(buildOffsetInfo);
+	}
+
 	void BLAS::Generate(
 		VkCommandBuffer commandBuffer,
 		const Buffer& scratchBuffer,
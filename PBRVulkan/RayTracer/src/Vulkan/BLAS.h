@@ -11,6 +11,46 @@ namespace Tracer
 
 namespace Vulkan
 {
+	/**
+	 * Build preference of a BLAS
+	 */
+	enum class BuildPolicy
+	{
+		FastTrace,
+		FastBuild,
+		LowMemory
+	};
+
+	/**
+	 * Chooses the build policy of every BLAS of a scene:
+	 * - dynamic instances are rebuilt often and prefer a fast build,
+	 * - structures above the low memory threshold prefer a small footprint,
+	 * - the rest prefers a fast trace while the estimated build time fits into the budget.
+	 * The build throughput is calibrated with the duration of the previous build.
+	 */
+	class BuildPolicySelector final
+	{
+	public:
+		void Reset(float budget, uint32_t lowMemoryThreshold);
+		void Calibrate(float milliseconds);
+
+		[[nodiscard]] BuildPolicy Select(uint32_t primitiveCount, bool isDynamic);
+
+		static const char* ToString(BuildPolicy policy);
+
+	private:
+		// Fast build is assumed to be twice as fast as fast trace
+		static constexpr float FAST_BUILD_SPEEDUP = 2.f;
+
+		// Fast trace triangles built per millisecond
+		float throughput = 100000.f;
+		float budget{};
+		float estimated{};
+		uint32_t lowMemoryThreshold{};
+		uint64_t fastTracePrimitives{};
+		uint64_t otherPrimitives{};
+	};
+
 	/**
 	 * Bottom Level Acceleration Structure geometry wrapper
 	 */
@@ -23,6 +63,12 @@ namespace Vulkan
 			uint32_t vertexCount,
 			uint32_t indexOffset,
 			uint32_t indexCount,
+			VkIndexType indexType,
+			bool isOpaque);
+
+		void CreateAABBs(
+			VkDeviceAddress aabbsAddress,
+			uint32_t aabbsCount,
 			bool isOpaque);
 		
 		std::vector<VkAccelerationStructureGeometryKHR> triangles;
@@ -39,7 +85,7 @@ namespace Vulkan
 		BLAS& operator = (const BLAS&) = delete;
 		BLAS& operator = (BLAS&&) = delete;
 		BLAS(BLAS&& other) noexcept;
-		BLAS(const Device& device, BLASGeometry geometry);
+		BLAS(const Device& device, BLASGeometry geometry, BuildPolicy policy = BuildPolicy::FastTrace);
 
 		void Generate(
 			VkCommandBuffer commandBuffer,
@@ -48,7 +94,15 @@ namespace Vulkan
 			const class Buffer& blasBuffer,
 			VkDeviceSize resultOffset);
 
+		[[nodiscard]] BuildPolicy GetPolicy() const
+		{
+			return policy;
+		}
+
+		[[nodiscard]] uint32_t GetPrimitiveCount() const;
+
 	private:
 		BLASGeometry geometry;
+		BuildPolicy policy;
 	};
 }
@@ -0,0 +1,94 @@
+#include "BlockList.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Vulkan
+{
+	BlockList::Placement BlockList::Allocate(uint64_t size, uint64_t alignment)
+	{
+		// Blocks which surely fit the aligned resource are tried first
+		for (const uint64_t minimum : { size + alignment - 1, size })
+		{
+			for (size_t i = 0; i < blocks.size(); ++i)
+			{
+				if (!blocks[i] || largest[i] < minimum)
+					continue;
+
+				const auto offset = blocks[i]->Allocate(size, alignment);
+				largest[i] = blocks[i]->GetLargestRange();
+
+				if (offset != FreeList::INVALID)
+					return { static_cast<uint32_t>(i), offset };
+			}
+		}
+
+		return {};
+	}
+
+	BlockList::Placement BlockList::AllocateBlock(uint64_t size, uint64_t alignment)
+	{
+		if (IsDedicated(size))
+			throw std::runtime_error("Resource does not fit a block");
+
+		const auto slot = std::find(blocks.begin(), blocks.end(), nullptr);
+		const auto block = static_cast<size_t>(slot - blocks.begin());
+
+		if (slot == blocks.end())
+		{
+			blocks.emplace_back();
+			largest.emplace_back();
+		}
+
+		blocks[block].reset(new FreeList(BLOCK_SIZE));
+
+		const auto offset = blocks[block]->Allocate(size, alignment);
+		largest[block] = blocks[block]->GetLargestRange();
+
+		return { static_cast<uint32_t>(block), offset };
+	}
+
+	bool BlockList::Free(const Placement& placement, uint64_t size)
+	{
+		const auto& freeList = blocks[placement.block];
+
+		freeList->Free(placement.offset, size);
+		largest[placement.block] = freeList->GetLargestRange();
+
+		if (!freeList->IsEmpty())
+			return false;
+
+		const auto empty = std::count_if(blocks.begin(), blocks.end(), [](const std::unique_ptr<FreeList>& other)
+		{
+			return other && other->IsEmpty();
+		});
+
+		return empty >= 2;
+	}
+
+	void BlockList::Release(uint32_t block)
+	{
+		blocks[block].reset();
+		largest[block] = 0;
+	}
+
+	uint32_t BlockList::GetBlocks() const
+	{
+		uint32_t count = 0;
+
+		for (const auto& block : blocks)
+			count += block ? 1 : 0;
+
+		return count;
+	}
+
+	uint64_t BlockList::GetUsed() const
+	{
+		uint64_t used = 0;
+
+		for (const auto& block : blocks)
+			used += block ? block->GetUsed() : 0;
+
+		return used;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "FreeList.h"
+
+namespace Vulkan
+{
+	/*
+	 * Placement of resources in the fixed size blocks of a memory pool, free of any device objects,
+	 * thus the allocator and its benchmark share the same policy.
+	 * Blocks are skipped by their largest free range without searching their free lists.
+	 * Resources larger than half of a block get a dedicated allocation instead.
+	 * Block indices stay valid until the block is released, released slots are reused.
+	 */
+	class BlockList final
+	{
+	public:
+		static constexpr uint64_t BLOCK_SIZE = 64ull * 1024 * 1024;
+		static constexpr uint32_t INVALID = ~0u;
+
+		struct Placement
+		{
+			uint32_t block = INVALID;
+			uint64_t offset{};
+		};
+
+		[[nodiscard]] static bool IsDedicated(uint64_t size)
+		{
+			return size > BLOCK_SIZE / 2;
+		}
+
+		// Placement in an existing block, the block is INVALID when none of them fits
+		[[nodiscard]] Placement Allocate(uint64_t size, uint64_t alignment);
+
+		// Places the resource at the start of a new block
+		[[nodiscard]] Placement AllocateBlock(uint64_t size, uint64_t alignment);
+
+		// Returns true when the block should be released, a single empty block is kept to avoid reallocations
+		[[nodiscard]] bool Free(const Placement& placement, uint64_t size);
+
+		void Release(uint32_t block);
+
+		[[nodiscard]] uint32_t GetBlocks() const;
+		[[nodiscard]] uint64_t GetUsed() const;
+
+	private:
+		// Null for released slots
+		std::vector<std::unique_ptr<FreeList>> blocks;
+		// Largest free range of every block, zero for released slots
+		std::vector<uint64_t> largest;
+	};
+}
@@ -2,19 +2,19 @@
 
 #include "Device.h"
 #include "Memory.h"
-#include "CommandPool.h"
-#include "Command.cpp"
 
 namespace Vulkan
 {
-	Buffer::Buffer(const Device& device, size_t size, VkBufferUsageFlagBits usage, VkMemoryPropertyFlags properties):
-		Buffer(device, size, usage, 0, properties) { }
+	Buffer::Buffer(const Device& device, size_t size, VkBufferUsageFlagBits usage, VkMemoryPropertyFlags properties,
+	               MemoryCategory category):
+		Buffer(device, size, usage, 0, properties, category) { }
 
 	Buffer::Buffer(const Device& device,
 	               size_t size,
 	               VkBufferUsageFlagBits usage,
 	               VkMemoryAllocateFlags allocateFLags,
-	               VkMemoryPropertyFlags properties) : size(size), device(device)
+	               VkMemoryPropertyFlags properties,
+	               MemoryCategory category) : size(size), device(device)
 	{
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -24,9 +24,9 @@ namespace Vulkan
 
 		VK_CHECK(vkCreateBuffer(device.Get(), &bufferInfo, nullptr, &buffer), "Create buffer");
 
-		memory.reset(new Memory(device, GetMemoryRequirements(), allocateFLags, properties));
+		memory.reset(new Memory(device, GetMemoryRequirements(), allocateFLags, properties, category));
 
-		VK_CHECK(vkBindBufferMemory(device.Get(), buffer, memory->Get(), 0), "Bind buffer memory");
+		VK_CHECK(vkBindBufferMemory(device.Get(), buffer, memory->Get(), memory->GetOffset()), "Bind buffer memory");
 	}
 
 	Buffer::~Buffer()
@@ -38,19 +38,6 @@ namespace Vulkan
 		}
 	}
 
-	void Buffer::Copy(const CommandPool& commandPool, const Buffer& src)
-	{
-		Command::Submit(commandPool, [&](VkCommandBuffer cmd)-> void
-		{
-			VkBufferCopy copyRegion = {};
-			copyRegion.srcOffset = 0;
-			copyRegion.dstOffset = 0;
-			copyRegion.size = size;
-
-			vkCmdCopyBuffer(cmd, src.Get(), buffer, 1, &copyRegion);
-		});
-	}
-
 	void Buffer::Fill(const void* data) const
 	{
 		memory->Fill(data, size);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vulkan_api.h"
+#include "Telemetry.h"
 
 #include <memory>
 
@@ -15,18 +16,19 @@ namespace Vulkan
 			const class Device& device,
 			size_t size,
 			VkBufferUsageFlagBits usage,
-			VkMemoryPropertyFlags properties);
+			VkMemoryPropertyFlags properties,
+			MemoryCategory category = MemoryCategory::Other);
 
 		Buffer(
 			const class Device& device,
 			size_t size,
 			VkBufferUsageFlagBits usage,
 			VkMemoryAllocateFlags allocateFLags,
-			VkMemoryPropertyFlags properties);
+			VkMemoryPropertyFlags properties,
+			MemoryCategory category = MemoryCategory::Other);
 
 		~Buffer();
 
-		void Copy(const class CommandPool& commandPool, const Buffer& src);
 		void Fill(const void* data) const;
 		void Unmap() const;
 
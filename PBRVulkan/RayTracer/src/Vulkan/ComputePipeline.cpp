@@ -6,7 +6,9 @@
 #include "Shader.h"
 #include "SwapChain.h"
 #include "Device.h"
+#include "PipelineCache.h"
 #include "Buffer.h"
+#include "UniformRing.h"
 #include "ImageView.h"
 #include "DescriptorSetLayout.h"
 #include "DescriptorsManager.h"
@@ -17,12 +19,9 @@ namespace Vulkan
 {
 	ComputePipeline::ComputePipeline(const SwapChain& swapChain,
 	                                 const Device& device,
-	                                 const ImageView& inputImage,
-	                                 const ImageView& outputImage,
-	                                 const ImageView& normalsImage,
-	                                 const ImageView& positionsImage,
-	                                 const std::vector<std::unique_ptr<class Buffer>>& uniformBuffers)
-		: device(device), swapChain(swapChain)
+	                                 const UniformRing& uniformRing,
+	                                 uint32_t frames)
+		: device(device), swapChain(swapChain), uniformRing(uniformRing)
 	{
 		const Shader denoiserShader(device, "Denoiser.comp.spv");
 		const Shader edgeDetectShader(device, "Edgedetect.comp.spv");
@@ -44,21 +43,70 @@ namespace Vulkan
 			{ 4, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT },
 		};
 
-		descriptorsManager.reset(new DescriptorsManager(device, swapChain, descriptorBindings));
+		descriptorsManager.reset(new DescriptorsManager(device, frames, descriptorBindings));
 
-		std::vector<VkDescriptorSetLayout> layouts(1, descriptorsManager->GetDescriptorSetLayout().Get());
+		std::vector<VkDescriptorSetLayout> layouts(frames, descriptorsManager->GetDescriptorSetLayout().Get());
 
 		VkDescriptorSetAllocateInfo allocInfo = {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocInfo.descriptorPool = descriptorsManager->GetDescriptorPool();
-		allocInfo.descriptorSetCount = 1;
+		allocInfo.descriptorSetCount = frames;
 		allocInfo.pSetLayouts = layouts.data();
 
-		descriptorSets.resize(1);
+		descriptorSets.resize(frames);
 
 		VK_CHECK(vkAllocateDescriptorSets(device.Get(), &allocInfo, descriptorSets.data()),
 		         "Allocate descriptor sets");
 
+		VkDescriptorSetLayout descriptorSetLayouts[] = { descriptorsManager->GetDescriptorSetLayout().Get() };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
+		pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
+
+		VK_CHECK(vkCreatePipelineLayout(device.Get(), &pipelineLayoutInfo, nullptr, &pipelineLayout),
+		         "Create compute pipeline layout");
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.flags = 0;
+		pipelineInfo.pNext = nullptr;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineHandle = nullptr;
+		pipelineInfo.basePipelineIndex = -1;
+
+		for (auto& shader : shaderStages)
+		{
+			VkPipeline pipeline;
+			pipelineInfo.stage = shader;
+			VK_CHECK(vkCreateComputePipelines(device.Get(), device.GetPipelineCache().Get(), 1, &pipelineInfo,
+			                                  nullptr, &pipeline),
+			         "Create compute pipeline");
+			pipelines.push_back(pipeline);
+		}
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		for (auto* pipeline : pipelines)
+			vkDestroyPipeline(device.Get(), pipeline, nullptr);
+
+		if (pipelineLayout != nullptr)
+		{
+			vkDestroyPipelineLayout(device.Get(), pipelineLayout, nullptr);
+			pipelineLayout = nullptr;
+		}
+	}
+
+	void ComputePipeline::UpdateDescriptorSet(uint32_t frameIndex,
+	                                          const ImageView& inputImage,
+	                                          const ImageView& outputImage,
+	                                          const ImageView& normalsImage,
+	                                          const ImageView& positionsImage) const
+	{
 		std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
 
 		// Input image
@@ -67,7 +115,7 @@ namespace Vulkan
 		inputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = descriptorSets[0];
+		descriptorWrites[0].dstSet = descriptorSets[frameIndex];
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
 		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -80,7 +128,7 @@ namespace Vulkan
 		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[1].dstSet = descriptorSets[0];
+		descriptorWrites[1].dstSet = descriptorSets[frameIndex];
 		descriptorWrites[1].dstBinding = 1;
 		descriptorWrites[1].dstArrayElement = 0;
 		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -93,7 +141,7 @@ namespace Vulkan
 		normalsImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[2].dstSet = descriptorSets[0];
+		descriptorWrites[2].dstSet = descriptorSets[frameIndex];
 		descriptorWrites[2].dstBinding = 2;
 		descriptorWrites[2].dstArrayElement = 0;
 		descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -106,7 +154,7 @@ namespace Vulkan
 		positionsImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[3].dstSet = descriptorSets[0];
+		descriptorWrites[3].dstSet = descriptorSets[frameIndex];
 		descriptorWrites[3].dstBinding = 3;
 		descriptorWrites[3].dstArrayElement = 0;
 		descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -115,12 +163,12 @@ namespace Vulkan
 
 		// Uniforms descriptor
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = uniformBuffers[0]->Get();
-		bufferInfo.offset = 0;
+		bufferInfo.buffer = uniformRing.GetBuffer().Get();
+		bufferInfo.offset = uniformRing.GetRegionOffset(0);
 		bufferInfo.range = sizeof(Uniforms::Compute);
 
 		descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[4].dstSet = descriptorSets[0];
+		descriptorWrites[4].dstSet = descriptorSets[frameIndex];
 		descriptorWrites[4].dstBinding = 4;
 		descriptorWrites[4].dstArrayElement = 0;
 		descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -129,47 +177,5 @@ namespace Vulkan
 
 		vkUpdateDescriptorSets(device.Get(), static_cast<uint32_t>(descriptorWrites.size()),
 		                       descriptorWrites.data(), 0, nullptr);
-
-
-		VkDescriptorSetLayout descriptorSetLayouts[] = { descriptorsManager->GetDescriptorSetLayout().Get() };
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
-
-		VK_CHECK(vkCreatePipelineLayout(device.Get(), &pipelineLayoutInfo, nullptr, &pipelineLayout),
-		         "Create compute pipeline layout");
-
-		VkComputePipelineCreateInfo pipelineInfo = {};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		pipelineInfo.flags = 0;
-		pipelineInfo.pNext = nullptr;
-		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.basePipelineHandle = nullptr;
-		pipelineInfo.basePipelineIndex = -1;
-
-		for (auto& shader : shaderStages)
-		{
-			VkPipeline pipeline;
-			pipelineInfo.stage = shader;
-			VK_CHECK(vkCreateComputePipelines(device.Get(), nullptr, 1, &pipelineInfo, nullptr, &pipeline),
-			         "Create compute pipeline");
-			pipelines.push_back(pipeline);
-		}
-	}
-
-	ComputePipeline::~ComputePipeline()
-	{
-		for (auto* pipeline : pipelines)
-			vkDestroyPipeline(device.Get(), pipeline, nullptr);
-
-		if (pipelineLayout != nullptr)
-		{
-			vkDestroyPipelineLayout(device.Get(), pipelineLayout, nullptr);
-			pipelineLayout = nullptr;
-		}
 	}
 }
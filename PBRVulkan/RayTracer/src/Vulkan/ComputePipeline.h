@@ -14,14 +14,18 @@ namespace Vulkan
 
 		ComputePipeline(const class SwapChain& swapChain,
 		                const class Device& device,
-		                const class ImageView& inputImage,
-		                const class ImageView& outputImage,
-		                const class ImageView& normalsImage,
-		                const class ImageView& positionsImage,
-		                const std::vector<std::unique_ptr<class Buffer>>& uniformBuffers);
+		                const class UniformRing& uniformRing,
+		                uint32_t frames);
 
 		~ComputePipeline();
 
+		// Every frame in flight post-processes its own copy of the ray traced images
+		void UpdateDescriptorSet(uint32_t frameIndex,
+		                         const class ImageView& inputImage,
+		                         const class ImageView& outputImage,
+		                         const class ImageView& normalsImage,
+		                         const class ImageView& positionsImage) const;
+
 		[[nodiscard]] const std::vector<VkPipeline>& GetComputePipelines() const
 		{
 			return pipelines;
@@ -40,6 +44,7 @@ namespace Vulkan
 	private:
 		const Device& device;
 		const SwapChain& swapChain;
+		const UniformRing& uniformRing;
 
 		std::vector<VkPipeline> pipelines{};
 		VkPipelineLayout pipelineLayout{};
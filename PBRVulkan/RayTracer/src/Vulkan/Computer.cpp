@@ -1,8 +1,6 @@
 #include "Computer.h"
 
 #include <iostream>
-#include <thread>
-#include <chrono>
 
 #include "Device.h"
 #include "SwapChain.h"
@@ -13,6 +11,8 @@
 #include "CommandBuffers.h"
 #include "Semaphore.h"
 #include "Buffer.h"
+#include "UniformRing.h"
+#include "TimestampQueries.h"
 #include "Command.cpp"
 
 #include "../Geometry/Compute.h"
@@ -23,71 +23,78 @@ namespace Vulkan
 	                   const Device& device,
 	                   const ImageView& inputImageView,
 	                   const ImageView& normalsImageView,
-	                   const ImageView& positionsImageView):
+	                   const ImageView& positionsImageView,
+	                   uint32_t frames):
 
+		frames(frames),
 		swapChain(swapChain), device(device),
 		inputImageView(inputImageView),
 		normalsImageView(normalsImageView),
 		positionsImageView(positionsImageView)
 	{
 		commandPool.reset(new CommandPool(device, device.ComputeFamilyIndex));
-		commandBuffers.reset(new CommandBuffers(*commandPool, 1));
-		semaphore.reset(new Semaphore(device));
+		graphicsCommandPool.reset(new CommandPool(device, device.GraphicsFamilyIndex));
+		commandBuffers.reset(new CommandBuffers(*commandPool, frames));
+		copyCommandBuffers.reset(new CommandBuffers(*graphicsCommandPool, frames));
+		timeline.reset(new TimelineSemaphore(device));
+		timestamps.reset(new TimestampQueries(device, frames));
 
-		CreateOutputTexture();
+		CreateImages();
 		CreateUniformBuffer();
 
-		computePipeline.reset(new ComputePipeline(
-			swapChain,
-			device,
-			inputImageView,
-			*outputImageView,
-			normalsImageView,
-			positionsImageView,
-			uniformBuffers));
+		computePipeline.reset(new ComputePipeline(swapChain, device, *uniformRing, frames));
+
+		for (uint32_t frameIndex = 0; frameIndex < frames; ++frameIndex)
+		{
+			computePipeline->UpdateDescriptorSet(
+				frameIndex,
+				*imageViews[frameIndex * 4 + 0],
+				*imageViews[frameIndex * 4 + 1],
+				*imageViews[frameIndex * 4 + 2],
+				*imageViews[frameIndex * 4 + 3]);
+
+			// The ray traced images do not change until the swap chain is recreated
+			RecordCopy(copyCommandBuffers->Begin(frameIndex), frameIndex);
+			copyCommandBuffers->End(frameIndex);
+		}
 	}
 
 	Computer::~Computer()
 	{
+		timeline->Wait(submittedValue);
+
 		computePipeline.reset();
 		commandBuffers.reset();
+		copyCommandBuffers.reset();
 		commandPool.reset();
+		graphicsCommandPool.reset();
 
 		std::cout << "[COMPUTER] Compute pipeline has been deleted." << std::endl;
 	}
 
 	void Computer::BuildCommand(int32_t shaderId)
 	{
-		if (shaderId == currentShader)
-			return;
-
 		currentShader = shaderId;
+	}
 
-		vkQueueWaitIdle(device.ComputeQueue);
+	VkCommandBuffer Computer::GetCopyCommandBuffer(uint32_t frameIndex) const
+	{
+		return (*copyCommandBuffers)[frameIndex];
+	}
 
+	/*
+	 * The command buffer of the frame in flight is recorded again, it is no longer executed
+	 * as the frame fence waits for the copy which waits for the post-processing.
+	 */
+	void Computer::Submit(uint32_t frameIndex, const TimelineSemaphore& trace, uint64_t value)
+	{
 		const auto extent = swapChain.Extent;
 
-		VkDescriptorSet descriptorSets[] = { computePipeline->GetDescriptorSets()[0] };
+		VkDescriptorSet descriptorSets[] = { computePipeline->GetDescriptorSets()[frameIndex] };
 
-		VkCommandBuffer commandBuffer = commandBuffers->Begin(0);
+		VkCommandBuffer commandBuffer = commandBuffers->Begin(frameIndex);
 		{
-			VkImageSubresourceRange subresourceRange = Image::GetSubresourceRange();
-
-			Image::MemoryBarrier(commandBuffer, outputImage->Get(), subresourceRange, 0,
-			                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-			                     VK_IMAGE_LAYOUT_GENERAL);
-
-			Image::MemoryBarrier(commandBuffer, normalsImageView.GetImage(), subresourceRange, 0,
-			                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-			                     VK_IMAGE_LAYOUT_GENERAL);
-
-			Image::MemoryBarrier(commandBuffer, positionsImageView.GetImage(), subresourceRange, 0,
-			                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-			                     VK_IMAGE_LAYOUT_GENERAL);
-
-			Image::MemoryBarrier(commandBuffer, inputImageView.GetImage(), subresourceRange, 0,
-			                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-			                     VK_IMAGE_LAYOUT_GENERAL);
+			timestamps->Begin(commandBuffer, frameIndex);
 
 			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
 			                  computePipeline->GetComputePipelines()[currentShader]);
@@ -97,28 +104,121 @@ namespace Vulkan
 			                        0, 1, descriptorSets, 0, nullptr);
 
 			vkCmdDispatch(commandBuffer, extent.width / 16, extent.height / 16, 1);
+
+			timestamps->End(commandBuffer, frameIndex);
+		}
+		commandBuffers->End(frameIndex);
+
+		VkSemaphore waitSemaphores[] = { trace.Get() };
+		VkSemaphore signalSemaphores[] = { timeline->Get() };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = 1;
+		timelineInfo.pWaitSemaphoreValues = &value;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &value;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = waitSemaphores;
+		submitInfo.pWaitDstStageMask = waitStages;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		VK_CHECK(vkQueueSubmit(device.ComputeQueue, 1, &submitInfo, nullptr), "Compute shader submit failed!");
+
+		submittedValue = value;
+	}
+
+	std::optional<float> Computer::GetTime(uint32_t frameIndex) const
+	{
+		return timestamps->GetMilliseconds(frameIndex);
+	}
+
+	void Computer::RecordCopy(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+	{
+		const auto extent = swapChain.Extent;
+		const VkImageSubresourceRange subresourceRange = Image::GetSubresourceRange();
+		const VkImageCopy copyRegion = Image::GetImageCopy(extent.width, extent.height);
+
+		const std::pair<VkImage, VkImage> copies[] = {
+			{ inputImageView.GetImage(), inputImages[frameIndex]->Get() },
+			{ normalsImageView.GetImage(), normalsImages[frameIndex]->Get() },
+			{ positionsImageView.GetImage(), positionsImages[frameIndex]->Get() }
+		};
+
+		for (const auto& [src, dst] : copies)
+		{
+			Image::MemoryBarrier(commandBuffer, src, subresourceRange,
+			                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+			                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdCopyImage(commandBuffer, src, VK_IMAGE_LAYOUT_GENERAL, dst, VK_IMAGE_LAYOUT_GENERAL, 1,
+			               &copyRegion);
+
+			// The next trace overwrites the source
+			Image::MemoryBarrier(commandBuffer, src, subresourceRange,
+			                     VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
 		}
-		commandBuffers->End(0);
 	}
 
-	void Computer::CreateOutputTexture()
+	void Computer::CreateImages()
 	{
 		const auto extent = swapChain.Extent;
 		const auto outputFormat = swapChain.Format;
+		const auto accumulationFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		// Written by one queue family and read by the other
+		std::vector<uint32_t> queueFamilies = { device.GraphicsFamilyIndex };
+
+		if (device.ComputeFamilyIndex != device.GraphicsFamilyIndex)
+			queueFamilies.push_back(device.ComputeFamilyIndex);
+
+		auto createImage = [&](VkFormat format, VkImageUsageFlags usage)
+		{
+			return new Image(device, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_TYPE_2D,
+			                 VK_IMAGE_USAGE_STORAGE_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			                 MemoryCategory::RenderTargets, queueFamilies);
+		};
 
-		outputImage.reset(
-			new Image(device, extent, outputFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_TYPE_2D,
-			          VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+		for (uint32_t frameIndex = 0; frameIndex < frames; ++frameIndex)
+		{
+			inputImages.emplace_back(createImage(outputFormat, VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+			normalsImages.emplace_back(createImage(accumulationFormat, VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+			positionsImages.emplace_back(createImage(accumulationFormat, VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+			outputImages.emplace_back(createImage(outputFormat, VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+
+			// Ordered as the bindings of the compute shaders
+			imageViews.emplace_back(new ImageView(device, inputImages.back()->Get(), outputFormat));
+			imageViews.emplace_back(new ImageView(device, outputImages.back()->Get(), outputFormat));
+			imageViews.emplace_back(new ImageView(device, normalsImages.back()->Get(), accumulationFormat));
+			imageViews.emplace_back(new ImageView(device, positionsImages.back()->Get(), accumulationFormat));
+		}
 
-		outputImageView.reset(new ImageView(device, outputImage->Get(), outputFormat));
+		Command::Submit(*graphicsCommandPool, [this](VkCommandBuffer commandBuffer)
+		{
+			const VkImageSubresourceRange subresourceRange = Image::GetSubresourceRange();
+
+			for (const auto& view : imageViews)
+			{
+				Image::MemoryBarrier(commandBuffer, view->GetImage(), subresourceRange, 0,
+				                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				                     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+			}
+		});
 	}
 
 	void Computer::CreateUniformBuffer()
 	{
-		uniformBuffers.emplace_back(
-			new Buffer(device, sizeof(Uniforms::Compute),
-			           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		// Compute uniforms do not change between frames, a single region is enough
+		uniformRing.reset(new UniformRing(device, 1, sizeof(Uniforms::Compute)));
+		uniformRing->Push(Uniforms::Compute{});
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 
@@ -8,6 +9,12 @@
 
 namespace Vulkan
 {
+	/*
+	 * Post-processing on the async compute queue.
+	 * The graphics queue copies the ray traced images of a frame into images of the frame in flight,
+	 * thus the post-processing of frame N overlaps the trace of frame N + 1.
+	 * Both queues synchronize with timeline semaphores, the value is the number of the traced frame.
+	 */
 	class Computer final
 	{
 	public:
@@ -18,31 +25,41 @@ namespace Vulkan
 			const class Device& device,
 			const class ImageView& inputImageView,
 			const class ImageView& normalsImageView,
-			const class ImageView& positionsImageView);
+			const class ImageView& positionsImageView,
+			uint32_t frames);
 		~Computer();
 
+		// Selects the post-processing shader of the next submits
 		void BuildCommand(int32_t shaderId);
 
-		[[nodiscard]] const class Image& GetOutputImage() const
-		{
-			return *outputImage;
-		}
+		// Copies the ray traced images on the graphics queue, submitted after the trace
+		[[nodiscard]] VkCommandBuffer GetCopyCommandBuffer(uint32_t frameIndex) const;
+
+		// Post-processes the frame once the graphics queue has signalled the trace value
+		void Submit(uint32_t frameIndex, const class TimelineSemaphore& trace, uint64_t value);
+
+		// GPU time of the last post-processing of the frame in flight
+		[[nodiscard]] std::optional<float> GetTime(uint32_t frameIndex) const;
 
-		[[nodiscard]] const class CommandBuffers& GetCommandBuffers() const
+		[[nodiscard]] const class Image& GetOutputImage(uint32_t frameIndex) const
 		{
-			return *commandBuffers;
+			return *outputImages[frameIndex];
 		}
 
-		[[nodiscard]] const class Semaphore& GetSemaphore() const
+		// Signalled with the trace value once the post-processing of the frame has finished
+		[[nodiscard]] const class TimelineSemaphore& GetTimeline() const
 		{
-			return *semaphore;
+			return *timeline;
 		}
 
 	private:
-		void CreateOutputTexture();
+		void CreateImages();
 		void CreateUniformBuffer();
+		void RecordCopy(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
 
 		int32_t currentShader = -1;
+		const uint32_t frames;
+		uint64_t submittedValue = 0;
 
 		const SwapChain& swapChain;
 		const Device& device;
@@ -51,13 +68,20 @@ namespace Vulkan
 		const ImageView& normalsImageView;
 		const ImageView& positionsImageView;
 
-		std::unique_ptr<class Image> outputImage;
-		std::unique_ptr<class ImageView> outputImageView;
-		std::vector<std::unique_ptr<class Buffer>> uniformBuffers;
+		// Per frame in flight copies of the ray traced images and the post-processed output
+		std::vector<std::unique_ptr<class Image>> inputImages;
+		std::vector<std::unique_ptr<class Image>> normalsImages;
+		std::vector<std::unique_ptr<class Image>> positionsImages;
+		std::vector<std::unique_ptr<class Image>> outputImages;
+		std::vector<std::unique_ptr<class ImageView>> imageViews;
+		std::unique_ptr<class UniformRing> uniformRing;
 
 		std::unique_ptr<class CommandPool> commandPool;
+		std::unique_ptr<class CommandPool> graphicsCommandPool;
 		std::unique_ptr<class CommandBuffers> commandBuffers;
+		std::unique_ptr<class CommandBuffers> copyCommandBuffers;
 		std::unique_ptr<class ComputePipeline> computePipeline;
-		std::unique_ptr<class Semaphore> semaphore;
+		std::unique_ptr<class TimelineSemaphore> timeline;
+		std::unique_ptr<class TimestampQueries> timestamps;
 	};
 }
@@ -16,14 +16,18 @@
 #include "Framebuffer.h"
 #include "Buffer.h"
 #include "CommandPool.h"
+#include "FrameContext.h"
 #include "DepthBuffer.h"
+#include "UniformRing.h"
+#include "Uploader.h"
+#include "Computer.h"
 
 #include "../Geometry/Global.h"
 #include "../Tracer/Scene.h"
 
 namespace Vulkan
 {
-	Core::Core()
+	Core::Core(bool headless): headless(headless)
 	{
 		CreateInstance();
 		CreatePhysicalDevice();
@@ -31,6 +35,7 @@ namespace Vulkan
 
 	Core::~Core()
 	{
+		traceTimeline.reset();
 		commandPool.reset();
 		device.reset();
 		surface.reset();
@@ -40,37 +45,93 @@ namespace Vulkan
 
 	void Core::DrawFrame()
 	{
-		auto& inFlightFence = inFlightFences[currentFrame];
+		const auto& frame = *frames[currentFrame];
 
-		inFlightFence->Wait(UINT64_MAX);
+		frame.Wait();
 
-		uint32_t imageIndex;
-		auto result = vkAcquireNextImageKHR(
-			device->Get(),
-			swapChain->Get(),
-			UINT64_MAX,
-			imageAvailableSemaphores[currentFrame]->Get(),
-			nullptr,
-			&imageIndex);
+		// Recycle staging memory of streamed assets which have already landed
+		device->GetUploader().Collect();
 
-		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		// Offscreen images are used in turns
+		uint32_t imageIndex = currentFrame % static_cast<uint32_t>(swapChain->GetImage().size());
+
+		if (!headless)
+		{
+			auto result = vkAcquireNextImageKHR(
+				device->Get(),
+				swapChain->Get(),
+				UINT64_MAX,
+				frame.GetImageAvailable().Get(),
+				nullptr,
+				&imageIndex);
+
+			if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			{
+				throw std::runtime_error(std::string("Failed to acquire next image"));
+			}
+		}
+
+		// There can be more images than frames in flight, the image might still be rendered by another frame
+		if (imagesInFlight[imageIndex] != nullptr && imagesInFlight[imageIndex] != &frame.GetFence())
+			imagesInFlight[imageIndex]->Wait(UINT64_MAX);
+
+		imagesInFlight[imageIndex] = &frame.GetFence();
+
+		RecordCommands();
+
+		// Headless renders have no framebuffers, neither the rasterizer nor the menu records a render pass
+		const VkFramebuffer framebuffer = headless ? nullptr : swapChainFrameBuffers[imageIndex]->Get();
+
+		const VkCommandBuffer commandBuffer = frame.Begin();
+		{
+			Render(framebuffer, commandBuffer, currentFrame, imageIndex);
+		}
+		frame.End();
+
+		frame.GetFence().Reset();
+
+		UpdateUniformBuffer(currentFrame);
+		VkCommandBuffer traceCommandBuffer = (*traceCommandBuffers)[currentFrame * TRACE_LEVELS + traceLevel];
+
+		if (traceTile && !traceStopped)
+		{
+			traceCommandBuffer = frame.BeginTrace();
+			RecordTile(traceCommandBuffer, currentFrame, *traceTile);
+			frame.EndTrace();
+		}
+
+		std::vector<VkCommandBuffer> commandBuffers;
+
+		if (!traceStopped)
 		{
-			throw std::runtime_error(std::string("Failed to acquire next image"));
+			if (compactPixels)
+				commandBuffers.push_back((*compactionCommandBuffers)[currentFrame]);
+
+			commandBuffers.push_back(traceCommandBuffer);
 		}
 
-		const VkCommandBuffer commandBuffer = commandBuffers->Begin(imageIndex);
+		if (postProcess)
 		{
-			Render(swapChainFrameBuffers[imageIndex]->Get(), commandBuffer, imageIndex);
+			// The post-processing of this frame overlaps the trace of the next one
+			commandBuffers.push_back(postProcess->GetCopyCommandBuffer(currentFrame));
+			SubmitTrace(commandBuffers, ++traceValue);
+			postProcess->Submit(currentFrame, *traceTimeline, traceValue);
+
+			commandBuffers.clear();
 		}
-		commandBuffers->End(imageIndex);
 
-		inFlightFence->Reset();
+		commandBuffers.push_back((*copyCommandBuffers)[imageIndex]);
+		commandBuffers.push_back(commandBuffer);
 
-		UpdateUniformBuffer(imageIndex);
-		QueueSubmit(commandBuffer);
-		Present(imageIndex);
+		if (postProcess)
+			QueueSubmit(frame, commandBuffers, &postProcess->GetTimeline(), traceValue);
+		else
+			QueueSubmit(frame, commandBuffers);
 
-		currentFrame = (currentFrame + 1) % inFlightFences.size();
+		if (!headless)
+			Present(frame, imageIndex);
+
+		currentFrame = (currentFrame + 1) % static_cast<uint32_t>(frames.size());
 	}
 
 	void Core::Run()
@@ -82,9 +143,59 @@ namespace Vulkan
 		}
 	}
 
-	void Core::Present(uint32_t imageIndex)
+	void Core::CreateFrames()
+	{
+		frames.clear();
+
+		for (uint32_t i = 0; i < FrameContext::MAX_FRAMES_IN_FLIGHT; ++i)
+			frames.emplace_back(new FrameContext(*commandPool, i));
+
+		imagesInFlight.assign(swapChain->GetImage().size(), nullptr);
+		currentFrame = 0;
+	}
+
+	void Core::RecordCommands()
+	{
+		if (commandsRecorded)
+			return;
+
+		// The static command buffers might still be executed by the frames in flight
+		device->WaitIdle();
+
+		for (uint32_t i = 0; i < traceCommandBuffers->Size(); ++i)
+		{
+			const VkCommandBuffer commandBuffer = traceCommandBuffers->Begin(i);
+			RecordTrace(commandBuffer, i / TRACE_LEVELS, 1u << i % TRACE_LEVELS);
+			traceCommandBuffers->End(i);
+		}
+
+		for (uint32_t i = 0; i < compactionCommandBuffers->Size(); ++i)
+		{
+			const VkCommandBuffer commandBuffer = compactionCommandBuffers->Begin(i);
+			RecordCompaction(commandBuffer, i);
+			compactionCommandBuffers->End(i);
+		}
+
+		for (uint32_t i = 0; i < copyCommandBuffers->Size(); ++i)
+		{
+			const VkCommandBuffer commandBuffer = copyCommandBuffers->Begin(i);
+			RecordCopy(commandBuffer, i);
+			copyCommandBuffers->End(i);
+		}
+
+		commandsRecorded = true;
+
+		std::cout << "[CORE] Static command buffers have been recorded." << std::endl;
+	}
+
+	void Core::InvalidateCommands()
+	{
+		commandsRecorded = false;
+	}
+
+	void Core::Present(const FrameContext& frame, uint32_t imageIndex) const
 	{
-		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame]->Get() };
+		VkSemaphore signalSemaphores[] = { frame.GetRenderFinished().Get() };
 		VkSwapchainKHR swapChains[] = { swapChain->Get() };
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -102,26 +213,68 @@ namespace Vulkan
 		}
 	}
 
-	void Core::QueueSubmit(VkCommandBuffer commandBuffer)
+	void Core::QueueSubmit(const FrameContext& frame, const std::vector<VkCommandBuffer>& commandBuffers,
+	                       const TimelineSemaphore* wait, uint64_t waitValue) const
 	{
-		auto& fence = inFlightFences[currentFrame];
-
-		VkCommandBuffer commandBuffers[]{ commandBuffer };
 		VkSubmitInfo submitInfo{};
-		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame]->Get() };
-		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame]->Get() };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR };
+		VkSemaphore signalSemaphores[] = { frame.GetRenderFinished().Get() };
+		VkSemaphore waitSemaphores[2]{};
+		VkPipelineStageFlags waitStages[2]{};
+		// Values of binary semaphores are ignored
+		uint64_t waitValues[2]{};
+		uint32_t waitCount = 0;
+
+		// Offscreen images are neither acquired nor presented
+		if (!headless)
+		{
+			// The trace does not touch the swap chain image, only the copy and the user interface wait for it
+			waitSemaphores[waitCount] = frame.GetImageAvailable().Get();
+			waitStages[waitCount++] = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		}
+
+		if (wait)
+		{
+			waitSemaphores[waitCount] = wait->Get();
+			waitValues[waitCount] = waitValue;
+			waitStages[waitCount++] = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = waitCount;
+		timelineInfo.pWaitSemaphoreValues = waitValues;
 
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pNext = wait ? &timelineInfo : nullptr;
+		submitInfo.waitSemaphoreCount = waitCount;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = commandBuffers;
+		submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+		submitInfo.pCommandBuffers = commandBuffers.data();
+		submitInfo.signalSemaphoreCount = headless ? 0 : 1;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		VK_CHECK(vkQueueSubmit(device->GraphicsQueue, 1, &submitInfo, frame.GetFence().Get()), "Failed to submit!");
+	}
+
+	void Core::SubmitTrace(const std::vector<VkCommandBuffer>& commandBuffers, uint64_t value) const
+	{
+		VkSemaphore signalSemaphores[] = { traceTimeline->Get() };
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &value;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+		submitInfo.pCommandBuffers = commandBuffers.data();
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
-		VK_CHECK(vkQueueSubmit(device->GraphicsQueue, 1, &submitInfo, fence->Get()), "Failed to submit!");
+		VK_CHECK(vkQueueSubmit(device->GraphicsQueue, 1, &submitInfo, nullptr), "Failed to submit trace!");
 	}
 
 	void Core::CreateInstance()
@@ -132,11 +285,17 @@ namespace Vulkan
 		std::vector<const char*> layers = { "VK_LAYER_KHRONOS_validation" };
 #endif
 
+		if (headless)
+		{
+			instance.reset(new Instance(nullptr, layers));
+			return;
+		}
+
 		// Frame pre second monitor
 		layers.push_back("VK_LAYER_LUNARG_monitor");
 
 		window.reset(new Window());
-		instance.reset(new Instance(*window, layers));
+		instance.reset(new Instance(window.get(), layers));
 		surface.reset(new Surface(*instance));
 	}
 
@@ -144,7 +303,8 @@ namespace Vulkan
 	{
 		auto* physicalDevice = instance->GetDevices().front();
 
-		device.reset(new Device(physicalDevice, *surface));
+		device.reset(new Device(physicalDevice, surface.get()));
 		commandPool.reset(new CommandPool(*device, device->GraphicsFamilyIndex));
+		traceTimeline.reset(new TimelineSemaphore(*device));
 	}
 }
@@ -3,6 +3,7 @@
 #include "Vulkan_api.h"
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "../Tracer/Settings.h"
@@ -14,12 +15,18 @@ namespace Tracer
 
 namespace Vulkan
 {
+	class FrameContext;
+
 	class Core
 	{
 	public:
 		NON_COPIABLE(Core)
 
-		explicit Core();
+		// Trace command buffers are recorded with 1, 2, 4, ... 2^(TRACE_LEVELS - 1) accumulation passes
+		static constexpr uint32_t TRACE_LEVELS = 5;
+
+		// Headless cores have no window, surface or swap chain and render into offscreen images
+		explicit Core(bool headless = false);
 		virtual ~Core();
 
 		virtual void Run() = 0;
@@ -32,11 +39,32 @@ namespace Vulkan
 		void DrawFrame();
 		void CreatePhysicalDevice();
 		void CreateInstance();
-		void QueueSubmit(VkCommandBuffer commandBuffer);
-		void Present(uint32_t imageIndex);
+		void CreateFrames();
+		void RecordCommands();
+		void InvalidateCommands();
+		void QueueSubmit(const FrameContext& frame, const std::vector<VkCommandBuffer>& commandBuffers,
+		                 const class TimelineSemaphore* wait = nullptr, uint64_t waitValue = 0) const;
+		void SubmitTrace(const std::vector<VkCommandBuffer>& commandBuffers, uint64_t value) const;
+		void Present(const FrameContext& frame, uint32_t imageIndex) const;
+
+		virtual void UpdateUniformBuffer(uint32_t frameIndex) = 0;
+
+		/*
+		 * Static commands are recorded once and resubmitted every frame until InvalidateCommands() is called.
+		 * Trace commands are recorded per frame in flight and trace level, copy commands per swap chain image.
+		 */
+		virtual void RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes) = 0;
+		virtual void RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex) = 0;
 
-		virtual void UpdateUniformBuffer(uint32_t imageIndex) = 0;
-		virtual void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex) = 0;
+		// Rebuilds the list of pixels traced by the adaptive sampling, submitted before the trace
+		virtual void RecordCompaction(VkCommandBuffer commandBuffer, uint32_t frameIndex) = 0;
+
+		// Replaces the static trace commands while traceTile is set
+		virtual void RecordTile(VkCommandBuffer commandBuffer, uint32_t frameIndex, const VkRect2D& tile) = 0;
+
+		// Dynamic commands recorded every frame after the static ones, e.g. the user interface
+		virtual void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t frameIndex,
+		                    uint32_t imageIndex) = 0;
 		virtual void LoadScene() = 0;
 		
 		// User interface API
@@ -45,8 +73,22 @@ namespace Vulkan
 		virtual void OnMouseButtonChanged(int button, int action, int mods) = 0;
 		virtual void OnScrollChanged(double xoffset, double yoffset) = 0;
 
+		const bool headless;
+		// Resolution of the offscreen images of the headless core
+		VkExtent2D offscreenExtent{};
 		Settings settings;
-		size_t currentFrame{};
+		uint32_t currentFrame{};
+		// Selects the trace command buffer with 2^traceLevel passes for the next submit
+		uint32_t traceLevel{};
+		// Region of the frame traced by the next submit, the whole frame if empty
+		std::optional<VkRect2D> traceTile;
+		// Submits the compaction commands before the next trace
+		bool compactPixels{};
+		// Converged render, only the output is copied and the user interface redrawn
+		bool traceStopped{};
+		// Post-processing on the compute queue between the trace and the copy, none if empty
+		class Computer* postProcess{};
+		bool commandsRecorded = false;
 
 		std::unique_ptr<class Tracer::Scene> scene;
 		std::unique_ptr<class Window> window;
@@ -54,15 +96,22 @@ namespace Vulkan
 		std::unique_ptr<class Device> device;
 		std::unique_ptr<class Surface> surface;
 		std::unique_ptr<class SwapChain> swapChain;
-		std::unique_ptr<class CommandBuffers> commandBuffers;
+		std::unique_ptr<class CommandBuffers> traceCommandBuffers;
+		std::unique_ptr<class CommandBuffers> copyCommandBuffers;
+		std::unique_ptr<class CommandBuffers> compactionCommandBuffers;
 		std::unique_ptr<class CommandPool> commandPool;
 		std::unique_ptr<class DepthBuffer> depthBuffer;
+		std::unique_ptr<class UniformRing> uniformRing;
+		// Signalled with the number of the frame once its trace has finished
+		std::unique_ptr<class TimelineSemaphore> traceTimeline;
+		uint64_t traceValue{};
+
+		// Per frame in flight components
+		std::vector<std::unique_ptr<class FrameContext>> frames;
 
 		// Per image in swap chain specific components	
 		std::vector<std::unique_ptr<class Framebuffer>> swapChainFrameBuffers;
-		std::vector<std::unique_ptr<class Buffer>> uniformBuffers;
-		std::vector<std::unique_ptr<class Semaphore>> imageAvailableSemaphores;
-		std::vector<std::unique_ptr<class Semaphore>> renderFinishedSemaphores;
-		std::vector<std::unique_ptr<class Fence>> inFlightFences;
+		// Fence of the frame which has rendered to the image the last time
+		std::vector<const class Fence*> imagesInFlight;
 	};
 }
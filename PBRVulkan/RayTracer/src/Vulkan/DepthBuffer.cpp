@@ -13,7 +13,8 @@ namespace Vulkan
 			VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_TYPE_2D,
 			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			MemoryCategory::RenderTargets));
 
 		imageView.reset(new ImageView(commandPool.GetDevice(), image->Get(), image->GetFormat(),
 		                              VK_IMAGE_ASPECT_DEPTH_BIT));
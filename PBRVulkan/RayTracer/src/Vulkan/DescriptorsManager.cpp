@@ -5,16 +5,15 @@
 #include "../Tracer/Scene.h"
 
 #include "Device.h"
-#include "SwapChain.h"
 #include "DescriptorSetLayout.h"
 
 namespace Vulkan
 {
 	DescriptorsManager::DescriptorsManager(
 		const Device& device,
-		const SwapChain& swapChain,
+		uint32_t maxSets,
 		const std::vector<DescriptorBinding>& descriptorBindings):
-		device(device), swapChain(swapChain)
+		device(device), maxSets(maxSets)
 	{
 		descriptorSetLayout.reset(new DescriptorSetLayout(device, descriptorBindings));
 
@@ -38,13 +37,13 @@ namespace Vulkan
 
 		poolSizes.reserve(descriptorBindings.size());
 		for (const auto& binding : descriptorBindings)
-			poolSizes.push_back(VkDescriptorPoolSize{ binding.Type, binding.DescriptorCount });
+			poolSizes.push_back(VkDescriptorPoolSize{ binding.Type, binding.DescriptorCount * maxSets });
 
 		VkDescriptorPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(swapChain.GetImage().size());
+		poolInfo.maxSets = maxSets;
 
 		VK_CHECK(vkCreateDescriptorPool(device.Get(), &poolInfo, nullptr, &descriptorPool),
 		         "Create descriptor pool");
@@ -32,7 +32,7 @@ namespace Vulkan
 		NON_COPIABLE(DescriptorsManager)
 
 		DescriptorsManager(const class Device& device,
-		                   const class SwapChain& swapChain,
+		                   uint32_t maxSets,
 		                   const std::vector<DescriptorBinding>& descriptorBindings);
 		~DescriptorsManager();
 
@@ -48,7 +48,7 @@ namespace Vulkan
 
 	private:
 		const Device& device;
-		const SwapChain& swapChain;
+		const uint32_t maxSets;
 		VkDescriptorPool descriptorPool{};
 		std::unique_ptr<class DescriptorSetLayout> descriptorSetLayout;
 
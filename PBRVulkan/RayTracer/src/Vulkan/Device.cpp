@@ -3,12 +3,14 @@
 #include <set>
 
 #include "Surface.h"
+#include "Allocator.h"
+#include "Uploader.h"
+#include "PipelineCache.h"
 
 namespace Vulkan
 {
 	const std::vector<const char*> Device::RequiredExtensions =
 	{
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		VK_KHR_SHADER_CLOCK_EXTENSION_NAME,
 		VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
 		VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
@@ -17,10 +19,15 @@ namespace Vulkan
 		VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME
 	};
 
-	Device::Device(VkPhysicalDevice physicalDevice, const Surface& surface) :
+	Device::Device(VkPhysicalDevice physicalDevice, const Surface* surface) :
 		surface(surface), physicalDevice(physicalDevice)
 	{
-		if (!CheckDeviceExtensionSupport(physicalDevice))
+		auto extensions = RequiredExtensions;
+
+		if (surface)
+			extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+		if (!CheckDeviceExtensionSupport(physicalDevice, extensions))
 		{
 			throw std::runtime_error("The device is not suitable!");
 		}
@@ -54,9 +61,14 @@ namespace Vulkan
 		shaderClockFeatures.pNext = nullptr;
 		shaderClockFeatures.shaderSubgroupClock = true;
 
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+		timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineSemaphoreFeatures.pNext = &shaderClockFeatures;
+		timelineSemaphoreFeatures.timelineSemaphore = true;
+
 		VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures = {};
 		bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
-		bufferDeviceAddressFeatures.pNext = &shaderClockFeatures;
+		bufferDeviceAddressFeatures.pNext = &timelineSemaphoreFeatures;
 		bufferDeviceAddressFeatures.bufferDeviceAddress = true;
 
 		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
@@ -74,6 +86,7 @@ namespace Vulkan
 		rayTracingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR;
 		rayTracingFeatures.pNext = &accelerationStructureFeatures;
 		rayTracingFeatures.rayTracingPipeline = true;
+		rayTracingFeatures.rayTracingPipelineTraceRaysIndirect = true;
 
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -82,8 +95,8 @@ namespace Vulkan
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 		createInfo.pEnabledFeatures = &deviceFeatures;
 		createInfo.enabledLayerCount = 0;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(RequiredExtensions.size());
-		createInfo.ppEnabledExtensionNames = RequiredExtensions.data();
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
 
 		VK_CHECK(vkCreateDevice(physicalDevice, &createInfo, nullptr, &device), "Create Vulkan logical device");
 
@@ -91,7 +104,10 @@ namespace Vulkan
 		{
 			uint32_t family = index.family.value();
 			VkBool32 presentSupport = VK_FALSE;
-			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, family, surface.Get(), &presentSupport);
+
+			if (surface)
+				vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, family, surface->Get(), &presentSupport);
+
 			if (presentSupport)
 			{
 				vkGetDeviceQueue(device, family, 0, &PresentQueue);
@@ -105,6 +121,17 @@ namespace Vulkan
 			uint32_t family = index.family.value();
 			vkGetDeviceQueue(device, family, 0, &index.queue);
 		}
+
+		// Offscreen targets are only used by the graphics queue
+		if (!surface)
+		{
+			PresentFamilyIndex = GraphicsFamilyIndex;
+			PresentQueue = GraphicsQueue;
+		}
+
+		allocator.reset(new Allocator(*this));
+		uploader.reset(new Uploader(*this));
+		pipelineCache.reset(new PipelineCache(*this, "pipeline.cache"));
 	}
 
 	std::vector<QueueFamily> Device::FindQueueFamilies(VkPhysicalDevice device)
@@ -148,7 +175,8 @@ namespace Vulkan
 		return indices;
 	}
 
-	bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
+	bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice,
+	                                         const std::vector<const char*>& extensions)
 	{
 		uint32_t extensionCount;
 		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
@@ -156,7 +184,7 @@ namespace Vulkan
 		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
 		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
 
-		std::set<std::string> requiredExtensions(RequiredExtensions.begin(), RequiredExtensions.end());
+		std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
 		for (const auto& extension : availableExtensions)
 		{
@@ -168,6 +196,10 @@ namespace Vulkan
 
 	Device::~Device()
 	{
+		pipelineCache.reset();
+		uploader.reset();
+		allocator.reset();
+
 		if (device != nullptr)
 		{
 			vkDestroyDevice(device, nullptr);
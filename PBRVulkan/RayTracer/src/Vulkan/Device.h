@@ -2,6 +2,7 @@
 
 #include "Vulkan_api.h"
 
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -28,7 +29,8 @@ namespace Vulkan
 	public:
 		NON_COPIABLE(Device);
 
-		Device(VkPhysicalDevice physicalDevice, const Surface& surface);
+		// Without a surface the device renders offscreen and has no present queue
+		Device(VkPhysicalDevice physicalDevice, const Surface* surface);
 		~Device();
 
 		// Wait on the host for the completion of outstanding queue operations for all queues on a given logical device
@@ -46,17 +48,36 @@ namespace Vulkan
 
 		[[nodiscard]] const class Surface& GetSurface() const
 		{
-			return surface;
+			return *surface;
+		}
+
+		[[nodiscard]] class Allocator& GetAllocator() const
+		{
+			return *allocator;
+		}
+
+		[[nodiscard]] class Uploader& GetUploader() const
+		{
+			return *uploader;
+		}
+
+		[[nodiscard]] class PipelineCache& GetPipelineCache() const
+		{
+			return *pipelineCache;
 		}
 
 	private:
 		std::vector<QueueFamily> FindQueueFamilies(VkPhysicalDevice device);
-		static bool CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
+		static bool CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice,
+		                                        const std::vector<const char*>& extensions);
 
 		static const std::vector<const char*> RequiredExtensions;
-		const Surface& surface;
+		const Surface* surface;
 		VkPhysicalDevice physicalDevice;
 		VkDevice device{};
+		std::unique_ptr<class Allocator> allocator;
+		std::unique_ptr<class Uploader> uploader;
+		std::unique_ptr<class PipelineCache> pipelineCache;
 
 	public:
 		uint32_t GraphicsFamilyIndex{};
@@ -23,5 +23,6 @@ namespace Vulkan
 		GetDeviceProcAddr(vkCmdCopyAccelerationStructureKHR);
 		GetDeviceProcAddr(vkCmdWriteAccelerationStructuresPropertiesKHR);
 		GetDeviceProcAddr(vkCmdTraceRaysKHR);
+		GetDeviceProcAddr(vkCmdTraceRaysIndirectKHR);
 	}
 }
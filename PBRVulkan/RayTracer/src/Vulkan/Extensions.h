@@ -23,6 +23,7 @@ namespace Vulkan
 		PFN_vkCmdCopyAccelerationStructureKHR vkCmdCopyAccelerationStructureKHR;
 		PFN_vkCmdWriteAccelerationStructuresPropertiesKHR vkCmdWriteAccelerationStructuresPropertiesKHR;
 		PFN_vkCmdTraceRaysKHR vkCmdTraceRaysKHR;
+		PFN_vkCmdTraceRaysIndirectKHR vkCmdTraceRaysIndirectKHR;
 
 	private:
 		const Device& device;
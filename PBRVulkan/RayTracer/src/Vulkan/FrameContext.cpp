@@ -0,0 +1,64 @@
+#include "FrameContext.h"
+
+#include "CommandBuffers.h"
+#include "CommandPool.h"
+#include "Device.h"
+#include "Fence.h"
+#include "Semaphore.h"
+
+namespace Vulkan
+{
+	namespace
+	{
+		constexpr uint32_t RENDER = 0;
+		constexpr uint32_t TRACE = 1;
+	}
+
+	FrameContext::FrameContext(const CommandPool& commandPool, uint32_t index): index(index)
+	{
+		const auto& device = commandPool.GetDevice();
+
+		commandBuffers.reset(new CommandBuffers(commandPool, 2));
+		fence.reset(new Fence(device));
+		imageAvailable.reset(new Semaphore(device));
+		renderFinished.reset(new Semaphore(device));
+	}
+
+	FrameContext::~FrameContext()
+	{
+		commandBuffers.reset();
+		renderFinished.reset();
+		imageAvailable.reset();
+		fence.reset();
+	}
+
+	void FrameContext::Wait() const
+	{
+		fence->Wait(UINT64_MAX);
+	}
+
+	VkCommandBuffer FrameContext::Begin() const
+	{
+		return commandBuffers->Begin(RENDER);
+	}
+
+	void FrameContext::End() const
+	{
+		commandBuffers->End(RENDER);
+	}
+
+	VkCommandBuffer FrameContext::BeginTrace() const
+	{
+		return commandBuffers->Begin(TRACE);
+	}
+
+	void FrameContext::EndTrace() const
+	{
+		commandBuffers->End(TRACE);
+	}
+
+	VkCommandBuffer FrameContext::GetCommandBuffer() const
+	{
+		return (*commandBuffers)[RENDER];
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <memory>
+
+namespace Vulkan
+{
+	/*
+	 * Resources of a single frame in flight.
+	 * Once the fence is waited on, the command buffer and the uniform ring region with the same index
+	 * are no longer used by the GPU and can be rewritten.
+	 */
+	class FrameContext final
+	{
+	public:
+		NON_COPIABLE(FrameContext)
+
+		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
+		FrameContext(const class CommandPool& commandPool, uint32_t index);
+		~FrameContext();
+
+		// Blocks until the GPU has finished the previous use of this frame
+		void Wait() const;
+
+		[[nodiscard]] VkCommandBuffer Begin() const;
+		void End() const;
+
+		// Trace commands recorded every frame, e.g. a single tile, which are submitted before the copy
+		[[nodiscard]] VkCommandBuffer BeginTrace() const;
+		void EndTrace() const;
+
+		[[nodiscard]] uint32_t GetIndex() const
+		{
+			return index;
+		}
+
+		[[nodiscard]] VkCommandBuffer GetCommandBuffer() const;
+
+		[[nodiscard]] const class Fence& GetFence() const
+		{
+			return *fence;
+		}
+
+		[[nodiscard]] const class Semaphore& GetImageAvailable() const
+		{
+			return *imageAvailable;
+		}
+
+		[[nodiscard]] const class Semaphore& GetRenderFinished() const
+		{
+			return *renderFinished;
+		}
+
+	private:
+		const uint32_t index;
+		std::unique_ptr<class CommandBuffers> commandBuffers;
+		std::unique_ptr<class Fence> fence;
+		std::unique_ptr<class Semaphore> imageAvailable;
+		std::unique_ptr<class Semaphore> renderFinished;
+	};
+}
@@ -0,0 +1,172 @@
+#include "FreeList.h"
+
+#include <stdexcept>
+
+namespace Vulkan
+{
+	FreeList::FreeList(uint64_t size) : size(size)
+	{
+		if (size > 0)
+			Insert(0, size);
+	}
+
+	uint64_t FreeList::Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0)
+			return INVALID;
+
+		alignment = alignment == 0 ? 1 : alignment;
+
+		const uint64_t largest = GetLargestRange();
+
+		// Full blocks are rejected without searching
+		if (size > largest)
+			return INVALID;
+
+		// Any range of the padded size fits regardless of its offset, the smallest one is taken
+		const uint64_t padded = size + alignment - 1;
+
+		if (padded <= largest)
+		{
+			for (int sizeClass = SizeClass(padded); sizeClass < CLASSES; ++sizeClass)
+			{
+				if ((classMask & (1ull << sizeClass)) == 0)
+					continue;
+
+				const auto it = classes[sizeClass].lower_bound({ padded, 0 });
+
+				if (it != classes[sizeClass].end())
+					return Take(ranges.find(it->second), size, alignment);
+			}
+		}
+
+		// Smaller ranges fit only when their offset happens to be aligned well enough, the search is bounded
+		int candidatesLeft = MAX_CANDIDATES;
+
+		for (int sizeClass = SizeClass(size); sizeClass <= SizeClass(padded); ++sizeClass)
+		{
+			if ((classMask & (1ull << sizeClass)) == 0)
+				continue;
+
+			const auto& candidates = classes[sizeClass];
+
+			for (auto it = candidates.lower_bound({ size, 0 });
+			     it != candidates.end() && it->first < padded && candidatesLeft-- > 0; ++it)
+			{
+				const auto [rangeSize, rangeOffset] = *it;
+				const uint64_t offset = (rangeOffset + alignment - 1) / alignment * alignment;
+
+				if (offset + size <= rangeOffset + rangeSize)
+					return Take(ranges.find(rangeOffset), size, alignment);
+			}
+		}
+
+		return INVALID;
+	}
+
+	uint64_t FreeList::Take(Range range, uint64_t size, uint64_t alignment)
+	{
+		const auto [rangeOffset, rangeSize] = *range;
+		const uint64_t offset = (rangeOffset + alignment - 1) / alignment * alignment;
+
+		Erase(range);
+
+		// Alignment padding and the remainder stay free
+		if (offset > rangeOffset)
+			Insert(rangeOffset, offset - rangeOffset);
+
+		if (offset + size < rangeOffset + rangeSize)
+			Insert(offset + size, rangeOffset + rangeSize - offset - size);
+
+		used += size;
+
+		return offset;
+	}
+
+	void FreeList::Free(uint64_t offset, uint64_t size)
+	{
+		if (size == 0 || offset + size > this->size)
+			throw std::runtime_error("Invalid free list range!");
+
+		used -= size;
+
+		auto next = ranges.lower_bound(offset);
+
+		// Merge with the following range
+		if (next != ranges.end() && offset + size == next->first)
+		{
+			size += next->second;
+			Erase(next);
+		}
+
+		// Merge with the preceding range
+		auto previous = ranges.lower_bound(offset);
+
+		if (previous != ranges.begin())
+		{
+			--previous;
+
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				size += previous->second;
+				Erase(previous);
+			}
+		}
+
+		Insert(offset, size);
+	}
+
+	uint64_t FreeList::GetLargestRange() const
+	{
+		if (classMask == 0)
+			return 0;
+
+		return classes[CLASSES - 1 - Leading(classMask)].rbegin()->first;
+	}
+
+	int FreeList::Leading(uint64_t value)
+	{
+		if (value == 0)
+			return CLASSES;
+
+		int zeros = 0;
+
+		// Binary search of the highest set bit
+		for (int shift = CLASSES / 2; shift > 0; shift /= 2)
+		{
+			if ((value >> (CLASSES - shift)) == 0)
+			{
+				zeros += shift;
+				value <<= shift;
+			}
+		}
+
+		return zeros;
+	}
+
+	int FreeList::SizeClass(uint64_t size)
+	{
+		return CLASSES - 1 - Leading(size);
+	}
+
+	void FreeList::Insert(uint64_t offset, uint64_t size)
+	{
+		const int sizeClass = SizeClass(size);
+
+		ranges.emplace(offset, size);
+		classes[sizeClass].emplace(size, offset);
+		classMask |= 1ull << sizeClass;
+	}
+
+	void FreeList::Erase(Range range)
+	{
+		const int sizeClass = SizeClass(range->second);
+
+		classes[sizeClass].erase({ range->second, range->first });
+		ranges.erase(range);
+
+		if (classes[sizeClass].empty())
+			classMask &= ~(1ull << sizeClass);
+	}
+}
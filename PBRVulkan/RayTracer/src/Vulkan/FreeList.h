@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace Vulkan
+{
+	/*
+	 * Offset allocator of a single memory block.
+	 * Free ranges are coalesced on release and indexed by power of two size classes,
+	 * thus a fitting range is found without walking the whole block.
+	 */
+	class FreeList final
+	{
+	public:
+		static constexpr uint64_t INVALID = ~0ull;
+
+		explicit FreeList(uint64_t size);
+
+		// Returns INVALID when there is no free range large enough
+		[[nodiscard]] uint64_t Allocate(uint64_t size, uint64_t alignment);
+		void Free(uint64_t offset, uint64_t size);
+
+		[[nodiscard]] uint64_t GetSize() const
+		{
+			return size;
+		}
+
+		[[nodiscard]] uint64_t GetUsed() const
+		{
+			return used;
+		}
+
+		[[nodiscard]] bool IsEmpty() const
+		{
+			return used == 0;
+		}
+
+		[[nodiscard]] uint64_t GetLargestRange() const;
+
+	private:
+		static constexpr int CLASSES = 64;
+		static constexpr int MAX_CANDIDATES = 8;
+
+		using Range = std::map<uint64_t, uint64_t>::iterator;
+
+		uint64_t size;
+		uint64_t used{};
+		// Bit per non-empty size class
+		uint64_t classMask{};
+
+		// Offset to size of every free range
+		std::map<uint64_t, uint64_t> ranges;
+		// Free ranges ordered by (size, offset) within every size class
+		std::array<std::set<std::pair<uint64_t, uint64_t>>, CLASSES> classes;
+
+		static int Leading(uint64_t value);
+		static int SizeClass(uint64_t size);
+
+		uint64_t Take(Range range, uint64_t size, uint64_t alignment);
+		void Insert(uint64_t offset, uint64_t size);
+		void Erase(Range range);
+	};
+}
@@ -4,7 +4,6 @@
 #include "Memory.h"
 #include "CommandBuffers.h"
 #include "Command.cpp"
-#include "Buffer.h"
 
 namespace Vulkan
 {
@@ -15,7 +14,10 @@ namespace Vulkan
 		VkImageTiling tiling,
 		VkImageType imageType,
 		VkImageUsageFlags usage,
-		VkMemoryPropertyFlags properties): extent(extent), format(format), imageType(imageType), device(device)
+		VkMemoryPropertyFlags properties,
+		MemoryCategory category,
+		const std::vector<uint32_t>& queueFamilies): extent(extent), format(format), imageType(imageType),
+		                                            device(device)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -32,14 +34,22 @@ namespace Vulkan
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		// Images used by several queue families avoid ownership transfers
+		if (queueFamilies.size() > 1)
+		{
+			imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+			imageInfo.pQueueFamilyIndices = queueFamilies.data();
+		}
+
 		VK_CHECK(vkCreateImage(device.Get(), &imageInfo, nullptr, &image), "Create image");
 
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(device.Get(), image, &memRequirements);
 
-		memory.reset(new Memory(device, memRequirements, 0, properties));
+		memory.reset(new Memory(device, memRequirements, 0, properties, category, tiling == VK_IMAGE_TILING_LINEAR));
 
-		vkBindImageMemory(device.Get(), image, memory->Get(), 0);
+		vkBindImageMemory(device.Get(), image, memory->Get(), memory->GetOffset());
 	}
 
 	Image::~Image()
@@ -117,26 +127,6 @@ namespace Vulkan
 			&barrier);
 	}
 
-	void Image::Copy(const CommandPool& commandPool, const Buffer& buffer)
-	{
-		Command::Submit(commandPool, [&](VkCommandBuffer commandBuffer)-> void
-		{
-			VkBufferImageCopy region = {};
-			region.bufferOffset = 0;
-			region.bufferRowLength = 0;
-			region.bufferImageHeight = 0;
-			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			region.imageSubresource.mipLevel = 0;
-			region.imageSubresource.baseArrayLayer = 0;
-			region.imageSubresource.layerCount = 1;
-			region.imageOffset = { 0, 0, 0 };
-			region.imageExtent = { extent.width, extent.height, 1 };
-
-			vkCmdCopyBufferToImage(
-				commandBuffer, buffer.Get(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-		});
-	}
-
 	void Image::TransitionImageLayout(
 		const CommandPool& commandPool,
 		VkImageLayout oldLayout,
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Vulkan_api.h"
+#include "Telemetry.h"
 
 #include <memory>
+#include <vector>
 
 namespace Vulkan
 {
@@ -17,11 +19,11 @@ namespace Vulkan
 		      VkImageTiling tiling,
 		      VkImageType imageType,
 		      VkImageUsageFlags usage,
-		      VkMemoryPropertyFlags properties);
+		      VkMemoryPropertyFlags properties,
+		      MemoryCategory category = MemoryCategory::Other,
+		      const std::vector<uint32_t>& queueFamilies = {});
 		~Image();
 
-		void Copy(const class CommandPool& commandPool, const class Buffer& buffer);
-
 		void TransitionImageLayout(
 			const class CommandPool& commandPool,
 			VkImageLayout oldLayout,
@@ -32,6 +34,11 @@ namespace Vulkan
 			return image;
 		}
 
+		[[nodiscard]] VkExtent2D GetExtent() const
+		{
+			return extent;
+		}
+
 		[[nodiscard]] VkFormat GetFormat() const
 		{
 			return format;
@@ -2,7 +2,7 @@
 
 namespace Vulkan
 {
-	Instance::Instance(const Window& window, const std::vector<const char*>& layers): window(window)
+	Instance::Instance(const Window* window, const std::vector<const char*>& layers): window(window)
 	{
 		// Core info
 		VkApplicationInfo appInfo = {};
@@ -51,6 +51,9 @@ namespace Vulkan
 
 	std::vector<const char*> Instance::GetRequiredInstanceExtensions() const
 	{
+		if (!window)
+			return {};
+
 		uint32_t glfwExtensionCount = 0;
 		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 		return std::vector<const char*>(glfwExtensions, glfwExtensions + glfwExtensionCount);
@@ -19,7 +19,8 @@ namespace Vulkan
 	public:
 		NON_COPIABLE(Instance)
 
-		Instance(const Window& window, const std::vector<const char*>& layers);
+		// Headless instances have no window, thus no surface extensions
+		Instance(const Window* window, const std::vector<const char*>& layers);
 		~Instance();
 
 		[[nodiscard]] VkInstance Get() const
@@ -29,7 +30,7 @@ namespace Vulkan
 
 		[[nodiscard]] const Window& GetWindow() const
 		{
-			return window;
+			return *window;
 		}
 
 		[[nodiscard]] const std::vector<VkPhysicalDevice>& GetDevices() const
@@ -44,6 +45,6 @@ namespace Vulkan
 
 		std::vector<VkPhysicalDevice> devices;
 		VkInstance instance{};
-		const Window& window;
+		const Window* window;
 	};
 }
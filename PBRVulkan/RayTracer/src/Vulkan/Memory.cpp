@@ -6,66 +6,44 @@ namespace Vulkan
 	Memory::Memory(const Device& device,
 	               VkMemoryRequirements requirements,
 	               VkMemoryAllocateFlags allocateFLags,
-	               VkMemoryPropertyFlags properties): device(device)
+	               VkMemoryPropertyFlags properties,
+	               MemoryCategory category,
+	               bool linear): device(device), category(category), size(requirements.size)
 	{
-		VkMemoryAllocateFlagsInfo flagsInfo = {};
-		flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-		flagsInfo.pNext = nullptr;
-		flagsInfo.flags = allocateFLags;
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.pNext = &flagsInfo;
-		allocInfo.allocationSize = requirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
-
-		VK_CHECK(vkAllocateMemory(device.Get(), &allocInfo, nullptr, &memory),
-		         "Allocate memory");
+		allocation = device.GetAllocator().Allocate(requirements, allocateFLags, properties, linear);
+		Telemetry::Get().Add(category, size);
 	}
 
 	Memory::~Memory()
 	{
-		if (memory != nullptr)
-		{
-			vkFreeMemory(device.Get(), memory, nullptr);
-			memory = nullptr;
-		}
+		device.GetAllocator().Free(allocation);
+		allocation = {};
+		Telemetry::Get().Remove(category, size);
 	}
 
 	void Memory::Fill(const void* data, size_t size) const
 	{
-		void* location;
-		vkMapMemory(device.Get(), memory, 0, size, 0, &location);
-		memcpy(location, data, size);
-		vkUnmapMemory(device.Get(), memory);
+		memcpy(Map(0, size), data, size);
 	}
 
 	void* Memory::Map(size_t offset, size_t size) const
 	{
-		void* data;
-		VK_CHECK(vkMapMemory(device.Get(), memory, offset, size, 0, &data), "Map memory");
-		return data;
+		if (allocation.mapped == nullptr)
+			throw std::runtime_error("Memory is not host visible!");
+
+		if (offset + size > allocation.size)
+			throw std::runtime_error("Memory map is out of range!");
+
+		return static_cast<char*>(allocation.mapped) + allocation.offset + offset;
 	}
 
 	void Memory::Unmap() const
 	{
-		vkUnmapMemory(device.Get(), memory);
+		// Host visible memory stays mapped for the lifetime of its block
 	}
 
 	uint32_t Memory::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-
-		vkGetPhysicalDeviceMemoryProperties(device.GetPhysical(), &memProperties);
-
-		for (uint32_t i = 0; i != memProperties.memoryTypeCount; ++i)
-		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-			{
-				return i;
-			}
-		}
-
-		throw std::runtime_error("Failed to find suitable memory type!");
+		return device.GetAllocator().FindMemoryType(typeFilter, properties);
 	}
 }
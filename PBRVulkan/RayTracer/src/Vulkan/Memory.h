@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Vulkan_api.h"
+#include "Allocator.h"
+#include "Telemetry.h"
+
 #include <cstring>
 
 namespace Vulkan
@@ -8,7 +11,8 @@ namespace Vulkan
 	class Device;
 
 	/*
-	 * Class which handles memory allocation for buffers.
+	 * Class which handles memory allocation for buffers and images.
+	 * The memory is a sub-allocation of the device allocator, thus resources have to be bound at GetOffset().
 	 */
 	class Memory final
 	{
@@ -19,7 +23,9 @@ namespace Vulkan
 			const Device& device,
 			VkMemoryRequirements requirements,
 			VkMemoryAllocateFlags allocateFLags,
-			VkMemoryPropertyFlags properties);
+			VkMemoryPropertyFlags properties,
+			MemoryCategory category,
+			bool linear = true);
 		~Memory();
 
 		void Fill(const void* data, size_t size) const;
@@ -29,7 +35,12 @@ namespace Vulkan
 
 		[[nodiscard]] const VkDeviceMemory& Get() const
 		{
-			return memory;
+			return allocation.memory;
+		}
+
+		[[nodiscard]] VkDeviceSize GetOffset() const
+		{
+			return allocation.offset;
 		}
 
 		[[nodiscard]] const class Device& GetDevice() const
@@ -37,9 +48,16 @@ namespace Vulkan
 			return device;
 		}
 
+		[[nodiscard]] MemoryCategory GetCategory() const
+		{
+			return category;
+		}
+
 		[[nodiscard]] uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 	private:
 		const Device& device;
-		VkDeviceMemory memory;
+		const MemoryCategory category;
+		const VkDeviceSize size;
+		Allocation allocation;
 	};
 }
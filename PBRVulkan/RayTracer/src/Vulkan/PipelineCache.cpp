@@ -0,0 +1,80 @@
+#include "PipelineCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "Device.h"
+
+namespace Vulkan
+{
+	PipelineCache::PipelineCache(const Device& device, std::string path): device(device), path(std::move(path))
+	{
+		std::vector<char> data;
+		std::ifstream file(this->path, std::ios::binary | std::ios::ate);
+
+		if (file)
+		{
+			data.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(data.data(), static_cast<std::streamsize>(data.size()));
+		}
+
+		if (!IsCompatible(data))
+			data.clear();
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		VK_CHECK(vkCreatePipelineCache(device.Get(), &createInfo, nullptr, &cache), "Create pipeline cache");
+
+		std::cout << "[PIPELINE CACHE] " << data.size() << " bytes have been loaded from " << this->path << std::endl;
+	}
+
+	PipelineCache::~PipelineCache()
+	{
+		if (cache != nullptr)
+		{
+			Save();
+			vkDestroyPipelineCache(device.Get(), cache, nullptr);
+			cache = nullptr;
+		}
+	}
+
+	bool PipelineCache::IsCompatible(const std::vector<char>& data) const
+	{
+		VkPipelineCacheHeaderVersionOne header{};
+
+		if (data.size() < sizeof(header))
+			return false;
+
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device.GetPhysical(), &properties);
+
+		return
+			header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header.vendorID == properties.vendorID &&
+			header.deviceID == properties.deviceID &&
+			std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void PipelineCache::Save() const
+	{
+		// Called from the destructor, a failure only loses the cache of this run
+		size_t size = 0;
+		if (vkGetPipelineCacheData(device.Get(), cache, &size, nullptr) != VK_SUCCESS)
+			return;
+
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(device.Get(), cache, &size, data.data()) != VK_SUCCESS)
+			return;
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), static_cast<std::streamsize>(size));
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <string>
+#include <vector>
+
+namespace Vulkan
+{
+	/*
+	 * Pipeline cache shared by every pipeline of the device.
+	 * The cache is loaded from a file at startup and written back on destruction,
+	 * thus pipelines of the same shaders are not compiled again by the driver.
+	 * A file of another device or driver version is ignored.
+	 */
+	class PipelineCache final
+	{
+	public:
+		NON_COPIABLE(PipelineCache)
+
+		PipelineCache(const class Device& device, std::string path);
+		~PipelineCache();
+
+		[[nodiscard]] VkPipelineCache Get() const
+		{
+			return cache;
+		}
+
+	private:
+		[[nodiscard]] bool IsCompatible(const std::vector<char>& data) const;
+		void Save() const;
+
+		const Device& device;
+		const std::string path;
+		VkPipelineCache cache{};
+	};
+}
@@ -9,24 +9,36 @@
 #include "Buffer.h"
 #include "DepthBuffer.h"
 #include "Fence.h"
+#include "FrameContext.h"
 #include "Framebuffer.h"
 #include "SwapChain.h"
 #include "RasterizerGraphicsPipeline.h"
 #include "CommandBuffers.h"
 #include "Semaphore.h"
+#include "UniformRing.h"
 
 #include "../Geometry/Global.h"
 
 namespace Vulkan
 {
-	Rasterizer::Rasterizer() = default;
+	Rasterizer::Rasterizer(bool headless): Core(headless) { }
 
 	Rasterizer::~Rasterizer()
 	{
 		Rasterizer::DeleteSwapChain();
 	}
 
-	void Rasterizer::Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	// The rasterizer depends on the swap chain framebuffer, it records everything in Render()
+	void Rasterizer::RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes) { }
+
+	void Rasterizer::RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex) { }
+
+	void Rasterizer::RecordTile(VkCommandBuffer commandBuffer, uint32_t frameIndex, const VkRect2D& tile) { }
+
+	void Rasterizer::RecordCompaction(VkCommandBuffer commandBuffer, uint32_t frameIndex) { }
+
+	void Rasterizer::Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t frameIndex,
+	                        uint32_t imageIndex)
 	{
 		std::array<VkClearValue, 2> clearValues = {};
 		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -43,7 +55,7 @@ namespace Vulkan
 
 		VkBuffer vertexBuffers[] = { scene->GetVertexBuffer().Get() };
 		const VkBuffer indexBuffer = scene->GetIndexBuffer().Get();
-		VkDescriptorSet descriptorSets[] = { rasterizerGraphicsPipeline->GetDescriptorSets()[imageIndex] };
+		VkDescriptorSet descriptorSets[] = { rasterizerGraphicsPipeline->GetDescriptorSets()[frameIndex] };
 		VkDeviceSize offsets[] = { 0 };
 
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
@@ -51,22 +63,26 @@ namespace Vulkan
 			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 			                  rasterizerGraphicsPipeline->GetPipeline());
 			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 			                        rasterizerGraphicsPipeline->GetPipelineLayout(), 0, 1, descriptorSets, 0, nullptr);
 
 			uint32_t vertexOffset = 0;
-			uint32_t indexOffset = 0;
+			uint32_t instance = 0;
+			// Index of the first cluster of the instance in the offsets buffer
+			uint32_t firstInstance = 0;
 
-			// Render all models with proper buffers offsets
+			// Render all models with proper buffers offsets, the index width differs per mesh
 			for (const auto& mesh : scene->GetMeshInstances())
 			{
-				const uint32_t indecies = scene->GetMeshes()[mesh.meshId]->GetIndeciesSize();
+				const auto& model = scene->GetMeshes()[mesh.meshId];
+				const uint32_t indecies = model->GetIndeciesSize();
+				const VkDeviceSize indexOffset = scene->GetIndexOffsets()[instance++];
 
-				vkCmdDrawIndexed(commandBuffer, indecies, 1, indexOffset, vertexOffset, 0);
+				vkCmdBindIndexBuffer(commandBuffer, indexBuffer, indexOffset, model->GetIndexType());
+				vkCmdDrawIndexed(commandBuffer, indecies, 1, 0, vertexOffset, firstInstance);
 
-				vertexOffset += scene->GetMeshes()[mesh.meshId]->GetVerticesSize();
-				indexOffset += indecies;
+				vertexOffset += model->GetVerticesSize();
+				firstInstance += static_cast<uint32_t>(model->GetClusters().size());
 			}
 		}
 		vkCmdEndRenderPass(commandBuffer);
@@ -77,32 +93,33 @@ namespace Vulkan
 		if (!scene)
 			throw std::runtime_error("Scene has not been loaded!");
 
-		swapChain.reset(new SwapChain(*device));
-		depthBuffer.reset(new DepthBuffer(*commandPool, swapChain->Extent));
+		if (headless)
+			swapChain.reset(new SwapChain(*device, offscreenExtent, FrameContext::MAX_FRAMES_IN_FLIGHT));
+		else
+			swapChain.reset(new SwapChain(*device));
 
-		for (const auto& _ : swapChain->GetImageViews())
-		{
-			inFlightFences.emplace_back(new Fence(*device));
-			imageAvailableSemaphores.emplace_back(new Semaphore(*device));
-			renderFinishedSemaphores.emplace_back(new Semaphore(*device));
-			uniformBuffers.emplace_back(
-				new Buffer(*device, sizeof(Uniforms::Global),
-				           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-		}
+		// Headless renders never rasterize
+		if (!headless)
+			depthBuffer.reset(new DepthBuffer(*commandPool, swapChain->Extent));
+
+		CreateFrames();
+
+		// One region per frame in flight, the global uniforms are the first push of every region
+		uniformRing.reset(new UniformRing(*device, FrameContext::MAX_FRAMES_IN_FLIGHT));
 
 		Rasterizer::CreateGraphicsPipeline();
 	}
 
 	void Rasterizer::DeleteSwapChain()
 	{
-		commandBuffers.reset();
+		traceCommandBuffers.reset();
+		copyCommandBuffers.reset();
+		compactionCommandBuffers.reset();
 		swapChainFrameBuffers.clear();
 		rasterizerGraphicsPipeline.reset();
-		uniformBuffers.clear();
-		inFlightFences.clear();
-		renderFinishedSemaphores.clear();
-		imageAvailableSemaphores.clear();
+		uniformRing.reset();
+		frames.clear();
+		imagesInFlight.clear();
 		depthBuffer.reset();
 
 		if (swapChain)
@@ -119,16 +136,25 @@ namespace Vulkan
 
 		swapChainFrameBuffers.clear();
 
-		rasterizerGraphicsPipeline.reset(
-			new RasterizerGraphicsPipeline(*swapChain, *device, *scene, uniformBuffers));
-
-		for (const auto& imageView : swapChain->GetImageViews())
+		// The offscreen images of a headless render are only written by copies
+		if (!headless)
 		{
-			swapChainFrameBuffers.emplace_back(
-				new Framebuffer(*imageView, *swapChain, *depthBuffer, rasterizerGraphicsPipeline->GetRenderPass()));
+			rasterizerGraphicsPipeline.reset(
+				new RasterizerGraphicsPipeline(*swapChain, *device, *scene, *uniformRing));
+
+			for (const auto& imageView : swapChain->GetImageViews())
+			{
+				swapChainFrameBuffers.emplace_back(
+					new Framebuffer(*imageView, *swapChain, *depthBuffer, rasterizerGraphicsPipeline->GetRenderPass()));
+			}
 		}
 
-		commandBuffers.reset(new CommandBuffers(*commandPool, static_cast<uint32_t>(swapChainFrameBuffers.size())));
+		const auto images = static_cast<uint32_t>(swapChain->GetImage().size());
+
+		traceCommandBuffers.reset(new CommandBuffers(*commandPool, FrameContext::MAX_FRAMES_IN_FLIGHT * TRACE_LEVELS));
+		copyCommandBuffers.reset(new CommandBuffers(*commandPool, images));
+		compactionCommandBuffers.reset(new CommandBuffers(*commandPool, FrameContext::MAX_FRAMES_IN_FLIGHT));
+		InvalidateCommands();
 	}
 
 	void Rasterizer::Copy(VkCommandBuffer commandBuffer, VkImage src, VkImage dst) const
@@ -152,5 +178,10 @@ namespace Vulkan
 		                     VK_ACCESS_TRANSFER_WRITE_BIT, 0,
 		                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		                     VK_IMAGE_LAYOUT_GENERAL);
+
+		// Storage images stay in the general layout between submits, a tile only rewrites a part of them
+		Image::MemoryBarrier(commandBuffer, src, subresourceRange,
+		                     VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+		                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
 	}
 }
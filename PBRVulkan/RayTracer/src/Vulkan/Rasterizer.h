@@ -9,7 +9,7 @@ namespace Vulkan
 	public:
 		NON_COPIABLE(Rasterizer)
 
-		Rasterizer();
+		explicit Rasterizer(bool headless);
 		~Rasterizer();
 
 		void CreateSwapChain() override;
@@ -18,7 +18,12 @@ namespace Vulkan
 		void Copy(VkCommandBuffer commandBuffer, VkImage src, VkImage dst) const;
 		
 	protected:
-		void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes) override;
+		void RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void RecordTile(VkCommandBuffer commandBuffer, uint32_t frameIndex, const VkRect2D& tile) override;
+		void RecordCompaction(VkCommandBuffer commandBuffer, uint32_t frameIndex) override;
+		void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t frameIndex,
+		            uint32_t imageIndex) override;
 
 	private:
 		std::unique_ptr<class RasterizerGraphicsPipeline> rasterizerGraphicsPipeline;
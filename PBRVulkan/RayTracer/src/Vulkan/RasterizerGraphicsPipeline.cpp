@@ -2,11 +2,13 @@
 
 #include "SwapChain.h"
 #include "Device.h"
+#include "PipelineCache.h"
 #include "Shader.h"
 #include "RenderPass.h"
 #include "DescriptorSetLayout.h"
 #include "DescriptorsManager.h"
 #include "Buffer.h"
+#include "UniformRing.h"
 
 #include "../Tracer/Scene.h"
 #include "../Tracer/TextureImage.h"
@@ -19,7 +21,7 @@ namespace Vulkan
 		const SwapChain& swapChain,
 		const Device& device,
 		const Tracer::Scene& scene,
-		const std::vector<std::unique_ptr<class Buffer>>& uniformBuffers):
+		const UniformRing& uniformRing):
 		device(device),
 		swapChain(swapChain),
 		renderPass(new RenderPass(device, swapChain, true, true))
@@ -34,8 +36,8 @@ namespace Vulkan
 			fragShader.CreateShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT)
 		};
 
-		auto bindingDescription = Geometry::Vertex::GetBindingDescription();
-		auto attributeDescriptions = Geometry::Vertex::GetAttributeDescriptions();
+		auto bindingDescription = Geometry::PackedVertex::GetBindingDescription();
+		auto attributeDescriptions = Geometry::PackedVertex::GetAttributeDescriptions();
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -129,37 +131,39 @@ namespace Vulkan
 			{ 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT },
 			{ 1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT },
 			{ 2, scene.GetTextureSize(), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT },
-			{ 3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT }
+			{ 3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT },
+			{ 4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT }
 		};
 
-		descriptorsManager.reset(new DescriptorsManager(device, swapChain, descriptorBindings));
+		descriptorsManager.reset(new DescriptorsManager(device, uniformRing.GetRegions(), descriptorBindings));
 
-		std::vector<VkDescriptorSetLayout> layouts(swapChain.GetImage().size(),
+		std::vector<VkDescriptorSetLayout> layouts(uniformRing.GetRegions(),
 		                                           descriptorsManager->GetDescriptorSetLayout().Get());
 
 		VkDescriptorSetAllocateInfo allocInfo = {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocInfo.descriptorPool = descriptorsManager->GetDescriptorPool();
-		allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChain.GetImage().size());
+		allocInfo.descriptorSetCount = uniformRing.GetRegions();
 		allocInfo.pSetLayouts = layouts.data();
 
-		descriptorSets.resize(swapChain.GetImage().size());
+		descriptorSets.resize(uniformRing.GetRegions());
 
 		VK_CHECK(vkAllocateDescriptorSets(device.Get(), &allocInfo, descriptorSets.data()),
 		         "Allocate descriptor sets");
 
-		for (size_t imageIndex = 0; imageIndex < swapChain.GetImage().size(); imageIndex++)
+		// One descriptor set per frame in flight, each one reads its own region of the uniform ring
+		for (uint32_t frameIndex = 0; frameIndex < uniformRing.GetRegions(); frameIndex++)
 		{
-			std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+			std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
 
 			// Uniforms descriptor
 			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = uniformBuffers[imageIndex]->Get();
-			bufferInfo.offset = 0;
+			bufferInfo.buffer = uniformRing.GetBuffer().Get();
+			bufferInfo.offset = uniformRing.GetRegionOffset(frameIndex);
 			bufferInfo.range = sizeof(Uniforms::Global);
 
 			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[0].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[0].dstBinding = 0;	
 			descriptorWrites[0].dstArrayElement = 0;
 			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -172,7 +176,7 @@ namespace Vulkan
 			materialInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[1].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[1].dstBinding = 1;
 			descriptorWrites[1].dstArrayElement = 0;
 			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -190,7 +194,7 @@ namespace Vulkan
 			}
 
 			descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[2].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[2].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[2].dstBinding = 2;
 			descriptorWrites[2].dstArrayElement = 0;
 			descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -203,13 +207,26 @@ namespace Vulkan
 			lightsBufferInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[3].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[3].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[3].dstBinding = 3;
 			descriptorWrites[3].dstArrayElement = 0;
 			descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 			descriptorWrites[3].descriptorCount = 1;
 			descriptorWrites[3].pBufferInfo = &lightsBufferInfo;
 
+			// Offsets buffer, the material id of a draw is fetched with gl_InstanceIndex
+			VkDescriptorBufferInfo offsetsBufferInfo = {};
+			offsetsBufferInfo.buffer = scene.GetOffsetBuffer().Get();
+			offsetsBufferInfo.range = VK_WHOLE_SIZE;
+
+			descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[4].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[4].dstBinding = 4;
+			descriptorWrites[4].dstArrayElement = 0;
+			descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[4].descriptorCount = 1;
+			descriptorWrites[4].pBufferInfo = &offsetsBufferInfo;
+
 			vkUpdateDescriptorSets(device.Get(), static_cast<uint32_t>(descriptorWrites.size()),
 			                       descriptorWrites.data(), 0, nullptr);
 		}
@@ -244,7 +261,8 @@ namespace Vulkan
 		pipelineInfo.basePipelineHandle = nullptr; // Optional
 		pipelineInfo.basePipelineIndex = -1; // Optional
 
-		VK_CHECK(vkCreateGraphicsPipelines(device.Get(), nullptr, 1, &pipelineInfo, nullptr, &pipeline),
+		VK_CHECK(vkCreateGraphicsPipelines(device.Get(), device.GetPipelineCache().Get(), 1, &pipelineInfo,
+		                                   nullptr, &pipeline),
 		         "Create graphics pipeline");
 	}
 
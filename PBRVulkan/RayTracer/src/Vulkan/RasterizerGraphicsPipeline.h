@@ -23,7 +23,7 @@ namespace Vulkan
 		RasterizerGraphicsPipeline(const class SwapChain& swapChain,
 		                           const class Device& device,
 		                           const Tracer::Scene& scene,
-		                           const std::vector<std::unique_ptr<class Buffer>>& uniformBuffers);
+		                           const class UniformRing& uniformRing);
 		~RasterizerGraphicsPipeline();
 
 		[[nodiscard]] VkPipelineLayout GetPipelineLayout() const
@@ -1,6 +1,7 @@
 #include "Raytracer.h"
 
 #include <chrono>
+#include <cstring>
 #include <iostream>
 
 #include "BLAS.h"
@@ -11,7 +12,11 @@
 #include "SwapChain.h"
 #include "ImageView.h"
 #include "Extensions.h"
+#include "AccelerationStructurePool.h"
 #include "ShaderBindingTable.h"
+#include "FrameContext.h"
+#include "TimestampQueries.h"
+#include "AdaptiveSampler.h"
 #include "RaytracerGraphicsPipeline.h"
 
 #include "../Assets/Mesh.h"
@@ -19,9 +24,12 @@
 
 namespace Vulkan
 {
-	Raytracer::Raytracer()
+	Raytracer::Raytracer(bool headless): Rasterizer(headless)
 	{
 		extensions.reset(new Extensions(*device));
+		accelerationStructurePool.reset(new AccelerationStructurePool(*device));
+		buildPolicySelector.reset(new BuildPolicySelector());
+		timestamps.reset(new TimestampQueries(*device, FrameContext::MAX_FRAMES_IN_FLIGHT));
 	}
 
 	Raytracer::~Raytracer()
@@ -42,6 +50,8 @@ namespace Vulkan
 		scene.reset();
 		raytracerGraphicsPipeline.reset();
 		shaderBindingTable.reset();
+		adaptiveSampler.reset();
+		readbackBuffer.reset();
 
 		BLASs.clear();
 		TLASs.clear();
@@ -62,11 +72,14 @@ namespace Vulkan
 				*outputImageView,
 				*normalsImageView,
 				*positionsImageView,
-				uniformBuffers,
+				*adaptiveSampler,
+				*uniformRing,
 				// For now assume only one instance of Top Level Instance
 				TLASs.front().Get()));
 
 		shaderBindingTable.reset(new ShaderBindingTable(*raytracerGraphicsPipeline));
+
+		InvalidateCommands();
 	}
 
 	void Raytracer::Clear(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
@@ -89,31 +102,109 @@ namespace Vulkan
 		                     VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 	}
 
-	void Raytracer::Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	/*
+	 * Records the given number of accumulation passes, every pass adds one sample to the accumulation image.
+	 * The pass index is pushed as a sample offset from the frame in the uniform buffer.
+	 * With the adaptive sampling only the pixels of the compacted list are traced.
+	 */
+	void Raytracer::RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes)
 	{
 		const auto extent = swapChain->Extent;
 
-		VkDescriptorSet descriptorSets[] = { raytracerGraphicsPipeline->GetDescriptorsSets()[imageIndex] };
+		VkImageSubresourceRange subresourceRange = Image::GetSubresourceRange();
 
+		// Pixels which are not traced keep their accumulated values
+		for (const auto image : { accumulationImage->Get(), outputImage->Get(), normalsImage->Get(),
+		                          positionsImage->Get() })
+		{
+			Image::MemoryBarrier(commandBuffer, image, subresourceRange,
+			                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+
+		BindPipeline(commandBuffer, frameIndex);
+
+		for (uint32_t pass = 0; pass < passes; ++pass)
+		{
+			// The next pass reads what the previous one has accumulated
+			if (pass > 0)
+			{
+				Image::MemoryBarrier(commandBuffer, accumulationImage->Get(), subresourceRange,
+				                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				                     VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+				                     VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+			}
+
+			TraceRays(commandBuffer, { { 0, 0 }, extent }, pass, settings.UseAdaptiveSampling);
+		}
+	}
+
+	/*
+	 * Traces one sample of the tile. The rest of the images is preserved, thus the layouts are not discarded.
+	 * The GPU time of the tile is measured with timestamps of the frame in flight.
+	 */
+	void Raytracer::RecordTile(VkCommandBuffer commandBuffer, uint32_t frameIndex, const VkRect2D& tile)
+	{
 		VkImageSubresourceRange subresourceRange = Image::GetSubresourceRange();
 
-		Image::MemoryBarrier(commandBuffer, accumulationImage->Get(), subresourceRange, 0,
-		                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		timestamps->Begin(commandBuffer, frameIndex);
 
-		Image::MemoryBarrier(commandBuffer, outputImage->Get(), subresourceRange, 0,
-		                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		for (const auto image : { accumulationImage->Get(), outputImage->Get() })
+		{
+			Image::MemoryBarrier(commandBuffer, image, subresourceRange,
+			                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
 
-		Image::MemoryBarrier(commandBuffer, normalsImage->Get(), subresourceRange, 0,
-		                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		BindPipeline(commandBuffer, frameIndex);
+		TraceRays(commandBuffer, tile, 0, false);
 
-		Image::MemoryBarrier(commandBuffer, positionsImage->Get(), subresourceRange, 0,
-		                     VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		timestamps->End(commandBuffer, frameIndex);
+	}
+
+	void Raytracer::RecordCompaction(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		adaptiveSampler->Record(commandBuffer, frameIndex, settings.AdaptiveThreshold);
+	}
+
+	std::optional<float> Raytracer::GetTileTime(uint32_t frameIndex) const
+	{
+		return timestamps->GetMilliseconds(frameIndex);
+	}
+
+	float Raytracer::GetEstimatedError(uint32_t frameIndex) const
+	{
+		return adaptiveSampler->GetError(frameIndex);
+	}
+
+	void Raytracer::BindPipeline(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+	{
+		VkDescriptorSet descriptorSets[] = { raytracerGraphicsPipeline->GetDescriptorsSets()[frameIndex] };
 
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
 		                  raytracerGraphicsPipeline->GetPipeline());
 
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
 		                        raytracerGraphicsPipeline->GetPipelineLayout(), 0, 1, descriptorSets, 0, nullptr);
+	}
+
+	void Raytracer::TraceRays(VkCommandBuffer commandBuffer, const VkRect2D& region, uint32_t pass,
+	                          bool compacted) const
+	{
+		const auto extent = swapChain->Extent;
+
+		const RaytracerGraphicsPipeline::PushConstants constants{
+			static_cast<uint32_t>(region.offset.x), static_cast<uint32_t>(region.offset.y),
+			extent.width, extent.height,
+			pass,
+			compacted
+		};
+
+		vkCmdPushConstants(commandBuffer, raytracerGraphicsPipeline->GetPipelineLayout(),
+		                   RaytracerGraphicsPipeline::PUSH_CONSTANT_STAGES, 0, sizeof(constants), &constants);
 
 		auto address = shaderBindingTable->GetBuffer().GetDeviceAddress();
 
@@ -125,29 +216,115 @@ namespace Vulkan
 		VkStridedDeviceAddressRegionKHR missShaderBindingTable = {};
 		missShaderBindingTable.deviceAddress = address + shaderBindingTable->GetEntrySize();
 		missShaderBindingTable.stride = shaderBindingTable->GetEntrySize();
-		missShaderBindingTable.size = shaderBindingTable->GetEntrySize();
+		missShaderBindingTable.size = shaderBindingTable->GetEntrySize() * 2;
 
 		VkStridedDeviceAddressRegionKHR hitShaderBindingTable = {};
 		hitShaderBindingTable.deviceAddress = address + shaderBindingTable->GetEntrySize() * 3;
 		hitShaderBindingTable.stride = shaderBindingTable->GetEntrySize();
-		hitShaderBindingTable.size = shaderBindingTable->GetEntrySize();
+		hitShaderBindingTable.size = shaderBindingTable->GetEntrySize() * RaytracerGraphicsPipeline::HIT_GROUPS;
 
 		VkStridedDeviceAddressRegionKHR callableShaderBindingTable = {};
 
+		// The number of pixels in the list is written by the compaction
+		if (compacted)
+		{
+			extensions->vkCmdTraceRaysIndirectKHR(commandBuffer,
+			                                      &raygenShaderBindingTable,
+			                                      &missShaderBindingTable,
+			                                      &hitShaderBindingTable,
+			                                      &callableShaderBindingTable,
+			                                      adaptiveSampler->GetIndirectAddress());
+			return;
+		}
+
 		extensions->vkCmdTraceRaysKHR(commandBuffer,
 		                              &raygenShaderBindingTable,
 		                              &missShaderBindingTable,
 		                              &hitShaderBindingTable,
 		                              &callableShaderBindingTable,
-		                              extent.width, extent.height, 1);
-
-		// Do not copy image to swap chain
-		if (settings.UseComputeShaders)
-			return;
+		                              region.extent.width, region.extent.height, 1);
+	}
 
+	void Raytracer::RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
 		Copy(commandBuffer, outputImage->Get(), swapChain->GetImage()[imageIndex]);
 	}
 
+	/*
+	 * The buffer is allocated by the first readback and holds every image, thus a readback of the
+	 * accumulation alone does not invalidate the other regions.
+	 */
+	void Raytracer::RecordReadback(VkCommandBuffer commandBuffer, bool aovs)
+	{
+		const auto extent = swapChain->Extent;
+		const size_t imageSize = sizeof(float) * 4 * extent.width * extent.height;
+
+		if (!readbackBuffer)
+		{
+			readbackBuffer.reset(
+				new Buffer(*device, imageSize * READBACK_IMAGES, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				           MemoryCategory::Readback));
+		}
+
+		const VkImage images[READBACK_IMAGES] = {
+			accumulationImage->Get(), normalsImage->Get(), positionsImage->Get()
+		};
+		const auto subresourceRange = Image::GetSubresourceRange();
+
+		for (uint32_t i = 0; i < (aovs ? READBACK_IMAGES : 1); ++i)
+		{
+			Image::MemoryBarrier(commandBuffer, images[i], subresourceRange,
+			                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+			                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = imageSize * i;
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageExtent = { extent.width, extent.height, 1 };
+
+			vkCmdCopyImageToBuffer(commandBuffer, images[i], VK_IMAGE_LAYOUT_GENERAL, readbackBuffer->Get(), 1,
+			                       &region);
+
+			// The next trace overwrites the image
+			Image::MemoryBarrier(commandBuffer, images[i], subresourceRange,
+			                     VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	std::vector<float> Raytracer::GetReadback(ReadbackImage image) const
+	{
+		const auto extent = swapChain->Extent;
+		const size_t imageSize = sizeof(float) * 4 * extent.width * extent.height;
+
+		std::vector<float> rgba(4 * static_cast<size_t>(extent.width) * extent.height);
+		const size_t offset = imageSize * static_cast<uint32_t>(image);
+
+		std::memcpy(rgba.data(), readbackBuffer->Map(offset, imageSize), imageSize);
+		readbackBuffer->Unmap();
+
+		return rgba;
+	}
+
+	std::vector<float> Raytracer::ReadAccumulation()
+	{
+		Command::Submit(*commandPool, [this](VkCommandBuffer commandBuffer)
+		{
+			RecordReadback(commandBuffer, false);
+		});
+
+		return GetReadback(ReadbackImage::Accumulation);
+	}
+
 	void Raytracer::CreateOutputTexture()
 	{
 		const auto extent = swapChain->Extent;
@@ -158,31 +335,52 @@ namespace Vulkan
 		accumulationImage.reset(
 			new Image(*device, extent, accumulationFormat, tiling, VK_IMAGE_TYPE_2D,
 			          VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
 
 		outputImage.reset(
 			new Image(*device, extent, outputFormat, tiling, VK_IMAGE_TYPE_2D,
 			          VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
 
 		normalsImage.reset(
-			new Image(*device, extent, accumulationFormat, tiling, VK_IMAGE_TYPE_2D, VK_IMAGE_USAGE_STORAGE_BIT,
-			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			new Image(*device, extent, accumulationFormat, tiling, VK_IMAGE_TYPE_2D,
+			          VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
 
 		positionsImage.reset(
-			new Image(*device, extent, accumulationFormat, tiling, VK_IMAGE_TYPE_2D, VK_IMAGE_USAGE_STORAGE_BIT,
-			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			new Image(*device, extent, accumulationFormat, tiling, VK_IMAGE_TYPE_2D,
+			          VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
 
 		accumulationImageView.reset(new ImageView(*device, accumulationImage->Get(), accumulationFormat));
 		outputImageView.reset(new ImageView(*device, outputImage->Get(), outputFormat));
 		normalsImageView.reset(new ImageView(*device, normalsImage->Get(), accumulationFormat));
 		positionsImageView.reset(new ImageView(*device, positionsImage->Get(), accumulationFormat));
+
+		adaptiveSampler.reset(new AdaptiveSampler(*device, extent, *accumulationImageView, *uniformRing));
+
+		// Tiles and the adaptive sampling expect the general layout as they keep the content of other pixels
+		Command::Submit(*commandPool, [this](VkCommandBuffer commandBuffer)
+		{
+			VkImageSubresourceRange subresourceRange = Image::GetSubresourceRange();
+
+			for (const auto image : { accumulationImage->Get(), outputImage->Get(), normalsImage->Get(),
+			                          positionsImage->Get(), adaptiveSampler->GetMomentsImageView().GetImage() })
+			{
+				Image::MemoryBarrier(commandBuffer, image, subresourceRange, 0,
+				                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				                     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+			}
+		});
 	}
 
 	void Raytracer::CreateAS()
 	{
 		const auto start = std::chrono::high_resolution_clock::now();
 
+		// Structures of the previous scene have been destroyed, their memory is reused
+		accelerationStructurePool->Reset();
+
 		Command::Submit(*commandPool, [this](VkCommandBuffer commandBuffer)
 		{
 			CreateBLAS(commandBuffer);
@@ -193,6 +391,9 @@ namespace Vulkan
 		const auto stop = std::chrono::high_resolution_clock::now();
 		const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
 
+		// The next scene estimates its build time with the measured throughput
+		buildPolicySelector->Calibrate(std::chrono::duration<float, std::milli>(stop - start).count());
+
 		std::cout << "[RAYTRACER] Acceleration data structure build: " << duration.count() << " milliseconds" <<
 			std::endl;
 	}
@@ -200,46 +401,71 @@ namespace Vulkan
 	void Raytracer::CreateBLAS(VkCommandBuffer commandBuffer)
 	{
 		uint32_t vertexOffset = 0;
-		uint32_t indexOffset = 0;
+		uint32_t instance = 0;
+
+		const auto options = scene->GetRendererOptions();
+		buildPolicySelector->Reset(options.buildBudget, options.lowMemoryThreshold);
 
 		for (const auto& model : scene->GetMeshInstances())
 		{
 			const auto& mesh = scene->GetMeshes()[model.meshId];
 			const auto vertexCount = mesh->GetVerticesSize();
-			const auto indexCount = mesh->GetIndeciesSize();
+			const auto indexOffset = scene->GetIndexOffsets()[instance++];
+			const auto indexStride = mesh->GetIndexStride();
+
+			for (const auto& cluster : mesh->GetClusters())
+			{
+				BLASGeometry geometry;
+				geometry.CreateGeometry(*scene, vertexOffset, vertexCount,
+				                        indexOffset + cluster.firstIndex * indexStride, cluster.indexCount,
+				                        mesh->GetIndexType(), true);
+				BLASs.emplace_back(*device, geometry,
+				                   buildPolicySelector->Select(cluster.indexCount / 3, model.dynamic));
+			}
+
+			vertexOffset += vertexCount * sizeof(Geometry::PackedVertex);
+		}
 
+		// All analytic primitives are stored in a single BLAS of AABBs
+		if (scene->GetPrimitivesSize() > 0)
+		{
 			BLASGeometry geometry;
-			geometry.CreateGeometry(*scene, vertexOffset, vertexCount, indexOffset, indexCount, true);
+			geometry.CreateAABBs(scene->GetAABBsBuffer().GetDeviceAddress(), scene->GetPrimitivesSize(), true);
 			BLASs.emplace_back(*device, geometry);
+		}
 
-			vertexOffset += vertexCount * sizeof(Geometry::Vertex);
-			indexOffset += indexCount * sizeof(uint32_t);
+		// Analytic lights are found by the traversal instead of testing every light per ray
+		if (scene->HasEmitters())
+		{
+			BLASGeometry geometry;
+			geometry.CreateAABBs(scene->GetLightsAABBsBuffer().GetDeviceAddress(), scene->GetLightsSize(), true);
+			BLASs.emplace_back(*device, geometry);
 		}
 
-		// Allocate the structure memory.
-		const auto total = AccelerationStructure::Reduce(BLASs);
+		for (size_t i = 0; i < BLASs.size(); ++i)
+		{
+			std::cout << "[BLAS] #" << i << ": " << BLASs[i].GetPrimitiveCount() << " primitives, " <<
+				BuildPolicySelector::ToString(BLASs[i].GetPolicy()) << std::endl;
+		}
 
-		BLASBuffer.reset(new Buffer(
-			*device, total.accelerationStructureSize,
-			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+		// Reserve the structure memory, the pool grows only when the scene does not fit.
+		const auto scratchAlignment = BLASs.front().accelerationProperties.minAccelerationStructureScratchOffsetAlignment;
+		const auto total = AccelerationStructure::ReduceAligned(BLASs, scratchAlignment);
 
-		const auto usage = static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-		        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		auto& blasArena = accelerationStructurePool->GetBLAS();
+		auto& scratchArena = accelerationStructurePool->GetScratchBLAS();
 
-		ScratchBLASBuffer.reset(new Buffer(
-			*device, total.buildScratchSize, usage, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+		blasArena.Reserve(total.accelerationStructureSize);
+		scratchArena.Reserve(total.buildScratchSize);
 
 		// Generate the structures.
-		VkDeviceSize resultOffset = 0;
-		VkDeviceSize scratchOffset = 0;
-
-		for (size_t i = 0; i < BLASs.size(); ++i)
+		for (auto& blas : BLASs)
 		{
-			BLASs[i].Generate(commandBuffer, *ScratchBLASBuffer, scratchOffset, *BLASBuffer, resultOffset);
-			resultOffset += BLASs[i].buildSizesInfo.accelerationStructureSize;
-			scratchOffset += BLASs[i].buildSizesInfo.buildScratchSize;
+			const auto resultOffset = blasArena.Allocate(blas.buildSizesInfo.accelerationStructureSize,
+			                                             AccelerationStructure::RESULT_ALIGNMENT);
+			const auto scratchOffset = scratchArena.Allocate(blas.buildSizesInfo.buildScratchSize, scratchAlignment);
+
+			blas.Generate(commandBuffer, scratchArena.GetBuffer(), scratchOffset, blasArena.GetBuffer(), resultOffset);
 		}
 	}
 
@@ -247,54 +473,87 @@ namespace Vulkan
 	{
 		std::vector<VkAccelerationStructureInstanceKHR> geometryInstances;
 
-		geometryInstances.reserve(scene->GetMeshes().size());
+		geometryInstances.reserve(BLASs.size());
+
+		const uint32_t proceduralCount = scene->GetPrimitivesSize() > 0 ? 1 : 0;
+		const uint32_t lightsCount = scene->HasEmitters() ? 1 : 0;
+		const uint32_t trianglesCount = static_cast<uint32_t>(BLASs.size()) - proceduralCount - lightsCount;
+
+		// Instance id matches the order of the offsets buffer
+		for (uint32_t instanceId = 0; instanceId < trianglesCount; ++instanceId)
+		{
+			geometryInstances.push_back(
+				TLAS::CreateInstance(BLASs[instanceId], glm::mat4(1), instanceId, TLAS::GEOMETRY_MASK));
+		}
+
+		if (proceduralCount > 0)
+		{
+			geometryInstances.push_back(
+				TLAS::CreateInstance(BLASs[trianglesCount], glm::mat4(1), 0, TLAS::GEOMETRY_MASK,
+				                     RaytracerGraphicsPipeline::PROCEDURAL_HIT_GROUP));
+		}
 
-		for (auto instanceId = 0; instanceId < int(scene->GetMeshInstances().size()); ++instanceId)
+		if (lightsCount > 0)
 		{
-			geometryInstances.push_back(TLAS::CreateInstance(BLASs[instanceId], glm::mat4(1), instanceId));
+			geometryInstances.push_back(
+				TLAS::CreateInstance(BLASs.back(), glm::mat4(1), 0, TLAS::LIGHTS_MASK,
+				                     RaytracerGraphicsPipeline::LIGHT_HIT_GROUP));
 		}
 
 		const auto size = sizeof(geometryInstances[0]) * geometryInstances.size();
-		instanceBuffer.reset(
-			new Buffer(*device, size,
-			           static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-			           VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR),
-			           VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-			           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
 
-		// ========== TODO Improve ==========
+		// Instances are copied from the persistent staging arena within the build command buffer
+		auto& instanceArena = accelerationStructurePool->GetInstances();
+		auto& stagingArena = accelerationStructurePool->GetStaging();
+
+		instanceArena.Reserve(size + 16);
+		stagingArena.Reserve(size);
+
+		// Instances address has to be aligned to 16 bytes
+		const auto instanceOffset = instanceArena.Allocate(size, 16);
+		const auto stagingOffset = stagingArena.Allocate(size, 1);
 
-		std::unique_ptr<Buffer> buffer_staging(
-			new Buffer(*device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		void* data = stagingArena.GetBuffer().Map(stagingOffset, size);
+		memcpy(data, geometryInstances.data(), size);
+		stagingArena.GetBuffer().Unmap();
 
-		buffer_staging->Fill(geometryInstances.data());
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = stagingOffset;
+		copyRegion.dstOffset = instanceOffset;
+		copyRegion.size = size;
 
-		instanceBuffer->Copy(*commandPool, *buffer_staging);
+		vkCmdCopyBuffer(commandBuffer, stagingArena.GetBuffer().Get(), instanceArena.GetBuffer().Get(), 1, &copyRegion);
 
-		buffer_staging.reset();
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
 
-		// ========== TODO Improve ==========
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
 
 		AccelerationStructure::MemoryBarrier(commandBuffer);
 
-		TLASs.emplace_back(*device, instanceBuffer->GetDeviceAddress(), geometryInstances.size());
+		TLASs.emplace_back(*device, instanceArena.GetBuffer().GetDeviceAddress() + instanceOffset,
+		                   geometryInstances.size());
 
-		const auto total = AccelerationStructure::Reduce(TLASs);
+		auto& tlas = TLASs.front();
+		const auto scratchAlignment = tlas.accelerationProperties.minAccelerationStructureScratchOffsetAlignment;
+		const auto total = AccelerationStructure::ReduceAligned(TLASs, scratchAlignment);
 
-		TLASBuffer.reset(new Buffer(
-			*device, total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+		auto& tlasArena = accelerationStructurePool->GetTLAS();
+		auto& scratchArena = accelerationStructurePool->GetScratchTLAS();
 
-		const auto usage = static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-		        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		tlasArena.Reserve(total.accelerationStructureSize);
+		scratchArena.Reserve(total.buildScratchSize);
 
-		ScratchTLASBuffer.reset(new Buffer(
-			*device, total.buildScratchSize, usage,
-			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+		const auto resultOffset = tlasArena.Allocate(tlas.buildSizesInfo.accelerationStructureSize,
+		                                             AccelerationStructure::RESULT_ALIGNMENT);
+		const auto scratchOffset = scratchArena.Allocate(tlas.buildSizesInfo.buildScratchSize, scratchAlignment);
 
 		// For now assume only one instance of Top Level Instance
-		TLASs.front().Generate(commandBuffer, *ScratchTLASBuffer, 0, *TLASBuffer, 0);
+		tlas.Generate(commandBuffer, scratchArena.GetBuffer(), scratchOffset, tlasArena.GetBuffer(), resultOffset);
 	}
 }
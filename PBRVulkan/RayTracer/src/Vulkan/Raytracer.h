@@ -2,6 +2,8 @@
 
 #include "Vulkan_api.h"
 
+#include <optional>
+
 #include "Rasterizer.h"
 #include "RaytracerGraphicsPipeline.h"
 
@@ -15,7 +17,7 @@ namespace Vulkan
 	public:
 		NON_COPIABLE(Raytracer)
 
-		Raytracer();
+		explicit Raytracer(bool headless);
 		~Raytracer();
 
 		void CreateSwapChain() override;
@@ -44,11 +46,36 @@ namespace Vulkan
 		}
 
 	protected:
-		void Render(VkFramebuffer framebuffer, VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void RecordTrace(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t passes) override;
+		void RecordCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void RecordTile(VkCommandBuffer commandBuffer, uint32_t frameIndex, const VkRect2D& tile) override;
+		void RecordCompaction(VkCommandBuffer commandBuffer, uint32_t frameIndex) override;
 		void CreateOutputTexture();
 		void CreateAS();
 
+		// GPU time of the last tile traced by the frame in flight, the frame has to be waited on
+		[[nodiscard]] std::optional<float> GetTileTime(uint32_t frameIndex) const;
+		// Error estimated by the last compaction submitted with the frame in flight
+		[[nodiscard]] float GetEstimatedError(uint32_t frameIndex) const;
+		enum class ReadbackImage : uint32_t
+		{
+			Accumulation,
+			Normals,
+			Positions
+		};
+
+		// Copies the accumulation, and the normals and positions with the AOVs, into the host-visible buffer
+		void RecordReadback(VkCommandBuffer commandBuffer, bool aovs);
+		// Pixels of the last readback as RGBA, the commands recording it have to be finished
+		[[nodiscard]] std::vector<float> GetReadback(ReadbackImage image) const;
+		// Radiance sums and sample counts of every pixel as RGBA, the device has to be idle
+		[[nodiscard]] std::vector<float> ReadAccumulation();
+
 	private:
+		static constexpr uint32_t READBACK_IMAGES = 3;
+
+		void BindPipeline(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+		void TraceRays(VkCommandBuffer commandBuffer, const VkRect2D& region, uint32_t pass, bool compacted) const;
 		void CreateBLAS(VkCommandBuffer commandBuffer);
 		void CreateTLAS(VkCommandBuffer commandBuffer);
 
@@ -63,14 +90,14 @@ namespace Vulkan
 		std::unique_ptr<class ImageView> normalsImageView;
 		std::unique_ptr<class Image> positionsImage;
 		std::unique_ptr<class ImageView> positionsImageView;
+		std::unique_ptr<class Buffer> readbackBuffer;
 
-		std::unique_ptr<class Buffer> instanceBuffer;
-		std::unique_ptr<class Buffer> BLASBuffer;
-		std::unique_ptr<class Buffer> ScratchBLASBuffer;
-		std::unique_ptr<class Buffer> TLASBuffer;
-		std::unique_ptr<class Buffer> ScratchTLASBuffer;
+		std::unique_ptr<class AccelerationStructurePool> accelerationStructurePool;
+		std::unique_ptr<class BuildPolicySelector> buildPolicySelector;
 		std::unique_ptr<class Extensions> extensions;
 		std::unique_ptr<class ShaderBindingTable> shaderBindingTable;
+		std::unique_ptr<class TimestampQueries> timestamps;
+		std::unique_ptr<class AdaptiveSampler> adaptiveSampler;
 		std::unique_ptr<class RaytracerGraphicsPipeline> raytracerGraphicsPipeline;
 	};
 }
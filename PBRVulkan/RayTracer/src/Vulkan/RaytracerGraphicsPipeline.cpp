@@ -3,12 +3,17 @@
 #include "Extensions.h"
 #include "SwapChain.h"
 #include "Device.h"
+#include "PipelineCache.h"
 #include "Shader.h"
 #include "RenderPass.h"
 #include "DescriptorSetLayout.h"
 #include "DescriptorsManager.h"
 #include "Buffer.h"
+#include "UniformRing.h"
+#include "ImageView.h"
+#include "AdaptiveSampler.h"
 
+#include "../Geometry/Global.h"
 #include "../Tracer/Scene.h"
 #include "../Tracer/TextureImage.h"
 
@@ -22,7 +27,8 @@ namespace Vulkan
 		const ImageView& outputImage,
 		const ImageView& normalsImage,
 		const ImageView& positionsImage,
-		const std::vector<std::unique_ptr<Buffer>>& uniformBuffers,
+		const AdaptiveSampler& adaptiveSampler,
+		const UniformRing& uniformRing,
 		VkAccelerationStructureKHR topLevelAS):
 		device(device),
 		swapChain(swapChain),
@@ -35,13 +41,21 @@ namespace Vulkan
 		const Shader missShader(device, "Raytracing.compiled.rmiss.spv");
 		const Shader shadowShader(device, "Shadow.compiled.rmiss.spv");
 		const Shader closestHitShader(device, "Raytracing.compiled.rchit.spv");
+		const Shader intersectionShader(device, "Procedural.compiled.rint.spv");
+		const Shader proceduralHitShader(device, "Procedural.compiled.rchit.spv");
+		const Shader lightIntersectionShader(device, "Light.compiled.rint.spv");
+		const Shader lightHitShader(device, "Light.compiled.rchit.spv");
 
-		std::array<VkPipelineShaderStageCreateInfo, 4> shaderStages =
+		std::array<VkPipelineShaderStageCreateInfo, 8> shaderStages =
 		{
 			rayGenShader.CreateShaderStage(VK_SHADER_STAGE_RAYGEN_BIT_KHR),
 			missShader.CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
 			shadowShader.CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
-			closestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR)
+			closestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
+			intersectionShader.CreateShaderStage(VK_SHADER_STAGE_INTERSECTION_BIT_KHR),
+			proceduralHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
+			lightIntersectionShader.CreateShaderStage(VK_SHADER_STAGE_INTERSECTION_BIT_KHR),
+			lightHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR)
 		};
 
 		// Shader group
@@ -81,12 +95,32 @@ namespace Vulkan
 		triangleHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
 		triangleHitGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
 
+		VkRayTracingShaderGroupCreateInfoKHR proceduralHitGroupInfo = {};
+		proceduralHitGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+		proceduralHitGroupInfo.pNext = nullptr;
+		proceduralHitGroupInfo.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
+		proceduralHitGroupInfo.generalShader = VK_SHADER_UNUSED_KHR;
+		proceduralHitGroupInfo.closestHitShader = 5;
+		proceduralHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
+		proceduralHitGroupInfo.intersectionShader = 4;
+
+		VkRayTracingShaderGroupCreateInfoKHR lightHitGroupInfo = {};
+		lightHitGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+		lightHitGroupInfo.pNext = nullptr;
+		lightHitGroupInfo.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
+		lightHitGroupInfo.generalShader = VK_SHADER_UNUSED_KHR;
+		lightHitGroupInfo.closestHitShader = 7;
+		lightHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
+		lightHitGroupInfo.intersectionShader = 6;
+
 		std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups =
 		{
 			rayGenGroupInfo,
 			missGroupInfo,
 			shadowGroupInfo,
 			triangleHitGroupInfo,
+			proceduralHitGroupInfo,
+			lightHitGroupInfo,
 		};
 
 		std::vector<DescriptorBinding> descriptorBindings =
@@ -133,7 +167,7 @@ namespace Vulkan
 			// Lights buffer
 			{
 				9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-				VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR
+				VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR
 			},
 
 			// Normal
@@ -144,6 +178,21 @@ namespace Vulkan
 			// World position
 			{
 				11, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR
+			},
+
+			// Analytic primitives
+			{
+				13, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				VK_SHADER_STAGE_INTERSECTION_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR
+			},
+
+			// Moments of the adaptive sampling
+			{ 14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR },
+
+			// Compacted pixels of the adaptive sampling
+			{
+				15, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR
 			}
 		};
 
@@ -157,25 +206,26 @@ namespace Vulkan
 				});
 		}
 
-		descriptorsManager.reset(new DescriptorsManager(device, swapChain, descriptorBindings));
+		descriptorsManager.reset(new DescriptorsManager(device, uniformRing.GetRegions(), descriptorBindings));
 
-		std::vector<VkDescriptorSetLayout> layouts(swapChain.GetImage().size(),
+		std::vector<VkDescriptorSetLayout> layouts(uniformRing.GetRegions(),
 		                                           descriptorsManager->GetDescriptorSetLayout().Get());
 
 		VkDescriptorSetAllocateInfo allocInfo = {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocInfo.descriptorPool = descriptorsManager->GetDescriptorPool();
-		allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChain.GetImage().size());
+		allocInfo.descriptorSetCount = uniformRing.GetRegions();
 		allocInfo.pSetLayouts = layouts.data();
 
-		descriptorSets.resize(swapChain.GetImage().size());
+		descriptorSets.resize(uniformRing.GetRegions());
 
 		VK_CHECK(vkAllocateDescriptorSets(device.Get(), &allocInfo, descriptorSets.data()),
 		         "Allocate descriptor sets");
 
-		for (size_t imageIndex = 0; imageIndex < swapChain.GetImage().size(); imageIndex++)
+		// One descriptor set per frame in flight, each one reads its own region of the uniform ring
+		for (uint32_t frameIndex = 0; frameIndex < uniformRing.GetRegions(); frameIndex++)
 		{
-			std::vector<VkWriteDescriptorSet> descriptorWrites(12);
+			std::vector<VkWriteDescriptorSet> descriptorWrites(15);
 
 			// Top level acceleration structure.
 			VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
@@ -185,7 +235,7 @@ namespace Vulkan
 			structureInfo.pAccelerationStructures = &topLevelAS;
 
 			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[0].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[0].dstBinding = 0;
 			descriptorWrites[0].dstArrayElement = 0;
 			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
@@ -198,7 +248,7 @@ namespace Vulkan
 			accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[1].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[1].dstBinding = 1;
 			descriptorWrites[1].dstArrayElement = 0;
 			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -211,7 +261,7 @@ namespace Vulkan
 			outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 			descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[2].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[2].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[2].dstBinding = 2;
 			descriptorWrites[2].dstArrayElement = 0;
 			descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -220,11 +270,12 @@ namespace Vulkan
 
 			// Uniform buffer
 			VkDescriptorBufferInfo uniformBufferInfo = {};
-			uniformBufferInfo.buffer = uniformBuffers[imageIndex]->Get();
-			uniformBufferInfo.range = VK_WHOLE_SIZE;
+			uniformBufferInfo.buffer = uniformRing.GetBuffer().Get();
+			uniformBufferInfo.offset = uniformRing.GetRegionOffset(frameIndex);
+			uniformBufferInfo.range = sizeof(Uniforms::Global);
 
 			descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[3].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[3].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[3].dstBinding = 3;
 			descriptorWrites[3].dstArrayElement = 0;
 			descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -237,7 +288,7 @@ namespace Vulkan
 			vertexBufferInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[4].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[4].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[4].dstBinding = 4;
 			descriptorWrites[4].dstArrayElement = 0;
 			descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -250,7 +301,7 @@ namespace Vulkan
 			indexBufferInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[5].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[5].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[5].dstBinding = 5;
 			descriptorWrites[5].dstArrayElement = 0;
 			descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -263,7 +314,7 @@ namespace Vulkan
 			materialBufferInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[6].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[6].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[6].dstBinding = 6;
 			descriptorWrites[6].dstArrayElement = 0;
 			descriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -276,7 +327,7 @@ namespace Vulkan
 			offsetsBufferInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[7].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[7].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[7].dstBinding = 7;
 			descriptorWrites[7].dstArrayElement = 0;
 			descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -294,7 +345,7 @@ namespace Vulkan
 			}
 
 			descriptorWrites[8].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[8].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[8].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[8].dstBinding = 8;
 			descriptorWrites[8].dstArrayElement = 0;
 			descriptorWrites[8].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -307,7 +358,7 @@ namespace Vulkan
 			lightsBufferInfo.range = VK_WHOLE_SIZE;
 
 			descriptorWrites[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[9].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[9].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[9].dstBinding = 9;
 			descriptorWrites[9].dstArrayElement = 0;
 			descriptorWrites[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -320,7 +371,7 @@ namespace Vulkan
 			normalsImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 			descriptorWrites[10].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[10].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[10].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[10].dstBinding = 10;
 			descriptorWrites[10].dstArrayElement = 0;
 			descriptorWrites[10].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -333,13 +384,52 @@ namespace Vulkan
 			positionImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 			descriptorWrites[11].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[11].dstSet = descriptorSets[imageIndex];
+			descriptorWrites[11].dstSet = descriptorSets[frameIndex];
 			descriptorWrites[11].dstBinding = 11;
 			descriptorWrites[11].dstArrayElement = 0;
 			descriptorWrites[11].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 			descriptorWrites[11].descriptorCount = 1;
 			descriptorWrites[11].pImageInfo = &positionImageInfo;
 
+			// Primitives buffer
+			VkDescriptorBufferInfo primitivesBufferInfo = {};
+			primitivesBufferInfo.buffer = scene.GetPrimitivesBuffer().Get();
+			primitivesBufferInfo.range = VK_WHOLE_SIZE;
+
+			descriptorWrites[12].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[12].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[12].dstBinding = 13;
+			descriptorWrites[12].dstArrayElement = 0;
+			descriptorWrites[12].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[12].descriptorCount = 1;
+			descriptorWrites[12].pBufferInfo = &primitivesBufferInfo;
+
+			// Moments image
+			VkDescriptorImageInfo momentsImageInfo = {};
+			momentsImageInfo.imageView = adaptiveSampler.GetMomentsImageView().Get();
+			momentsImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			descriptorWrites[13].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[13].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[13].dstBinding = 14;
+			descriptorWrites[13].dstArrayElement = 0;
+			descriptorWrites[13].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			descriptorWrites[13].descriptorCount = 1;
+			descriptorWrites[13].pImageInfo = &momentsImageInfo;
+
+			// Pixel list
+			VkDescriptorBufferInfo pixelListInfo = {};
+			pixelListInfo.buffer = adaptiveSampler.GetPixelList().Get();
+			pixelListInfo.range = VK_WHOLE_SIZE;
+
+			descriptorWrites[14].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[14].dstSet = descriptorSets[frameIndex];
+			descriptorWrites[14].dstBinding = 15;
+			descriptorWrites[14].dstArrayElement = 0;
+			descriptorWrites[14].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[14].descriptorCount = 1;
+			descriptorWrites[14].pBufferInfo = &pixelListInfo;
+
 			// Outside the block because of RAII 
 			std::vector<VkDescriptorImageInfo> hdrInfos(scene.GetHDRTextures().size());
 			VkWriteDescriptorSet descriptor{};
@@ -355,7 +445,7 @@ namespace Vulkan
 				}
 
 				descriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descriptor.dstSet = descriptorSets[imageIndex];
+				descriptor.dstSet = descriptorSets[frameIndex];
 				descriptor.dstBinding = 12;
 				descriptor.dstArrayElement = 0;
 				descriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -371,11 +461,17 @@ namespace Vulkan
 
 		VkDescriptorSetLayout descriptorSetLayouts[] = { descriptorsManager->GetDescriptorSetLayout().Get() };
 
+		// Traced region and index of the accumulation pass within the submitted frame
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = PUSH_CONSTANT_STAGES;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(PushConstants);
+
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
 
 		VK_CHECK(vkCreatePipelineLayout(device.Get(), &pipelineLayoutInfo, nullptr, &pipelineLayout),
@@ -393,7 +489,8 @@ namespace Vulkan
 		pipelineInfo.maxPipelineRayRecursionDepth = 2;
 		pipelineInfo.layout = pipelineLayout;
 
-		VK_CHECK(extensions->vkCreateRayTracingPipelinesKHR(device.Get(), nullptr, nullptr, 1, &pipelineInfo, nullptr, &pipeline),
+		VK_CHECK(extensions->vkCreateRayTracingPipelinesKHR(device.Get(), nullptr, device.GetPipelineCache().Get(), 1,
+		                                                    &pipelineInfo, nullptr, &pipeline),
 		         "Create ray tracing pipeline");
 	}
 
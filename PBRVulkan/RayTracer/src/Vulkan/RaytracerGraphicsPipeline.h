@@ -13,16 +13,35 @@ namespace Tracer
 namespace Vulkan
 {
 	/*
-	 * By default the pipeline supports only 3 ray tracing shaders
+	 * The pipeline supports the following ray tracing shader groups
 	 * - ray generation
-	 * - ray hit
-	 * - ray miss
+	 * - ray miss and shadow miss
+	 * - triangles hit group
+	 * - procedural hit group (intersection + closest hit) for analytic primitives
+	 * - light hit group (intersection + closest hit) for analytic lights
 	 */
 	class RaytracerGraphicsPipeline final
 	{
 	public:
 		NON_COPIABLE(RaytracerGraphicsPipeline)
 
+		// Hit groups offsets within the hit region of the SBT
+		static constexpr uint32_t TRIANGLES_HIT_GROUP = 0;
+		static constexpr uint32_t PROCEDURAL_HIT_GROUP = 1;
+		static constexpr uint32_t LIGHT_HIT_GROUP = 2;
+		static constexpr uint32_t HIT_GROUPS = 3;
+		static constexpr VkShaderStageFlags PUSH_CONSTANT_STAGES =
+			VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
+		// Matches the PushConstants block of the ray generation and closest hit shaders
+		struct PushConstants
+		{
+			uint32_t tileOffset[2];
+			uint32_t extent[2];
+			uint32_t pass;
+			uint32_t compacted;
+		};
+
 		RaytracerGraphicsPipeline(const class SwapChain& swapChain,
 		                          const class Device& device,
 		                          const Tracer::Scene& scene,
@@ -30,7 +49,8 @@ namespace Vulkan
 		                          const class ImageView& outputImage,
 		                          const class ImageView& normalsImage,
 		                          const class ImageView& positionsImage,
-		                          const std::vector<std::unique_ptr<class Buffer>>& uniformBuffers,
+		                          const class AdaptiveSampler& adaptiveSampler,
+		                          const class UniformRing& uniformRing,
 		                          VkAccelerationStructureKHR topLevelAS);
 		~RaytracerGraphicsPipeline();
 
@@ -0,0 +1,63 @@
+#include "ReadbackRing.h"
+
+#include <cstring>
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Image.h"
+
+namespace Vulkan
+{
+	ReadbackRing::ReadbackRing(const Device& device, VkExtent2D extent, uint32_t regions):
+		extent(extent), regionSize(4 * static_cast<VkDeviceSize>(extent.width) * extent.height)
+	{
+		buffer.reset(new Buffer(device, regionSize * regions, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                        MemoryCategory::Readback));
+
+		mapped = static_cast<uint8_t*>(buffer->Map(0, regionSize * regions));
+	}
+
+	ReadbackRing::~ReadbackRing()
+	{
+		buffer->Unmap();
+	}
+
+	void ReadbackRing::Record(VkCommandBuffer commandBuffer, uint32_t region, VkImage image,
+	                          VkImageLayout layout) const
+	{
+		const auto subresourceRange = Image::GetSubresourceRange();
+
+		Image::MemoryBarrier(commandBuffer, image, subresourceRange,
+		                     VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+		                     layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+		VkBufferImageCopy copyRegion{};
+		copyRegion.bufferOffset = regionSize * region;
+		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer->Get(), 1,
+		                       &copyRegion);
+
+		Image::MemoryBarrier(commandBuffer, image, subresourceRange,
+		                     VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+		                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, layout);
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	std::vector<uint8_t> ReadbackRing::Read(uint32_t region) const
+	{
+		std::vector<uint8_t> pixels(regionSize);
+		std::memcpy(pixels.data(), mapped + regionSize * region, regionSize);
+
+		return pixels;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	/*
+	 * Host visible buffer which is mapped once and split into one region per frame in flight.
+	 * A frame records the copy of its presented image into its own region, once the fence of the frame
+	 * has been waited on the pixels are read without stalling the queue.
+	 */
+	class ReadbackRing final
+	{
+	public:
+		NON_COPIABLE(ReadbackRing)
+
+		ReadbackRing(const class Device& device, VkExtent2D extent, uint32_t regions);
+		~ReadbackRing();
+
+		// The image is left in its layout, the copy only has to follow the writes of the image
+		void Record(VkCommandBuffer commandBuffer, uint32_t region, VkImage image, VkImageLayout layout) const;
+
+		// Four bytes per pixel, top row first, the fence of the frame which recorded the copy has been waited on
+		[[nodiscard]] std::vector<uint8_t> Read(uint32_t region) const;
+
+		[[nodiscard]] VkExtent2D GetExtent() const
+		{
+			return extent;
+		}
+
+	private:
+		const VkExtent2D extent;
+		const VkDeviceSize regionSize;
+		uint8_t* mapped{};
+
+		std::unique_ptr<class Buffer> buffer;
+	};
+}
@@ -21,4 +21,46 @@ namespace Vulkan
 			semaphore = nullptr;
 		}
 	}
+
+	TimelineSemaphore::TimelineSemaphore(const Device& device, uint64_t initialValue): device(device)
+	{
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = initialValue;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		VK_CHECK(vkCreateSemaphore(device.Get(), &semaphoreInfo, nullptr, &semaphore),
+		         "Create timeline semaphore");
+	}
+
+	TimelineSemaphore::~TimelineSemaphore()
+	{
+		if (semaphore != nullptr)
+		{
+			vkDestroySemaphore(device.Get(), semaphore, nullptr);
+			semaphore = nullptr;
+		}
+	}
+
+	void TimelineSemaphore::Wait(uint64_t value) const
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &semaphore;
+		waitInfo.pValues = &value;
+
+		VK_CHECK(vkWaitSemaphores(device.Get(), &waitInfo, UINT64_MAX), "Wait for timeline semaphore");
+	}
+
+	uint64_t TimelineSemaphore::GetValue() const
+	{
+		uint64_t value = 0;
+		VK_CHECK(vkGetSemaphoreCounterValue(device.Get(), semaphore, &value), "Get timeline semaphore value");
+		return value;
+	}
 }
@@ -21,4 +21,30 @@ namespace Vulkan
 		const Device& device;
 		VkSemaphore semaphore;
 	};
+
+	/*
+	 * Semaphore with a monotonically increasing 64-bit payload.
+	 * Queues signal and wait on values, the host can poll or block on a value without a fence.
+	 */
+	class TimelineSemaphore final
+	{
+	public:
+		NON_COPIABLE(TimelineSemaphore)
+
+		explicit TimelineSemaphore(const class Device& device, uint64_t initialValue = 0);
+		~TimelineSemaphore();
+
+		void Wait(uint64_t value) const;
+
+		[[nodiscard]] uint64_t GetValue() const;
+
+		[[nodiscard]] VkSemaphore Get() const
+		{
+			return semaphore;
+		}
+
+	private:
+		const Device& device;
+		VkSemaphore semaphore{};
+	};
 }
@@ -35,7 +35,8 @@ namespace Vulkan
 		extensions.reset(new Extensions(raytracerPipeline.GetDevice()));
 
 		uint32_t handleSize = pipelineRTProperties.shaderGroupHandleSize;
-		uint32_t groupCount = 4;
+		// Ray generation, two miss shaders and the hit groups
+		uint32_t groupCount = 3 + RaytracerGraphicsPipeline::HIT_GROUPS;
 		entrySize = SBT::RoundUp(handleSize, pipelineRTProperties.shaderGroupBaseAlignment);
 
 		const size_t stbSize = groupCount * entrySize;
@@ -45,7 +46,7 @@ namespace Vulkan
 
 		stbBuffer.reset(new Buffer(raytracerPipeline.GetDevice(), stbSize, usage,
 		                           VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-		                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT));
+		                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryCategory::ShaderBindingTable));
 
 		std::vector<uint8_t> shaderHandleStorage(groupCount * handleSize);
 
@@ -70,8 +71,12 @@ namespace Vulkan
 		std::memcpy(dst, shaderHandleStorage.data() + 2 * handleSize, handleSize);
 		dst += entrySize;
 
-		// Hit
-		std::memcpy(dst, shaderHandleStorage.data() + 3 * handleSize, handleSize);
+		// Hit (triangles, procedural and lights)
+		for (uint32_t group = 0; group < RaytracerGraphicsPipeline::HIT_GROUPS; ++group)
+		{
+			std::memcpy(dst, shaderHandleStorage.data() + (3 + group) * handleSize, handleSize);
+			dst += entrySize;
+		}
 
 		stbBuffer->Unmap();
 	}
@@ -4,12 +4,13 @@
 #include "Window.h"
 #include "Instance.h"
 #include "ImageView.h"
+#include "Image.h"
 
 #include <algorithm>
 
 namespace Vulkan
 {
-	SwapChain::SwapChain(const Device& device): device(device), surface(device.GetSurface())
+	SwapChain::SwapChain(const Device& device): device(device), surface(&device.GetSurface())
 	{
 		const auto swapChainSupport = QuerySwapChainSupport(device.GetPhysical());
 
@@ -20,7 +21,7 @@ namespace Vulkan
 
 		VkSwapchainCreateInfoKHR createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-		createInfo.surface = surface.Get();
+		createInfo.surface = surface->Get();
 		createInfo.minImageCount = imageCount;
 		createInfo.imageFormat = surfaceFormat.format;
 		createInfo.imageColorSpace = surfaceFormat.colorSpace;
@@ -63,9 +64,31 @@ namespace Vulkan
 		CreateImageViews();
 	}
 
+	SwapChain::SwapChain(const Device& device, VkExtent2D extent, uint32_t imageCount): device(device)
+	{
+		// Storage support of the format is mandatory, the ray traced output image uses the same format
+		Format = VK_FORMAT_R8G8B8A8_UNORM;
+		Extent = extent;
+		MinImageCount = imageCount;
+		PresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+		for (uint32_t i = 0; i < imageCount; ++i)
+		{
+			offscreenImages.emplace_back(new Image(
+				device, extent, Format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_TYPE_2D,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::RenderTargets));
+
+			images.push_back(offscreenImages.back()->Get());
+		}
+
+		CreateImageViews();
+	}
+
 	SwapChain::~SwapChain()
 	{
 		imageViews.clear();
+		offscreenImages.clear();
 
 		if (swapChain != nullptr)
 		{
@@ -78,24 +101,24 @@ namespace Vulkan
 	{
 		SwapChainSupportDetails details;
 
-		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface.Get(), &details.Capabilities);
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface->Get(), &details.Capabilities);
 
 		uint32_t formatCount;
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface.Get(), &formatCount, nullptr);
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface->Get(), &formatCount, nullptr);
 
 		if (formatCount != 0)
 		{
 			details.Formats.resize(formatCount);
-			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface.Get(), &formatCount, details.Formats.data());
+			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface->Get(), &formatCount, details.Formats.data());
 		}
 
 		uint32_t presentModeCount;
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface.Get(), &presentModeCount, nullptr);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface->Get(), &presentModeCount, nullptr);
 
 		if (presentModeCount != 0)
 		{
 			details.PresentModes.resize(presentModeCount);
-			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface.Get(), &presentModeCount,
+			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface->Get(), &presentModeCount,
 			                                          details.PresentModes.data());
 		}
 
@@ -143,7 +166,7 @@ namespace Vulkan
 			return capabilities.currentExtent;
 		}
 
-		auto actualExtent = surface.GetInstance().GetWindow().GetFramebufferSize();
+		auto actualExtent = surface->GetInstance().GetWindow().GetFramebufferSize();
 		actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width,
 		                                capabilities.maxImageExtent.width);
 		actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height,
@@ -19,6 +19,7 @@ namespace Vulkan
 	 *  Our application will acquire such an image to draw to it, and then return it to the queue.
 	 *  The general purpose of the swap chain is to synchronize the presentation of images
 	 *  with the refresh rate of the screen.
+	 *  Headless renders use offscreen images instead, nothing is acquired or presented.
 	 */
 	class SwapChain final
 	{
@@ -26,6 +27,7 @@ namespace Vulkan
 		NON_COPIABLE(SwapChain)
 
 		SwapChain(const class Device& device);
+		SwapChain(const class Device& device, VkExtent2D extent, uint32_t imageCount);
 		~SwapChain();
 
 		[[nodiscard]] VkSwapchainKHR Get() const
@@ -33,6 +35,17 @@ namespace Vulkan
 			return swapChain;
 		};
 
+		[[nodiscard]] bool IsOffscreen() const
+		{
+			return swapChain == nullptr;
+		}
+
+		// Layout of the images once a render pass has finished, offscreen images are never presented
+		[[nodiscard]] VkImageLayout GetFinalLayout() const
+		{
+			return IsOffscreen() ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		}
+
 		[[nodiscard]] const std::vector<VkImage>& GetImage() const
 		{
 			return images;
@@ -54,9 +67,10 @@ namespace Vulkan
 
 		std::vector<VkImage> images;
 		std::vector<std::unique_ptr<class ImageView>> imageViews;
-		VkSwapchainKHR swapChain;
+		std::vector<std::unique_ptr<class Image>> offscreenImages;
+		VkSwapchainKHR swapChain{};
 		const class Device& device;
-		const class Surface& surface;
+		const class Surface* surface{};
 
 	public:
 		VkPresentModeKHR PresentMode{};
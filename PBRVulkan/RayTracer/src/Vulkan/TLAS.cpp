@@ -35,9 +35,9 @@ namespace Vulkan
 
 	void TLAS::Generate(
 		VkCommandBuffer commandBuffer,
-		class Buffer& topScratchBuffer,
+		const class Buffer& topScratchBuffer,
 		VkDeviceSize scratchOffset,
-		class Buffer& topBuffer,
+		const class Buffer& topBuffer,
 		VkDeviceSize topOffset)
 	{
 		VkAccelerationStructureCreateInfoKHR createInfo = {};
@@ -68,7 +68,9 @@ namespace Vulkan
 	VkAccelerationStructureInstanceKHR TLAS::CreateInstance(
 		const BLAS& blas,
 		const glm::mat4& transform,
-		uint32_t instanceId)
+		uint32_t instanceId,
+		uint32_t mask,
+		uint32_t hitGroupOffset)
 	{
 		const auto& device = blas.GetDevice();
 		const auto& extenstion = blas.GetExtensions();
@@ -85,8 +87,8 @@ namespace Vulkan
 
 		std::memcpy(&geometryInstance.transform, &transform, sizeof(glm::mat4));
 		geometryInstance.instanceCustomIndex = instanceId;
-		geometryInstance.mask = 0xFF;
-		geometryInstance.instanceShaderBindingTableRecordOffset = 0;
+		geometryInstance.mask = mask;
+		geometryInstance.instanceShaderBindingTableRecordOffset = hitGroupOffset;
 		geometryInstance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
 		geometryInstance.accelerationStructureReference = address;
 
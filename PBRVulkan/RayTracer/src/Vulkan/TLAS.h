@@ -13,6 +13,10 @@ namespace Vulkan
 	class TLAS final : public AccelerationStructure
 	{
 	public:
+		// Instance masks, shadow rays are traced only against the geometry
+		static constexpr uint32_t GEOMETRY_MASK = 0x01;
+		static constexpr uint32_t LIGHTS_MASK = 0x02;
+
 		TLAS(const TLAS&) = delete;
 		TLAS& operator = (const TLAS&) = delete;
 		TLAS& operator = (TLAS&&) = delete;
@@ -21,15 +25,17 @@ namespace Vulkan
 		
 		void Generate(
 			VkCommandBuffer commandBuffer,
-			class Buffer& topScratchBuffer,
+			const class Buffer& topScratchBuffer,
 			VkDeviceSize scratchOffset,
-			class Buffer& topBuffer,
+			const class Buffer& topBuffer,
 			VkDeviceSize topOffset);
 
 		static VkAccelerationStructureInstanceKHR CreateInstance(
 			const class BLAS& blas,
 			const glm::mat4& transform,
-			uint32_t instanceId);
+			uint32_t instanceId,
+			uint32_t mask = 0xFF,
+			uint32_t hitGroupOffset = 0);
 
 	private:
 		uint32_t instancesCount;
@@ -0,0 +1,101 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace Vulkan
+{
+	Telemetry& Telemetry::Get()
+	{
+		static Telemetry telemetry;
+		return telemetry;
+	}
+
+	void Telemetry::Add(MemoryCategory category, uint64_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto& counter = counters[static_cast<size_t>(category)];
+		counter.current += bytes;
+		counter.peak = std::max(counter.peak, counter.current);
+		++counter.count;
+	}
+
+	void Telemetry::Remove(MemoryCategory category, uint64_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto& counter = counters[static_cast<size_t>(category)];
+		counter.current -= std::min(counter.current, bytes);
+		counter.count -= counter.count > 0 ? 1 : 0;
+	}
+
+	Telemetry::Counters Telemetry::GetCounters() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return counters;
+	}
+
+	void Telemetry::Dump(const std::string& path) const
+	{
+		const auto snapshot = GetCounters();
+
+		std::ofstream file(path, std::ofstream::trunc);
+
+		if (!file)
+		{
+			std::cout << "[TELEMETRY] Couldn't open " << path << " for writing" << std::endl;
+			return;
+		}
+
+		uint64_t device = 0;
+		uint64_t host = 0;
+
+		file << "{\n\t\"categories\": {\n";
+
+		for (size_t i = 0; i < CATEGORIES; ++i)
+		{
+			const auto category = static_cast<MemoryCategory>(i);
+			const auto& counter = snapshot[i];
+
+			(IsHost(category) ? host : device) += counter.current;
+
+			file << "\t\t\"" << ToString(category) << "\": { \"host\": " << (IsHost(category) ? "true" : "false")
+				<< ", \"current\": " << counter.current << ", \"peak\": " << counter.peak
+				<< ", \"count\": " << counter.count << " }" << (i + 1 < CATEGORIES ? "," : "") << "\n";
+		}
+
+		file << "\t},\n\t\"device\": " << device << ",\n\t\"host\": " << host << "\n}\n";
+
+		std::cout << "[TELEMETRY] Device " << static_cast<double>(device) / 1000000.0 << " MB, host "
+			<< static_cast<double>(host) / 1000000.0 << " MB, dumped to " << path << std::endl;
+	}
+
+	const char* Telemetry::ToString(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::Geometry: return "Geometry";
+		case MemoryCategory::SceneData: return "SceneData";
+		case MemoryCategory::Textures: return "Textures";
+		case MemoryCategory::HDR: return "HDR";
+		case MemoryCategory::AccelerationStructures: return "AccelerationStructures";
+		case MemoryCategory::Scratch: return "Scratch";
+		case MemoryCategory::Instances: return "Instances";
+		case MemoryCategory::Staging: return "Staging";
+		case MemoryCategory::Uniforms: return "Uniforms";
+		case MemoryCategory::ShaderBindingTable: return "ShaderBindingTable";
+		case MemoryCategory::RenderTargets: return "RenderTargets";
+		case MemoryCategory::Readback: return "Readback";
+		case MemoryCategory::HostMeshes: return "HostMeshes";
+		case MemoryCategory::HostTextures: return "HostTextures";
+		default: return "Other";
+		}
+	}
+
+	bool Telemetry::IsHost(MemoryCategory category)
+	{
+		return category == MemoryCategory::HostMeshes || category == MemoryCategory::HostTextures;
+	}
+}
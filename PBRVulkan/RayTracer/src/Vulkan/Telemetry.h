@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace Vulkan
+{
+	enum class MemoryCategory
+	{
+		Geometry,
+		SceneData,
+		Textures,
+		HDR,
+		AccelerationStructures,
+		Scratch,
+		Instances,
+		Staging,
+		Uniforms,
+		ShaderBindingTable,
+		RenderTargets,
+		Readback,
+		Other,
+		// Host side copies of the assets
+		HostMeshes,
+		HostTextures,
+		Count
+	};
+
+	struct MemoryCounter
+	{
+		uint64_t current;
+		uint64_t peak;
+		uint64_t count;
+	};
+
+	/*
+	 * Process wide registry of the memory owned by the renderer.
+	 * Device memory is tracked by Vulkan::Memory, host copies by the assets which own them.
+	 */
+	class Telemetry final
+	{
+	public:
+		static constexpr size_t CATEGORIES = static_cast<size_t>(MemoryCategory::Count);
+
+		using Counters = std::array<MemoryCounter, CATEGORIES>;
+
+		Telemetry(const Telemetry&) = delete;
+		Telemetry& operator =(const Telemetry&) = delete;
+
+		static Telemetry& Get();
+
+		void Add(MemoryCategory category, uint64_t bytes);
+		void Remove(MemoryCategory category, uint64_t bytes);
+		void Dump(const std::string& path) const;
+
+		[[nodiscard]] Counters GetCounters() const;
+
+		static const char* ToString(MemoryCategory category);
+		static bool IsHost(MemoryCategory category);
+
+	private:
+		Telemetry() = default;
+
+		mutable std::mutex mutex;
+		Counters counters{};
+	};
+}
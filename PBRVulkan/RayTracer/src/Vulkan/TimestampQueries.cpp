@@ -0,0 +1,66 @@
+#include "TimestampQueries.h"
+
+#include <iostream>
+
+#include "Device.h"
+
+namespace Vulkan
+{
+	TimestampQueries::TimestampQueries(const Device& device, uint32_t intervals):
+		device(device), recorded(intervals, false)
+	{
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device.GetPhysical(), &properties);
+
+		if (properties.limits.timestampComputeAndGraphics)
+			timestampPeriod = properties.limits.timestampPeriod;
+		else
+			std::cout << "[TIMESTAMPS] GPU timestamps are not supported by the device." << std::endl;
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = intervals * 2;
+
+		VK_CHECK(vkCreateQueryPool(device.Get(), &queryPoolInfo, nullptr, &queryPool), "Create query pool");
+	}
+
+	TimestampQueries::~TimestampQueries()
+	{
+		if (queryPool != nullptr)
+		{
+			vkDestroyQueryPool(device.Get(), queryPool, nullptr);
+			queryPool = nullptr;
+		}
+	}
+
+	void TimestampQueries::Begin(VkCommandBuffer commandBuffer, uint32_t interval)
+	{
+		vkCmdResetQueryPool(commandBuffer, queryPool, interval * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, interval * 2);
+		recorded[interval] = true;
+	}
+
+	void TimestampQueries::End(VkCommandBuffer commandBuffer, uint32_t interval) const
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, interval * 2 + 1);
+	}
+
+	std::optional<float> TimestampQueries::GetMilliseconds(uint32_t interval)
+	{
+		if (!recorded[interval] || timestampPeriod <= 0.f)
+			return std::nullopt;
+
+		recorded[interval] = false;
+
+		uint64_t timestamps[2]{};
+
+		const auto result = vkGetQueryPoolResults(device.Get(), queryPool, interval * 2, 2, sizeof(timestamps),
+		                                          timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+		if (result != VK_SUCCESS)
+			return std::nullopt;
+
+		return static_cast<float>(timestamps[1] - timestamps[0]) * timestampPeriod * 1e-6f;
+	}
+}
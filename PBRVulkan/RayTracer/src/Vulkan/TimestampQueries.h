@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <optional>
+#include <vector>
+
+namespace Vulkan
+{
+	/*
+	 * Pairs of GPU timestamps which measure intervals of a command buffer.
+	 * An interval can be read once the commands have finished, e.g. after the frame fence was waited on.
+	 */
+	class TimestampQueries final
+	{
+	public:
+		NON_COPIABLE(TimestampQueries)
+
+		TimestampQueries(const class Device& device, uint32_t intervals);
+		~TimestampQueries();
+
+		void Begin(VkCommandBuffer commandBuffer, uint32_t interval);
+		void End(VkCommandBuffer commandBuffer, uint32_t interval) const;
+
+		// Length of the last recorded interval, empty if it has not been recorded or timestamps are not supported
+		[[nodiscard]] std::optional<float> GetMilliseconds(uint32_t interval);
+
+	private:
+		const class Device& device;
+		VkQueryPool queryPool{};
+		float timestampPeriod{};
+		std::vector<bool> recorded;
+	};
+}
@@ -0,0 +1,59 @@
+#include "UniformRing.h"
+
+#include <algorithm>
+#include <string>
+
+#include "Buffer.h"
+#include "Device.h"
+
+namespace Vulkan
+{
+	UniformRing::UniformRing(const Device& device, uint32_t regions, VkDeviceSize regionSize): regions(regions)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device.GetPhysical(), &properties);
+
+		alignment = std::max(properties.limits.minUniformBufferOffsetAlignment,
+		                     properties.limits.minStorageBufferOffsetAlignment);
+
+		// Regions are bound as descriptor offsets, hence they have to start at an aligned offset
+		this->regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+		const auto usage = static_cast<VkBufferUsageFlagBits>(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+		buffer.reset(new Buffer(device, this->regionSize * regions, usage,
+		                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                        MemoryCategory::Uniforms));
+
+		mapped = static_cast<uint8_t*>(buffer->Map(0, this->regionSize * regions));
+
+		BeginFrame(0);
+	}
+
+	UniformRing::~UniformRing()
+	{
+		buffer->Unmap();
+	}
+
+	void UniformRing::BeginFrame(uint32_t region)
+	{
+		if (region >= regions)
+			throw std::runtime_error("Uniform ring region " + std::to_string(region) + " is out of range!");
+
+		head = GetRegionOffset(region);
+		end = head + regionSize;
+	}
+
+	RingSlice UniformRing::Allocate(VkDeviceSize size)
+	{
+		const VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+
+		if (offset + size > end)
+			throw std::runtime_error("Uniform ring region is out of memory!");
+
+		head = offset + size;
+
+		return { offset, size, mapped + offset };
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <cstring>
+#include <memory>
+
+namespace Vulkan
+{
+	struct RingSlice
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		void* data;
+	};
+
+	/*
+	 * Host visible buffer which is mapped once and split into one region per frame in flight.
+	 * Every frame rewinds its own region and sub-allocates uniforms and small uploads with a bump pointer,
+	 * thus the first push after BeginFrame() always lands at GetRegionOffset() of that frame.
+	 */
+	class UniformRing final
+	{
+	public:
+		NON_COPIABLE(UniformRing)
+
+		static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 64 * 1024;
+
+		UniformRing(const class Device& device, uint32_t regions, VkDeviceSize regionSize = DEFAULT_REGION_SIZE);
+		~UniformRing();
+
+		// The region must not be read by the GPU anymore, i.e. the fence of its frame has been waited on
+		void BeginFrame(uint32_t region);
+
+		[[nodiscard]] RingSlice Allocate(VkDeviceSize size);
+
+		template <typename T>
+		RingSlice Push(const T& data)
+		{
+			const RingSlice slice = Allocate(sizeof(T));
+			memcpy(slice.data, &data, sizeof(T));
+			return slice;
+		}
+
+		[[nodiscard]] const class Buffer& GetBuffer() const
+		{
+			return *buffer;
+		}
+
+		[[nodiscard]] VkDeviceSize GetRegionOffset(uint32_t region) const
+		{
+			return regionSize * region;
+		}
+
+		[[nodiscard]] VkDeviceSize GetRegionSize() const
+		{
+			return regionSize;
+		}
+
+		[[nodiscard]] uint32_t GetRegions() const
+		{
+			return regions;
+		}
+
+	private:
+		const uint32_t regions;
+		VkDeviceSize alignment{};
+		VkDeviceSize regionSize{};
+		VkDeviceSize head{};
+		VkDeviceSize end{};
+		uint8_t* mapped{};
+
+		std::unique_ptr<Buffer> buffer;
+	};
+}
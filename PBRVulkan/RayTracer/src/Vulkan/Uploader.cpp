@@ -0,0 +1,247 @@
+#include "Uploader.h"
+
+#include <iostream>
+
+#include "Buffer.h"
+#include "CommandPool.h"
+#include "Device.h"
+#include "Image.h"
+#include "Semaphore.h"
+
+namespace Vulkan
+{
+	void UploadFuture::Wait() const
+	{
+		if (timeline)
+			timeline->Wait(value);
+	}
+
+	bool UploadFuture::IsReady() const
+	{
+		return !timeline || timeline->GetValue() >= value;
+	}
+
+	Uploader::Uploader(const Device& device):
+		device(device),
+		dedicated(device.TransferQueue != nullptr && device.TransferFamilyIndex != device.GraphicsFamilyIndex),
+		transferFamily(dedicated ? device.TransferFamilyIndex : device.GraphicsFamilyIndex),
+		graphicsFamily(device.GraphicsFamilyIndex)
+	{
+		transferPool.reset(new CommandPool(device, transferFamily));
+		graphicsPool.reset(new CommandPool(device, graphicsFamily));
+		timeline.reset(new TimelineSemaphore(device));
+
+		std::cout << "[UPLOADER] Uploads use the " << (dedicated ? "dedicated transfer" : "graphics") <<
+			" queue family " << transferFamily << "." << std::endl;
+	}
+
+	Uploader::~Uploader()
+	{
+		WaitIdle();
+	}
+
+	UploadFuture Uploader::Upload(const Buffer& buffer, const void* data, VkDeviceSize size)
+	{
+		std::unique_ptr<Buffer> staging(new Buffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                                           MemoryCategory::Staging));
+		staging->Fill(data);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = dedicated ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = dedicated ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer.Get();
+		barrier.offset = 0;
+		barrier.size = size;
+
+		const VkBuffer src = staging->Get();
+
+		auto transfer = [&](VkCommandBuffer commandBuffer)
+		{
+			VkBufferCopy copyRegion = {};
+			copyRegion.size = size;
+
+			vkCmdCopyBuffer(commandBuffer, src, buffer.Get(), 1, &copyRegion);
+
+			// Release the ownership, the destination access mask is ignored by the releasing queue
+			VkBufferMemoryBarrier release = barrier;
+			release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			release.dstAccessMask = dedicated ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			                     dedicated ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			                     0, 0, nullptr, 1, &release, 0, nullptr);
+		};
+
+		auto acquire = [&](VkCommandBuffer commandBuffer)
+		{
+			VkBufferMemoryBarrier acquire = barrier;
+			acquire.srcAccessMask = 0;
+			acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &acquire, 0, nullptr);
+		};
+
+		return Submit(std::move(staging), transfer, acquire);
+	}
+
+	UploadFuture Uploader::Upload(const Image& image, const void* data, VkDeviceSize size, VkImageLayout layout)
+	{
+		std::unique_ptr<Buffer> staging(new Buffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                                           MemoryCategory::Staging));
+		staging->Fill(data);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = dedicated ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = dedicated ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image.Get();
+		barrier.subresourceRange = Image::GetSubresourceRange();
+
+		const VkBuffer src = staging->Get();
+		const VkExtent2D extent = image.GetExtent();
+
+		auto transfer = [&](VkCommandBuffer commandBuffer)
+		{
+			Image::MemoryBarrier(commandBuffer, image.Get(), barrier.subresourceRange, 0,
+			                     VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+			                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			                     VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { extent.width, extent.height, 1 };
+
+			vkCmdCopyBufferToImage(commandBuffer, src, image.Get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+			// The layout transition is performed once, as a part of the queue family ownership transfer
+			VkImageMemoryBarrier release = barrier;
+			release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			release.dstAccessMask = dedicated ? 0 : VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			                     dedicated ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			                     0, 0, nullptr, 0, nullptr, 1, &release);
+		};
+
+		auto acquire = [&](VkCommandBuffer commandBuffer)
+		{
+			VkImageMemoryBarrier acquire = barrier;
+			acquire.srcAccessMask = 0;
+			acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &acquire);
+		};
+
+		return Submit(std::move(staging), transfer, acquire);
+	}
+
+	UploadFuture Uploader::Submit(std::unique_ptr<Buffer> staging, const Recorder& transfer, const Recorder& acquire)
+	{
+		Collect();
+
+		Pending upload{};
+		upload.staging = std::move(staging);
+
+		upload.transfer = Begin(*transferPool);
+		transfer(upload.transfer);
+		End(dedicated ? device.TransferQueue : device.GraphicsQueue, upload.transfer, 0, 0, ++value);
+
+		if (dedicated)
+		{
+			// The acquire waits on the GPU only, the host never blocks here
+			upload.acquire = Begin(*graphicsPool);
+			acquire(upload.acquire);
+			End(device.GraphicsQueue, upload.acquire, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, value, value + 1);
+			++value;
+		}
+
+		upload.value = value;
+		pending.push_back(std::move(upload));
+
+		return { timeline.get(), value };
+	}
+
+	void Uploader::Collect()
+	{
+		if (pending.empty())
+			return;
+
+		const uint64_t completed = timeline->GetValue();
+
+		while (!pending.empty() && pending.front().value <= completed)
+		{
+			auto& upload = pending.front();
+
+			vkFreeCommandBuffers(device.Get(), transferPool->Get(), 1, &upload.transfer);
+
+			if (upload.acquire != nullptr)
+				vkFreeCommandBuffers(device.Get(), graphicsPool->Get(), 1, &upload.acquire);
+
+			pending.pop_front();
+		}
+	}
+
+	void Uploader::WaitIdle()
+	{
+		timeline->Wait(value);
+		Collect();
+	}
+
+	VkCommandBuffer Uploader::Begin(const CommandPool& commandPool) const
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool.Get();
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		VK_CHECK(vkAllocateCommandBuffers(device.Get(), &allocInfo, &commandBuffer), "Allocate upload command buffer");
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo), "Begin upload command buffer");
+
+		return commandBuffer;
+	}
+
+	void Uploader::End(VkQueue queue, VkCommandBuffer commandBuffer, VkPipelineStageFlags waitStage, uint64_t wait,
+	                   uint64_t signal) const
+	{
+		VK_CHECK(vkEndCommandBuffer(commandBuffer), "End upload command buffer");
+
+		VkSemaphore semaphore = timeline->Get();
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = waitStage ? 1 : 0;
+		timelineInfo.pWaitSemaphoreValues = &wait;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signal;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waitStage ? 1 : 0;
+		submitInfo.pWaitSemaphores = &semaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &semaphore;
+
+		VK_CHECK(vkQueueSubmit(queue, 1, &submitInfo, nullptr), "Submit upload");
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Vulkan_api.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace Vulkan
+{
+	/*
+	 * Handle of an upload in flight. The upload is finished when the timeline reaches the value.
+	 * A default constructed future is always ready.
+	 */
+	class UploadFuture final
+	{
+	public:
+		UploadFuture() = default;
+
+		void Wait() const;
+
+		[[nodiscard]] bool IsReady() const;
+
+		[[nodiscard]] uint64_t GetValue() const
+		{
+			return value;
+		}
+
+	private:
+		friend class Uploader;
+
+		UploadFuture(const class TimelineSemaphore* timeline, uint64_t value): timeline(timeline), value(value) { }
+
+		const TimelineSemaphore* timeline{};
+		uint64_t value{};
+	};
+
+	/*
+	 * Streams data into device local buffers and images without stalling the CPU.
+	 * Copies run on the dedicated transfer queue family when the device exposes one, the ownership is then
+	 * released to the graphics family and acquired by a graphics submission which waits on the timeline semaphore.
+	 * Since the acquire is submitted to the graphics queue, later graphics work is ordered after it.
+	 * Uploads have to be issued from the thread which submits to the graphics queue.
+	 */
+	class Uploader final
+	{
+	public:
+		NON_COPIABLE(Uploader)
+
+		explicit Uploader(const class Device& device);
+		~Uploader();
+
+		UploadFuture Upload(const class Buffer& buffer, const void* data, VkDeviceSize size);
+		UploadFuture Upload(const class Image& image, const void* data, VkDeviceSize size, VkImageLayout layout);
+
+		// Releases staging buffers and command buffers of finished uploads
+		void Collect();
+		void WaitIdle();
+
+		[[nodiscard]] bool IsDedicated() const
+		{
+			return dedicated;
+		}
+
+	private:
+		struct Pending
+		{
+			uint64_t value;
+			VkCommandBuffer transfer;
+			VkCommandBuffer acquire;
+			std::unique_ptr<Buffer> staging;
+		};
+
+		using Recorder = std::function<void(VkCommandBuffer)>;
+
+		UploadFuture Submit(std::unique_ptr<Buffer> staging, const Recorder& transfer, const Recorder& acquire);
+		VkCommandBuffer Begin(const class CommandPool& commandPool) const;
+		void End(VkQueue queue, VkCommandBuffer commandBuffer, VkPipelineStageFlags waitStage, uint64_t wait,
+		         uint64_t signal) const;
+
+		const Device& device;
+		const bool dedicated;
+		const uint32_t transferFamily;
+		const uint32_t graphicsFamily;
+
+		std::unique_ptr<CommandPool> transferPool;
+		std::unique_ptr<CommandPool> graphicsPool;
+		std::unique_ptr<TimelineSemaphore> timeline;
+
+		uint64_t value{};
+		std::deque<Pending> pending;
+	};
+}
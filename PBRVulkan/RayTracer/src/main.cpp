@@ -1,8 +1,29 @@
 #include "Tracer/Application.h"
+#include "Tracer/Coordinator.h"
+#include "Tracer/Options.h"
 
-int main()
+#include <iostream>
+
+int main(int argc, char* argv[])
 {
-	Tracer::Application application;
+	try
+	{
+		const auto options = Tracer::Options::Parse(argc, argv);
+
+		// The coordinator only splits and merges the render, it does not need a device
+		if (!options.CoordinatorPath.empty())
+		{
+			Tracer::Coordinator(options).Run();
+			return 0;
+		}
+
+		Tracer::Application application(options);
 
-	application.Run();
+		application.Run();
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "[ERROR] " << exception.what() << std::endl;
+		return 1;
+	}
 }
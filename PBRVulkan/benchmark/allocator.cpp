@@ -0,0 +1,159 @@
+/*
+ * Stress benchmark of the device memory sub-allocator.
+ * Replays random scene-like workloads (many textures and buffers, scene switches and streaming churn)
+ * on the block placement used by Vulkan::Allocator without touching a GPU.
+ *
+ * Usage: allocator_benchmark [resources] [iterations] [seed]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../RayTracer/src/Vulkan/BlockList.h"
+
+namespace
+{
+	using Vulkan::BlockList;
+
+	struct Resource
+	{
+		uint64_t size;
+		uint64_t alignment;
+		BlockList::Placement placement;
+	};
+
+	// Device memory is left out, the placement is the one of Vulkan::Allocator
+	class Blocks
+	{
+	public:
+		void Allocate(Resource& resource)
+		{
+			if (BlockList::IsDedicated(resource.size))
+			{
+				resource.placement = {};
+				dedicated++;
+				return;
+			}
+
+			resource.placement = blockList.Allocate(resource.size, resource.alignment);
+
+			if (resource.placement.block != BlockList::INVALID)
+				return;
+
+			resource.placement = blockList.AllocateBlock(resource.size, resource.alignment);
+			peakBlocks = std::max(peakBlocks, blockList.GetBlocks());
+		}
+
+		void Free(const Resource& resource)
+		{
+			if (resource.placement.block == BlockList::INVALID)
+			{
+				dedicated--;
+				return;
+			}
+
+			if (blockList.Free(resource.placement, resource.size))
+				blockList.Release(resource.placement.block);
+		}
+
+		[[nodiscard]] double Utilization() const
+		{
+			const auto reserved = static_cast<double>(blockList.GetBlocks()) * BlockList::BLOCK_SIZE;
+
+			return reserved == 0.0 ? 1.0 : static_cast<double>(blockList.GetUsed()) / reserved;
+		}
+
+		BlockList blockList;
+		uint32_t peakBlocks{};
+		size_t dedicated{};
+	};
+
+	Resource RandomResource(std::mt19937_64& rng)
+	{
+		std::uniform_int_distribution<int> kind(0, 9);
+		std::uniform_int_distribution<int> exponent(10, 22);
+
+		Resource resource{};
+
+		// Mostly textures (64 KB aligned), some vertex, index and uniform buffers (256 B aligned)
+		if (kind(rng) < 7)
+		{
+			resource.size = (1ull << exponent(rng)) * 4 / 3;
+			resource.alignment = 64 * 1024;
+		}
+		else
+		{
+			resource.size = std::uniform_int_distribution<uint64_t>(256, 4ull * 1024 * 1024)(rng);
+			resource.alignment = 256;
+		}
+
+		return resource;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t count = argc > 1 ? std::stoul(argv[1]) : 20000;
+	const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 10;
+	const uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 42;
+
+	std::mt19937_64 rng(seed);
+	Blocks blocks;
+	std::vector<Resource> resources;
+	resources.reserve(count);
+
+	size_t operations = 0;
+	double worstUtilization = 1.0;
+
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	for (size_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		// Scene load
+		while (resources.size() < count)
+		{
+			resources.push_back(RandomResource(rng));
+			blocks.Allocate(resources.back());
+			operations++;
+		}
+
+		// Streaming churn, half of the resources are replaced in random order
+		std::shuffle(resources.begin(), resources.end(), rng);
+
+		for (size_t i = 0; i < count / 2; ++i)
+		{
+			blocks.Free(resources[i]);
+			resources[i] = RandomResource(rng);
+			blocks.Allocate(resources[i]);
+			operations += 2;
+		}
+
+		worstUtilization = std::min(worstUtilization, blocks.Utilization());
+
+		// Scene switch
+		for (const auto& resource : resources)
+		{
+			blocks.Free(resource);
+			operations++;
+		}
+
+		resources.clear();
+	}
+
+	const auto stop = std::chrono::high_resolution_clock::now();
+	const auto duration = std::chrono::duration<double, std::micro>(stop - start).count();
+
+	std::cout << "[BENCHMARK] " << operations << " operations in " << duration / 1000.0 << " ms ("
+		<< duration * 1000.0 / operations << " ns per operation)" << std::endl;
+	std::cout << "[BENCHMARK] Peak device allocations: " << blocks.peakBlocks << " blocks instead of "
+		<< count << " (one per resource)" << std::endl;
+	std::cout << "[BENCHMARK] Worst block utilization: " << worstUtilization * 100.0 << " %" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,617 @@
+#include "Image.h"
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Differ
+{
+	namespace
+	{
+		/*
+		 * Read-only mapping of a whole file, the pages are read by the threads which decode them.
+		 */
+		class MappedFile
+		{
+		public:
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			explicit MappedFile(const std::string& path)
+			{
+#ifdef _WIN32
+				file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				                   FILE_ATTRIBUTE_NORMAL, nullptr);
+
+				if (file == INVALID_HANDLE_VALUE)
+					throw std::runtime_error("Failed to open " + path);
+
+				LARGE_INTEGER fileSize{};
+				GetFileSizeEx(file, &fileSize);
+				size = static_cast<size_t>(fileSize.QuadPart);
+
+				if (size > 0)
+					mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+				if (mapping)
+					data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+				descriptor = open(path.c_str(), O_RDONLY);
+
+				if (descriptor < 0)
+					throw std::runtime_error("Failed to open " + path);
+
+				struct stat status{};
+				fstat(descriptor, &status);
+				size = static_cast<size_t>(status.st_size);
+
+				if (size > 0)
+				{
+					void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+					if (address != MAP_FAILED)
+					{
+						// The rows are decoded at once, thus the whole file is about to be read
+						madvise(address, size, MADV_WILLNEED);
+						data = static_cast<const uint8_t*>(address);
+					}
+				}
+#endif
+				if (!data)
+				{
+					Close();
+					throw std::runtime_error("Failed to map " + path + (size == 0 ? ", the file is empty" : ""));
+				}
+			}
+
+			~MappedFile()
+			{
+				Close();
+			}
+
+			[[nodiscard]] const uint8_t* Data() const
+			{
+				return data;
+			}
+
+			[[nodiscard]] size_t Size() const
+			{
+				return size;
+			}
+
+		private:
+			void Close()
+			{
+#ifdef _WIN32
+				if (data) UnmapViewOfFile(data);
+				if (mapping) CloseHandle(mapping);
+				if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+				if (data) munmap(const_cast<uint8_t*>(data), size);
+				if (descriptor >= 0) close(descriptor);
+#endif
+			}
+
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+#ifdef _WIN32
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = nullptr;
+#else
+			int descriptor = -1;
+#endif
+		};
+
+		// The byte order of the file is explicit, thus the loaders do not depend on the host
+		uint32_t LoadU32(const uint8_t* bytes, bool littleEndian)
+		{
+			return littleEndian
+				       ? bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24
+				       : bytes[3] | bytes[2] << 8 | bytes[1] << 16 | static_cast<uint32_t>(bytes[0]) << 24;
+		}
+
+		float LoadF32(const uint8_t* bytes, bool littleEndian)
+		{
+			const uint32_t bits = LoadU32(bytes, littleEndian);
+
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		float HalfToFloat(uint16_t half)
+		{
+			const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+			const uint32_t exponent = half >> 10 & 0x1fu;
+			uint32_t mantissa = half & 0x3ffu;
+			uint32_t bits;
+
+			if (exponent == 0 && mantissa == 0)
+				bits = sign;
+			else if (exponent == 0)
+			{
+				// Subnormal halves are normal floats
+				int shifts = -1;
+
+				do
+				{
+					++shifts;
+					mantissa <<= 1;
+				}
+				while (!(mantissa & 0x400u));
+
+				bits = sign | static_cast<uint32_t>(112 - shifts) << 23 | (mantissa & 0x3ffu) << 13;
+			}
+			else if (exponent == 31)
+				bits = sign | 0x7f800000u | mantissa << 13;
+			else
+				bits = sign | (exponent + 112) << 23 | mantissa << 13;
+
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		/*
+		 * Bounds checked parsing of the headers, the pixel data is checked once as a whole.
+		 */
+		class Reader
+		{
+		public:
+			Reader(const MappedFile& file, const std::string& path): file(file), path(path) { }
+
+			void Need(size_t bytes) const
+			{
+				if (bytes > file.Size() - offset)
+					throw std::runtime_error(path + " is truncated");
+			}
+
+			void Seek(uint64_t position)
+			{
+				if (position > file.Size())
+					throw std::runtime_error(path + " is truncated");
+
+				offset = static_cast<size_t>(position);
+			}
+
+			[[nodiscard]] const uint8_t* Current() const
+			{
+				return file.Data() + offset;
+			}
+
+			[[nodiscard]] size_t Offset() const
+			{
+				return offset;
+			}
+
+			void Skip(size_t bytes)
+			{
+				Need(bytes);
+				offset += bytes;
+			}
+
+			uint8_t U8()
+			{
+				Need(1);
+				return file.Data()[offset++];
+			}
+
+			uint32_t U32()
+			{
+				Need(4);
+				const uint32_t value = LoadU32(Current(), true);
+				offset += 4;
+				return value;
+			}
+
+			int32_t I32()
+			{
+				return static_cast<int32_t>(U32());
+			}
+
+			uint64_t U64()
+			{
+				const uint64_t low = U32();
+				return low | static_cast<uint64_t>(U32()) << 32;
+			}
+
+			std::string String()
+			{
+				const auto* begin = reinterpret_cast<const char*>(Current());
+				const auto* end = static_cast<const char*>(std::memchr(begin, '\0', file.Size() - offset));
+
+				if (!end)
+					throw std::runtime_error(path + " is truncated");
+
+				offset += end - begin + 1;
+				return { begin, end };
+			}
+
+			// Netpbm header field, comments run from # to the end of the line
+			std::string Token()
+			{
+				while (offset < file.Size())
+				{
+					const char c = static_cast<char>(file.Data()[offset]);
+
+					if (c == '#')
+					{
+						while (offset < file.Size() && file.Data()[offset] != '\n')
+							++offset;
+					}
+					else if (std::isspace(static_cast<unsigned char>(c)))
+						++offset;
+					else
+						break;
+				}
+
+				const size_t begin = offset;
+
+				while (offset < file.Size() && !std::isspace(file.Data()[offset]))
+					++offset;
+
+				if (begin == offset)
+					throw std::runtime_error(path + " has an incomplete header");
+
+				return { reinterpret_cast<const char*>(file.Data()) + begin, offset - begin };
+			}
+
+			// The single whitespace character which separates the header from the pixels
+			void EndHeader()
+			{
+				if (!std::isspace(U8()))
+					throw std::runtime_error(path + " has an invalid header");
+			}
+
+			uint32_t Dimension()
+			{
+				const auto token = Token();
+				const auto value = std::strtoul(token.c_str(), nullptr, 10);
+
+				if (value == 0 || value > MAX_DIMENSION)
+					throw std::runtime_error(path + " has an invalid resolution " + token);
+
+				return static_cast<uint32_t>(value);
+			}
+
+			static constexpr unsigned long MAX_DIMENSION = 1u << 16;
+
+		private:
+			const MappedFile& file;
+			const std::string& path;
+			size_t offset = 0;
+		};
+
+		Image Allocate(uint32_t width, uint32_t height, bool linear)
+		{
+			Image image;
+			image.Width = width;
+			image.Height = height;
+			image.Linear = linear;
+			image.Pixels.resize(3 * static_cast<size_t>(width) * height);
+			return image;
+		}
+
+		// P6 holds RGB, P5 grey, the samples above a maximum of 255 take two big endian bytes
+		Image LoadPPM(Reader& reader, const std::string& path, uint32_t threads)
+		{
+			const uint32_t channels = reader.Token() == "P6" ? 3 : 1;
+			const uint32_t width = reader.Dimension();
+			const uint32_t height = reader.Dimension();
+			const auto maximum = std::strtoul(reader.Token().c_str(), nullptr, 10);
+
+			if (maximum == 0 || maximum > 65535)
+				throw std::runtime_error(path + " has an invalid maximum value");
+
+			reader.EndHeader();
+
+			const uint32_t sampleSize = maximum > 255 ? 2 : 1;
+			const size_t rowSize = static_cast<size_t>(width) * channels * sampleSize;
+
+			reader.Need(rowSize * height);
+
+			auto image = Allocate(width, height, false);
+			const uint8_t* pixels = reader.Current();
+			const float scale = 1.f / static_cast<float>(maximum);
+
+			ParallelFor(height, threads, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; ++y)
+				{
+					const uint8_t* source = pixels + y * rowSize;
+					float* destination = &image.Pixels[3 * static_cast<size_t>(y) * width];
+
+					// The common 8-bit RGB rows map one to one
+					if (channels == 3 && sampleSize == 1)
+					{
+						for (uint32_t i = 0; i < 3 * width; ++i)
+							destination[i] = static_cast<float>(source[i]) * scale;
+
+						continue;
+					}
+
+					for (uint32_t x = 0; x < width; ++x)
+					{
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							const uint8_t* sample = source + (x * channels + c % channels) * sampleSize;
+							const uint32_t value = sampleSize == 2 ? sample[0] << 8 | sample[1] : sample[0];
+
+							destination[3 * x + c] = static_cast<float>(value) * scale;
+						}
+					}
+				}
+			});
+
+			return image;
+		}
+
+		// The sign of the scale selects the byte order, the rows are stored from the bottom to the top
+		Image LoadPFM(Reader& reader, const std::string& path, uint32_t threads)
+		{
+			const uint32_t channels = reader.Token() == "PF" ? 3 : 1;
+			const uint32_t width = reader.Dimension();
+			const uint32_t height = reader.Dimension();
+			const float scale = std::strtof(reader.Token().c_str(), nullptr);
+
+			if (scale == 0.f)
+				throw std::runtime_error(path + " has an invalid scale");
+
+			reader.EndHeader();
+
+			const size_t rowSize = sizeof(float) * width * channels;
+			const bool littleEndian = scale < 0.f;
+
+			reader.Need(rowSize * height);
+
+			auto image = Allocate(width, height, true);
+			const uint8_t* pixels = reader.Current();
+
+			ParallelFor(height, threads, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; ++y)
+				{
+					const uint8_t* source = pixels + (height - 1 - y) * rowSize;
+					float* destination = &image.Pixels[3 * static_cast<size_t>(y) * width];
+
+					for (uint32_t x = 0; x < width; ++x)
+					{
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							const auto* sample = source + sizeof(float) * (x * channels + c % channels);
+							destination[3 * x + c] = LoadF32(sample, littleEndian);
+						}
+					}
+				}
+			});
+
+			return image;
+		}
+
+		enum class PixelType : int32_t
+		{
+			Uint = 0,
+			Half = 1,
+			Float = 2
+		};
+
+		struct Channel
+		{
+			std::string Name;
+			PixelType Type;
+			size_t Offset; // Bytes from the start of the scanline
+		};
+
+		/*
+		 * Single part scanline OpenEXR without compression, e.g. written by the renderer.
+		 * Every channel of a scanline is stored as a plane, the planes are sorted by the channel name.
+		 * The offset table locates the scanlines, thus the rows are decoded independently.
+		 */
+		Image LoadEXR(Reader& reader, const std::string& path, uint32_t threads)
+		{
+			reader.Skip(4); // Magic number
+
+			const uint32_t version = reader.U32();
+
+			if ((version & 0xffu) != 2 || version & 0x200u || version & 0x1000u)
+				throw std::runtime_error(path + " is not a single part scanline OpenEXR file");
+
+			std::vector<Channel> channels;
+			int32_t window[4]{};
+			uint8_t compression = 0xff;
+
+			while (true)
+			{
+				const auto name = reader.String();
+
+				if (name.empty())
+					break;
+
+				const auto type = reader.String();
+				const uint32_t size = reader.U32();
+
+				reader.Need(size);
+				const size_t next = reader.Offset() + size;
+
+				if (name == "channels")
+				{
+					while (true)
+					{
+						const auto channel = reader.String();
+
+						if (channel.empty())
+							break;
+
+						const auto pixelType = static_cast<PixelType>(reader.I32());
+						reader.Skip(4); // pLinear and reserved bytes
+
+						if (reader.I32() != 1 || reader.I32() != 1)
+							throw std::runtime_error(path + " has subsampled channels");
+
+						if (pixelType != PixelType::Uint && pixelType != PixelType::Half &&
+							pixelType != PixelType::Float)
+							throw std::runtime_error(path + " has an unknown pixel type");
+
+						channels.push_back({ channel, pixelType, 0 });
+					}
+				}
+				else if (name == "compression")
+					compression = reader.U8();
+				else if (name == "dataWindow")
+				{
+					for (auto& value : window)
+						value = reader.I32();
+				}
+
+				reader.Seek(next);
+			}
+
+			if (compression != 0)
+				throw std::runtime_error(path + " is compressed, only uncompressed OpenEXR files are supported");
+
+			if (window[2] < window[0] || window[3] < window[1])
+				throw std::runtime_error(path + " has an invalid data window");
+
+			const auto width = static_cast<uint32_t>(window[2] - window[0] + 1);
+			const auto height = static_cast<uint32_t>(window[3] - window[1] + 1);
+
+			if (width > Reader::MAX_DIMENSION || height > Reader::MAX_DIMENSION)
+				throw std::runtime_error(path + " has an invalid resolution");
+
+			size_t rowSize = 0;
+
+			for (auto& channel : channels)
+			{
+				channel.Offset = rowSize;
+				rowSize += static_cast<size_t>(width) * (channel.Type == PixelType::Half ? 2 : 4);
+			}
+
+			const auto find = [&](const char* name) -> const Channel*
+			{
+				const auto channel = std::find_if(channels.begin(), channels.end(), [name](const Channel& c)
+				{
+					return c.Name == name;
+				});
+
+				return channel == channels.end() ? nullptr : &*channel;
+			};
+
+			const Channel* rgb[3] = { find("R"), find("G"), find("B") };
+
+			// Grey images repeat the luminance
+			if (!rgb[0] || !rgb[1] || !rgb[2])
+				rgb[0] = rgb[1] = rgb[2] = find("Y");
+
+			if (!rgb[0])
+				throw std::runtime_error(path + " has neither RGB nor Y channels");
+
+			// Every scanline is a chunk of its own, it starts with its y coordinate and its size
+			std::vector<const uint8_t*> rows(height, nullptr);
+
+			for (uint32_t i = 0; i < height; ++i)
+			{
+				const uint64_t chunk = reader.U64();
+				const size_t table = reader.Offset();
+
+				reader.Seek(chunk);
+
+				const int64_t y = static_cast<int64_t>(reader.I32()) - window[1];
+				const uint32_t size = reader.U32();
+
+				if (y < 0 || y >= height || size != rowSize || rows[y])
+					throw std::runtime_error(path + " has an invalid scanline " + std::to_string(y + window[1]));
+
+				reader.Need(rowSize);
+				rows[y] = reader.Current();
+				reader.Seek(table);
+			}
+
+			auto image = Allocate(width, height, true);
+
+			ParallelFor(height, threads, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; ++y)
+				{
+					float* destination = &image.Pixels[3 * static_cast<size_t>(y) * width];
+
+					for (uint32_t c = 0; c < 3; ++c)
+					{
+						const uint8_t* plane = rows[y] + rgb[c]->Offset;
+
+						for (uint32_t x = 0; x < width; ++x)
+						{
+							float value;
+
+							if (rgb[c]->Type == PixelType::Half)
+								value = HalfToFloat(static_cast<uint16_t>(plane[2 * x] | plane[2 * x + 1] << 8));
+							else if (rgb[c]->Type == PixelType::Float)
+								value = LoadF32(plane + 4 * x, true);
+							else
+								value = static_cast<float>(LoadU32(plane + 4 * x, true));
+
+							destination[3 * x + c] = value;
+						}
+					}
+				}
+			});
+
+			return image;
+		}
+	}
+
+	Image Image::Load(const std::string& path, uint32_t threads)
+	{
+		const MappedFile file(path);
+		Reader reader(file, path);
+
+		const uint8_t* magic = file.Data();
+		const size_t size = file.Size();
+
+		if (size >= 4 && LoadU32(magic, true) == 20000630)
+			return LoadEXR(reader, path, threads);
+
+		if (size >= 2 && magic[0] == 'P' && (magic[1] == '6' || magic[1] == '5'))
+			return LoadPPM(reader, path, threads);
+
+		if (size >= 2 && magic[0] == 'P' && (magic[1] == 'F' || magic[1] == 'f'))
+			return LoadPFM(reader, path, threads);
+
+		throw std::runtime_error(path + " is neither a binary PPM, PFM nor OpenEXR file");
+	}
+
+	bool Image::IsSupported(const std::filesystem::path& path)
+	{
+		auto extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+		{
+			return static_cast<char>(std::tolower(c));
+		});
+
+		return extension == ".ppm" || extension == ".pgm" || extension == ".pfm" || extension == ".exr";
+	}
+
+	void WritePPM(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << "P6\n" << width << " " << height << "\n255\n";
+		file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+
+		if (!file)
+			throw std::runtime_error("Failed to write " + path);
+	}
+}
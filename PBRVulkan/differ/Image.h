@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Differ
+{
+	/*
+	 * Three floats per pixel, top row first.
+	 * PPM values are divided by the maximum of the file and stay gamma encoded,
+	 * PFM and EXR values are the linear radiance written by the renderer.
+	 */
+	struct Image
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		bool Linear = false;
+		std::vector<float> Pixels;
+
+		[[nodiscard]] const float* Row(uint32_t y) const
+		{
+			return &Pixels[3 * static_cast<size_t>(y) * Width];
+		}
+
+		/*
+		 * The file is memory mapped and decoded in parallel over rows. The format is detected by its
+		 * magic number: binary PPM (P6, P5), PFM (PF, Pf) or uncompressed scanline OpenEXR.
+		 */
+		static Image Load(const std::string& path, uint32_t threads);
+
+		// .ppm, .pfm or .exr
+		static bool IsSupported(const std::filesystem::path& path);
+	};
+
+	// Eight bits per channel, the whole image is written at once
+	void WritePPM(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb);
+}
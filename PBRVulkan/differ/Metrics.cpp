@@ -0,0 +1,374 @@
+#include "Metrics.h"
+
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace Differ
+{
+	namespace
+	{
+		constexpr uint32_t SSIM_WINDOW = 7;
+		constexpr float SSIM_C1 = 0.01f * 0.01f;
+		constexpr float SSIM_C2 = 0.03f * 0.03f;
+		constexpr float DELTA_E_RANGE = 10.f;
+
+		// Float lanes are added into the double sum after every block, wide rows keep their precision
+		constexpr uint32_t BLOCK = 256;
+
+		struct RowError
+		{
+			double Squared = 0.0;
+			float Max = 0.f;
+			double DeltaE = 0.0;
+			float MaxDeltaE = 0.f;
+		};
+
+		void SquaredError(const float* a, const float* b, uint32_t count, RowError& row)
+		{
+			auto peak = Float4::Zero();
+			uint32_t i = 0;
+
+			while (i + Float4::WIDTH <= count)
+			{
+				auto sum = Float4::Zero();
+				const uint32_t end = std::min(i + BLOCK, count - count % Float4::WIDTH);
+
+				for (; i < end; i += Float4::WIDTH)
+				{
+					const auto difference = Float4::Load(a + i) - Float4::Load(b + i);
+
+					sum = sum + difference * difference;
+					peak = Float4::Max(peak, Float4::Abs(difference));
+				}
+
+				row.Squared += sum.Sum();
+			}
+
+			row.Max = peak.MaxLane();
+
+			for (; i < count; ++i)
+			{
+				const float difference = a[i] - b[i];
+
+				row.Squared += difference * difference;
+				row.Max = std::max(row.Max, std::abs(difference));
+			}
+		}
+
+		void Luminance(const float* rgb, float* luminance, uint32_t width)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+				luminance[x] = 0.2126f * rgb[3 * x] + 0.7152f * rgb[3 * x + 1] + 0.0722f * rgb[3 * x + 2];
+		}
+
+		float ToLinearExact(float value)
+		{
+			return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		// The sRGB curve is interpolated from a table, a pow per channel would dominate the comparison
+		float ToLinear(float value)
+		{
+			constexpr uint32_t SIZE = 4096;
+
+			static const auto table = []()
+			{
+				std::array<float, SIZE + 1> entries{};
+
+				for (uint32_t i = 0; i <= SIZE; ++i)
+					entries[i] = ToLinearExact(static_cast<float>(i) / SIZE);
+
+				return entries;
+			}();
+
+			if (!(value >= 0.f && value < 1.f))
+				return ToLinearExact(value);
+
+			const float position = value * SIZE;
+			const auto index = static_cast<uint32_t>(position);
+			const float weight = position - static_cast<float>(index);
+
+			return table[index] + (table[index + 1] - table[index]) * weight;
+		}
+
+		// Initial guess from the exponent bits refined by two Halley iterations, accurate to the float precision
+		float CubeRoot(float t)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &t, sizeof(bits));
+			bits = bits / 3 + 709921077u;
+
+			float y;
+			std::memcpy(&y, &bits, sizeof(y));
+
+			for (int i = 0; i < 2; ++i)
+			{
+				const float y3 = y * y * y;
+				y *= (y3 + 2.f * t) / (2.f * y3 + t);
+			}
+
+			return y;
+		}
+
+		float LabCurve(float t)
+		{
+			constexpr float DELTA = 6.f / 29.f;
+			return t > DELTA * DELTA * DELTA ? CubeRoot(t) : t / (3.f * DELTA * DELTA) + 4.f / 29.f;
+		}
+
+		// sRGB primaries and the D65 white point
+		std::array<float, 3> ToLab(const float* rgb, bool linear)
+		{
+			float c[3];
+
+			for (int i = 0; i < 3; ++i)
+				c[i] = std::max(linear ? rgb[i] : ToLinear(rgb[i]), 0.f);
+
+			const float x = LabCurve((0.4124f * c[0] + 0.3576f * c[1] + 0.1805f * c[2]) / 0.95047f);
+			const float y = LabCurve(0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2]);
+			const float z = LabCurve((0.0193f * c[0] + 0.1192f * c[1] + 0.9505f * c[2]) / 1.08883f);
+
+			return { 116.f * y - 16.f, 500.f * (x - y), 200.f * (y - z) };
+		}
+
+		// Black through purple, red and yellow to white
+		void HeatMap(float t, uint8_t* rgb)
+		{
+			static constexpr float STOPS[5][3] = {
+				{ 0.f, 0.f, 0.f }, { 0.3f, 0.f, 0.6f }, { 0.9f, 0.1f, 0.2f }, { 1.f, 0.8f, 0.f }, { 1.f, 1.f, 1.f }
+			};
+
+			const float position = std::clamp(t, 0.f, 1.f) * 4.f;
+			const int stop = std::min(static_cast<int>(position), 3);
+			const float weight = position - static_cast<float>(stop);
+
+			for (int c = 0; c < 3; ++c)
+			{
+				const float value = STOPS[stop][c] + (STOPS[stop + 1][c] - STOPS[stop][c]) * weight;
+				rgb[c] = static_cast<uint8_t>(value * 255.f + 0.5f);
+			}
+		}
+
+		void DeltaE(const Image& reference, const Image& test, uint32_t y, RowError& row, uint8_t* map)
+		{
+			const float* a = reference.Row(y);
+			const float* b = test.Row(y);
+
+			for (uint32_t x = 0; x < reference.Width; ++x)
+			{
+				const auto labA = ToLab(a + 3 * x, reference.Linear);
+				const auto labB = ToLab(b + 3 * x, test.Linear);
+
+				const float dL = labA[0] - labB[0];
+				const float da = labA[1] - labB[1];
+				const float db = labA[2] - labB[2];
+				const float distance = std::sqrt(dL * dL + da * da + db * db);
+
+				row.DeltaE += distance;
+				row.MaxDeltaE = std::max(row.MaxDeltaE, distance);
+
+				if (map)
+					HeatMap(distance / DELTA_E_RANGE, map + 3 * x);
+			}
+		}
+
+		/*
+		 * Sums of the windows are built from column sums over the rows of the window, then the column sums
+		 * are added along the row. Both passes and the similarity itself run on four windows at once.
+		 */
+		double StructuralSimilarity(const std::vector<float>& a, const std::vector<float>& b, uint32_t width,
+		                            uint32_t height, uint32_t threads)
+		{
+			const uint32_t window = std::min({ SSIM_WINDOW, width, height });
+			const uint32_t windowsX = width - window + 1;
+			const uint32_t windowsY = height - window + 1;
+			const float area = static_cast<float>(window * window);
+
+			std::vector<double> rows(windowsY);
+
+			ParallelFor(windowsY, threads, [&](uint32_t begin, uint32_t end)
+			{
+				// Sums of a, b, a * a, b * b and a * b
+				std::vector<float> columns[5];
+				std::vector<float> sums[5];
+
+				for (int k = 0; k < 5; ++k)
+				{
+					columns[k].resize(width);
+					sums[k].resize(windowsX);
+				}
+
+				for (uint32_t y = begin; y < end; ++y)
+				{
+					for (auto& column : columns)
+						std::fill(column.begin(), column.end(), 0.f);
+
+					for (uint32_t r = y; r < y + window; ++r)
+					{
+						const float* rowA = &a[static_cast<size_t>(r) * width];
+						const float* rowB = &b[static_cast<size_t>(r) * width];
+						uint32_t x = 0;
+
+						for (; x + Float4::WIDTH <= width; x += Float4::WIDTH)
+						{
+							const auto va = Float4::Load(rowA + x);
+							const auto vb = Float4::Load(rowB + x);
+
+							(Float4::Load(&columns[0][x]) + va).Store(&columns[0][x]);
+							(Float4::Load(&columns[1][x]) + vb).Store(&columns[1][x]);
+							(Float4::Load(&columns[2][x]) + va * va).Store(&columns[2][x]);
+							(Float4::Load(&columns[3][x]) + vb * vb).Store(&columns[3][x]);
+							(Float4::Load(&columns[4][x]) + va * vb).Store(&columns[4][x]);
+						}
+
+						for (; x < width; ++x)
+						{
+							columns[0][x] += rowA[x];
+							columns[1][x] += rowB[x];
+							columns[2][x] += rowA[x] * rowA[x];
+							columns[3][x] += rowB[x] * rowB[x];
+							columns[4][x] += rowA[x] * rowB[x];
+						}
+					}
+
+					for (int k = 0; k < 5; ++k)
+					{
+						uint32_t x = 0;
+
+						for (; x + Float4::WIDTH <= windowsX; x += Float4::WIDTH)
+						{
+							auto sum = Float4::Zero();
+
+							for (uint32_t i = 0; i < window; ++i)
+								sum = sum + Float4::Load(&columns[k][x + i]);
+
+							sum.Store(&sums[k][x]);
+						}
+
+						for (; x < windowsX; ++x)
+						{
+							float sum = 0.f;
+
+							for (uint32_t i = 0; i < window; ++i)
+								sum += columns[k][x + i];
+
+							sums[k][x] = sum;
+						}
+					}
+
+					const auto inverseArea = Float4::Set(1.f / area);
+					const auto two = Float4::Set(2.f);
+					const auto c1 = Float4::Set(SSIM_C1);
+					const auto c2 = Float4::Set(SSIM_C2);
+
+					auto similarity = Float4::Zero();
+					uint32_t x = 0;
+
+					for (; x + Float4::WIDTH <= windowsX; x += Float4::WIDTH)
+					{
+						const auto meanA = Float4::Load(&sums[0][x]) * inverseArea;
+						const auto meanB = Float4::Load(&sums[1][x]) * inverseArea;
+						const auto varianceA = Float4::Load(&sums[2][x]) * inverseArea - meanA * meanA;
+						const auto varianceB = Float4::Load(&sums[3][x]) * inverseArea - meanB * meanB;
+						const auto covariance = Float4::Load(&sums[4][x]) * inverseArea - meanA * meanB;
+
+						similarity = similarity +
+							(two * meanA * meanB + c1) * (two * covariance + c2) /
+							((meanA * meanA + meanB * meanB + c1) * (varianceA + varianceB + c2));
+					}
+
+					double sum = similarity.Sum();
+
+					for (; x < windowsX; ++x)
+					{
+						const float meanA = sums[0][x] / area;
+						const float meanB = sums[1][x] / area;
+						const float varianceA = sums[2][x] / area - meanA * meanA;
+						const float varianceB = sums[3][x] / area - meanB * meanB;
+						const float covariance = sums[4][x] / area - meanA * meanB;
+
+						sum += (2.f * meanA * meanB + SSIM_C1) * (2.f * covariance + SSIM_C2) /
+							((meanA * meanA + meanB * meanB + SSIM_C1) * (varianceA + varianceB + SSIM_C2));
+					}
+
+					rows[y] = sum;
+				}
+			});
+
+			double sum = 0.0;
+
+			for (const double row : rows)
+				sum += row;
+
+			return sum / (static_cast<double>(windowsX) * windowsY);
+		}
+	}
+
+	/*
+	 * Every row is reduced on its own and the rows are added in order,
+	 * thus the metrics do not depend on the number of threads.
+	 */
+	Metrics Compare(const Image& reference, const Image& test, uint32_t threads, std::vector<uint8_t>* errorMap)
+	{
+		if (reference.Width != test.Width || reference.Height != test.Height)
+		{
+			throw std::runtime_error("The resolutions differ: " + std::to_string(reference.Width) + "x" +
+				std::to_string(reference.Height) + " and " + std::to_string(test.Width) + "x" +
+				std::to_string(test.Height));
+		}
+
+		if (reference.Linear != test.Linear)
+			throw std::runtime_error("A linear image cannot be compared with a gamma encoded one");
+
+		const uint32_t width = reference.Width;
+		const uint32_t height = reference.Height;
+		const size_t pixels = static_cast<size_t>(width) * height;
+
+		std::vector<RowError> rows(height);
+		std::vector<float> luminanceA(pixels);
+		std::vector<float> luminanceB(pixels);
+
+		if (errorMap)
+			errorMap->resize(3 * pixels);
+
+		ParallelFor(height, threads, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t y = begin; y < end; ++y)
+			{
+				const size_t offset = static_cast<size_t>(y) * width;
+
+				SquaredError(reference.Row(y), test.Row(y), 3 * width, rows[y]);
+				Luminance(reference.Row(y), &luminanceA[offset], width);
+				Luminance(test.Row(y), &luminanceB[offset], width);
+				DeltaE(reference, test, y, rows[y], errorMap ? &(*errorMap)[3 * offset] : nullptr);
+			}
+		});
+
+		Metrics metrics;
+		double squared = 0.0;
+		double deltaE = 0.0;
+
+		for (const auto& row : rows)
+		{
+			squared += row.Squared;
+			deltaE += row.DeltaE;
+			metrics.MaxError = std::max(metrics.MaxError, row.Max);
+			metrics.MaxDeltaE = std::max(metrics.MaxDeltaE, row.MaxDeltaE);
+		}
+
+		metrics.MSE = squared / (3.0 * static_cast<double>(pixels));
+		metrics.PSNR = metrics.MSE > 0.0 ? -10.0 * std::log10(metrics.MSE) : std::numeric_limits<double>::infinity();
+		metrics.MeanDeltaE = deltaE / static_cast<double>(pixels);
+		metrics.SSIM = StructuralSimilarity(luminanceA, luminanceB, width, height, threads);
+
+		return metrics;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Image.h"
+
+namespace Differ
+{
+	struct Metrics
+	{
+		double MSE = 0.0; // Mean squared error of the channels
+		double PSNR = 0.0; // Decibels relative to a peak of 1, infinite for identical images
+		float MaxError = 0.f; // Largest absolute difference of a channel
+		double SSIM = 1.0; // Mean structural similarity of the luminance over 7x7 windows
+		double MeanDeltaE = 0.0; // Mean CIELAB distance, a distance of about 2.3 is just noticeable
+		float MaxDeltaE = 0.f;
+	};
+
+	/*
+	 * Compares the images in parallel over rows. The error map receives a heat map of the CIELAB distance,
+	 * eight bits per channel, which saturates at a distance of 10.
+	 */
+	Metrics Compare(const Image& reference, const Image& test, uint32_t threads, std::vector<uint8_t>* errorMap);
+}
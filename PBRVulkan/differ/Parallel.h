@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Differ
+{
+	// Rows handed to a thread at once, small enough to balance rows of different cost
+	constexpr uint32_t ROWS_PER_TASK = 16;
+
+	/*
+	 * Calls function(begin, end) for consecutive ranges of rows on the given number of threads.
+	 * The ranges are claimed dynamically, thus the calls must not depend on their order.
+	 * The function must not throw, every input is validated before the rows are processed.
+	 */
+	template <typename Function>
+	void ParallelFor(uint32_t rows, uint32_t threads, const Function& function)
+	{
+		const uint32_t tasks = (rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+		threads = std::clamp(threads, 1u, std::max(tasks, 1u));
+
+		std::atomic<uint32_t> next{ 0 };
+
+		const auto work = [&]()
+		{
+			for (uint32_t begin; (begin = next.fetch_add(ROWS_PER_TASK)) < rows;)
+				function(begin, std::min(begin + ROWS_PER_TASK, rows));
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+
+		for (uint32_t i = 1; i < threads; ++i)
+			workers.emplace_back(work);
+
+		work();
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DIFFER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Differ
+{
+	/*
+	 * Four floats processed at once, SSE2 is part of every x86-64 target thus no compiler flag is needed.
+	 * Other targets fall back to plain loops which the compiler is free to vectorize.
+	 * Kernels process WIDTH elements per step and finish the row with scalar code.
+	 */
+	struct Float4
+	{
+		static constexpr int WIDTH = 4;
+
+#ifdef DIFFER_SSE2
+		__m128 v;
+
+		static Float4 Zero() { return { _mm_setzero_ps() }; }
+		static Float4 Set(float value) { return { _mm_set1_ps(value) }; }
+		static Float4 Load(const float* data) { return { _mm_loadu_ps(data) }; }
+		void Store(float* data) const { _mm_storeu_ps(data, v); }
+
+		Float4 operator+(Float4 other) const { return { _mm_add_ps(v, other.v) }; }
+		Float4 operator-(Float4 other) const { return { _mm_sub_ps(v, other.v) }; }
+		Float4 operator*(Float4 other) const { return { _mm_mul_ps(v, other.v) }; }
+		Float4 operator/(Float4 other) const { return { _mm_div_ps(v, other.v) }; }
+
+		static Float4 Max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+		static Float4 Abs(Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) }; }
+#else
+		float v[WIDTH];
+
+		static Float4 Zero() { return Set(0.f); }
+		static Float4 Set(float value) { return { { value, value, value, value } }; }
+
+		static Float4 Load(const float* data)
+		{
+			Float4 result;
+			std::copy(data, data + WIDTH, result.v);
+			return result;
+		}
+
+		void Store(float* data) const { std::copy(v, v + WIDTH, data); }
+
+		template <typename Operation>
+		static Float4 Apply(Float4 a, Float4 b, Operation operation)
+		{
+			Float4 result;
+			for (int i = 0; i < WIDTH; ++i)
+				result.v[i] = operation(a.v[i], b.v[i]);
+			return result;
+		}
+
+		Float4 operator+(Float4 other) const { return Apply(*this, other, [](float a, float b) { return a + b; }); }
+		Float4 operator-(Float4 other) const { return Apply(*this, other, [](float a, float b) { return a - b; }); }
+		Float4 operator*(Float4 other) const { return Apply(*this, other, [](float a, float b) { return a * b; }); }
+		Float4 operator/(Float4 other) const { return Apply(*this, other, [](float a, float b) { return a / b; }); }
+
+		static Float4 Max(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return std::max(x, y); }); }
+		static Float4 Abs(Float4 a) { return Apply(a, a, [](float x, float) { return std::abs(x); }); }
+#endif
+
+		// Horizontal reductions, only used once per row
+		[[nodiscard]] float Sum() const
+		{
+			float lanes[WIDTH];
+			Store(lanes);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+
+		[[nodiscard]] float MaxLane() const
+		{
+			float lanes[WIDTH];
+			Store(lanes);
+			return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+	};
+}
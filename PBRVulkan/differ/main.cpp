@@ -1,78 +1,232 @@
-#include <fstream>
-#include <stdexcept>
+/*
+ * Image regression tool, compares renders against references.
+ *
+ * Usage: differ <reference> <test> [<error map.ppm>] [options]
+ *        differ <reference directory> <test directory> [<error map directory>] [options]
+ *
+ * Options:
+ *   --threads <n>       Threads decoding and comparing the rows, every core by default
+ *   --max-mse <value>   Thresholds of a passing pair, every given threshold has to be met
+ *   --min-psnr <dB>
+ *   --max-error <value>
+ *   --min-ssim <value>
+ *   --max-delta-e <value>
+ *
+ * The directory mode pairs the images of the reference directory with the images of the same relative
+ * path in the test directory, a missing test image fails. Exits with 0 when every pair passes,
+ * 1 when a threshold has been exceeded and 2 when an image cannot be compared.
+ */
+
 #include <algorithm>
-#include <memory>
-
-struct Color {
-    union {
-        struct {
-            char r;
-            char g;
-            char b;
-        };
-        char data[3];
-    };
-};
-
-char ColorDistance(Color const &a, Color const &b) {
-    return std::abs(a.r - b.r) + std::abs(a.g - b.g) + std::abs(a.b - b.b);
-}
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Image.h"
+#include "Metrics.h"
+
+namespace
+{
+	constexpr int EXIT_PASSED = 0;
+	constexpr int EXIT_EXCEEDED = 1;
+	constexpr int EXIT_INVALID = 2;
+
+	struct Thresholds
+	{
+		std::optional<double> MaxMSE;
+		std::optional<double> MinPSNR;
+		std::optional<double> MaxError;
+		std::optional<double> MinSSIM;
+		std::optional<double> MaxDeltaE;
+	};
+
+	struct Arguments
+	{
+		std::vector<std::string> Paths;
+		uint32_t Threads = std::max(std::thread::hardware_concurrency(), 1u);
+		Thresholds Limits;
+	};
+
+	Arguments Parse(int argc, char* argv[])
+	{
+		Arguments arguments;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string argument = argv[i];
+
+			if (argument.rfind("--", 0) != 0)
+			{
+				arguments.Paths.push_back(argument);
+				continue;
+			}
+
+			if (i + 1 >= argc)
+				throw std::runtime_error("Missing value of " + argument);
+
+			const std::string value = argv[++i];
+			double number;
+
+			try
+			{
+				number = std::stod(value);
+			}
+			catch (const std::exception&)
+			{
+				throw std::runtime_error("Invalid value of " + argument + ": " + value);
+			}
+
+			if (argument == "--threads")
+				arguments.Threads = static_cast<uint32_t>(std::max(number, 1.0));
+			else if (argument == "--max-mse")
+				arguments.Limits.MaxMSE = number;
+			else if (argument == "--min-psnr")
+				arguments.Limits.MinPSNR = number;
+			else if (argument == "--max-error")
+				arguments.Limits.MaxError = number;
+			else if (argument == "--min-ssim")
+				arguments.Limits.MinSSIM = number;
+			else if (argument == "--max-delta-e")
+				arguments.Limits.MaxDeltaE = number;
+			else
+				throw std::runtime_error("Unknown option " + argument);
+		}
+
+		if (arguments.Paths.size() < 2 || arguments.Paths.size() > 3)
+			throw std::runtime_error("Usage: differ <reference> <test> [<error map.ppm>] [options]");
+
+		return arguments;
+	}
+
+	// Names of the exceeded thresholds
+	std::string Exceeded(const Differ::Metrics& metrics, const Thresholds& limits)
+	{
+		std::string exceeded;
+
+		const auto check = [&](bool failed, const char* name)
+		{
+			if (failed)
+				exceeded += exceeded.empty() ? name : std::string(", ") + name;
+		};
+
+		check(limits.MaxMSE && metrics.MSE > *limits.MaxMSE, "mse");
+		check(limits.MinPSNR && metrics.PSNR < *limits.MinPSNR, "psnr");
+		check(limits.MaxError && metrics.MaxError > *limits.MaxError, "max error");
+		check(limits.MinSSIM && metrics.SSIM < *limits.MinSSIM, "ssim");
+		check(limits.MaxDeltaE && metrics.MeanDeltaE > *limits.MaxDeltaE, "delta e");
+
+		return exceeded;
+	}
 
-struct Image {
-    Image(std::string const &filename) {
-        std::ifstream in(filename, std::ios::binary | std::ios::in);
-        std::string header;
-        int depth;
-        in >> header >> width >> height >> depth;
-        data = std::make_unique<Color[]>(width * height);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                in.read(data[y * width + x].data, 3);
-            }
-        }
-    }
-
-    Image(int width, int height)
-        : width(width), height(height)
-    {
-        data = std::make_unique<Color[]>(width * height);
-    }
-
-    void write(std::string const &filename) {
-        std::ofstream o(filename, std::ios::binary | std::ios::out);
-        o << "P6\n" << width << '\n' << height << "\n255\n";
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                o.write(data[y * width + x].data, 3);
-            }
-        }
-    }
-
-    int width = 0;
-    int height = 0;
-    std::unique_ptr<Color[]> data;
-};
-
-Image ImageDiff(Image const &a, Image const &b) {
-    Image res(a.width, a.height);
-    for (int y = 0; y < a.height; ++y) {
-        for (int x = 0; x < a.width; ++x) {
-            auto diff = ColorDistance(a.data[y * a.width + x], b.data[y * a.width + x]);
-            res.data[y * a.width + x] = { diff, diff, diff };
-        }
-    }
-    return res;
+	int ComparePair(const std::string& name, const std::string& reference, const std::string& test,
+	                const std::string& errorMap, const Arguments& arguments)
+	{
+		try
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			const auto a = Differ::Image::Load(reference, arguments.Threads);
+			const auto b = Differ::Image::Load(test, arguments.Threads);
+
+			std::vector<uint8_t> map;
+			const auto metrics = Differ::Compare(a, b, arguments.Threads, errorMap.empty() ? nullptr : &map);
+
+			if (!errorMap.empty())
+			{
+				const auto directory = std::filesystem::path(errorMap).parent_path();
+
+				if (!directory.empty())
+					std::filesystem::create_directories(directory);
+
+				Differ::WritePPM(errorMap, a.Width, a.Height, map);
+			}
+
+			const auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start);
+			const auto exceeded = Exceeded(metrics, arguments.Limits);
+
+			std::printf("%s: MSE %.4g, PSNR %.2f dB, max error %.4g, SSIM %.5f, delta E %.3f (max %.2f), %.1f ms%s%s\n",
+			            name.c_str(), metrics.MSE, metrics.PSNR, metrics.MaxError, metrics.SSIM, metrics.MeanDeltaE,
+			            metrics.MaxDeltaE, ms.count(), exceeded.empty() ? "" : " FAILED: ", exceeded.c_str());
+
+			return exceeded.empty() ? EXIT_PASSED : EXIT_EXCEEDED;
+		}
+		catch (const std::exception& exception)
+		{
+			std::cerr << "[ERROR] " << name << ": " << exception.what() << std::endl;
+			return EXIT_INVALID;
+		}
+	}
+
+	int CompareDirectories(const Arguments& arguments)
+	{
+		const std::filesystem::path references = arguments.Paths[0];
+		const std::filesystem::path tests = arguments.Paths[1];
+		const std::filesystem::path maps = arguments.Paths.size() > 2 ? arguments.Paths[2] : "";
+
+		std::vector<std::filesystem::path> names;
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(references))
+		{
+			if (entry.is_regular_file() && Differ::Image::IsSupported(entry.path()))
+				names.push_back(std::filesystem::relative(entry.path(), references));
+		}
+
+		std::sort(names.begin(), names.end());
+
+		if (names.empty())
+			throw std::runtime_error(references.string() + " has no images");
+
+		uint32_t exceeded = 0;
+		uint32_t invalid = 0;
+
+		for (const auto& name : names)
+		{
+			int result;
+
+			if (!std::filesystem::exists(tests / name))
+			{
+				std::cout << name.string() << ": FAILED: missing in " << tests.string() << std::endl;
+				result = EXIT_EXCEEDED;
+			}
+			else
+			{
+				const auto map = maps.empty() ? "" : (maps / name).replace_extension(".ppm").string();
+				result = ComparePair(name.string(), (references / name).string(), (tests / name).string(), map,
+				                     arguments);
+			}
+
+			exceeded += result == EXIT_EXCEEDED;
+			invalid += result == EXIT_INVALID;
+		}
+
+		std::cout << names.size() << " pairs, " << exceeded << " failed, " << invalid << " invalid" << std::endl;
+
+		return invalid > 0 ? EXIT_INVALID : exceeded > 0 ? EXIT_EXCEEDED : EXIT_PASSED;
+	}
 }
 
-int main(int argc, char *argv[])
+int main(int argc, char* argv[])
 {
-    if (argc != 4) {
-        throw std::runtime_error("Incorrect number of argumets");
-    }
-
-    Image a(argv[1]);
-    Image b(argv[1]);
-    Image diff = ImageDiff(a, b);
-    diff.write(argv[3]);
-    return 0;
+	try
+	{
+		const auto arguments = Parse(argc, argv);
+
+		if (std::filesystem::is_directory(arguments.Paths[0]) && std::filesystem::is_directory(arguments.Paths[1]))
+			return CompareDirectories(arguments);
+
+		const auto& test = arguments.Paths[1];
+		return ComparePair(test, arguments.Paths[0], test, arguments.Paths.size() > 2 ? arguments.Paths[2] : "",
+		                   arguments);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "[ERROR] " << exception.what() << std::endl;
+		return EXIT_INVALID;
+	}
 }